@@ -47,13 +47,18 @@ SYMBOLS += -DDEBUG -DCORE_M4 -D__USE_LPCOPEN -D__LPC43XX__ -D__CODE_RED \
            -DLPC43_MULTICORE_M0APP -D__MULTICORE_MASTER \
 					 -D__MULTICORE_MASTER_SLAVE_M0APP -D__FPU_PRESENT
 
+# Float ABI for the whole image. hard passes float arguments in FPU
+# registers, but every library linked must agree: the prebuilt
+# CMSIS_DSPLIB_CM4 only exists as softfp (see modules/lpc4337_m4/dsp).
+FLOAT_ABI ?= softfp
+
 # Compilation flags
 CFLAGS  += -Wall -ggdb3 -std=c99 -mcpu=cortex-m4 -mthumb -mfpu=fpv4-sp-d16 \
-           -mfloat-abi=softfp -fdata-sections -ffunction-sections
+           -mfloat-abi=$(FLOAT_ABI) -fdata-sections -ffunction-sections
 
 # Linking flags
 LFLAGS  += -nostdlib -fno-builtin -mcpu=cortex-m4 -mthumb -mfpu=fpv4-sp-d16 \
-           -mfloat-abi=softfp -Xlinker -Map=$(OUT_PATH)/firmware.map \
+           -mfloat-abi=$(FLOAT_ABI) -Xlinker -Map=$(OUT_PATH)/firmware.map \
 			  -Wl,--gc-sections
 
 # Linker scripts
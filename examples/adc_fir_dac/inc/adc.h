@@ -10,9 +10,30 @@
 
 #include "board.h"
 
-extern int adcFlag;
+/* Samples per processing block (after decimation) */
+#define ADC_BLOCK_SIZE	64
 
-void adcInit(void);
+#ifdef lpc4337_m4
+/* 88 kHz burst conversions are decimated to 22 kHz */
+#define ADC_DECIMATION	4
+#else
+#define ADC_DECIMATION	1
+#endif
+
+/* Samples per DMA block, at the conversion rate */
+#define ADC_RAW_BLOCK_SIZE	(ADC_BLOCK_SIZE * ADC_DECIMATION)
+
+/* Blocks completed by the DMA before the previous one was read */
+extern volatile uint32_t adcOverruns;
+
+/* Chip_GPDMA_GetFreeChannel() also returns 0 when no channel is free, so a
+   channel it returns that is already running means there was none left */
+#define DMA_CHANNEL_BUSY(ch) \
+	Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_ENABLED_CH, (ch))
+
+int adcInit(void);
+uint32_t adcRate(void);
+int adcBlockRead(int * x);
 
 
 #endif /* ADC_H_ */
@@ -0,0 +1,43 @@
+/*
+ * antialias.h
+ *
+ *  Anti-alias / anti-image stages for 88 kHz <-> 22 kHz conversion.
+ */
+
+#ifndef ANTIALIAS_H_
+#define ANTIALIAS_H_
+
+/*
+
+Kaiser windowed sinc lowpass filters, unity DC gain, 31 bit fixed point.
+Both stages change the rate by 2; with 0 - 8000 Hz kept at 22000 Hz the
+output band of interest stays clear of everything folded onto it.
+
+* Stage 1, 88000 Hz <-> 44000 Hz, 12 taps, beta = 5
+  0 Hz - 8000 Hz: ripple < 0.04 dB
+  36000 Hz - 44000 Hz: attenuation > 56 dB
+
+* Stage 2, 44000 Hz <-> 22000 Hz, 30 taps, beta = 6
+  0 Hz - 8000 Hz: ripple < 0.01 dB
+  14000 Hz - 22000 Hz: attenuation > 62 dB
+
+54 MACs per 22 kHz output, a single 88 kHz stage with the same response
+needs about 60 taps.
+
+*/
+
+#define ANTIALIAS1_TAP_NUM 12
+#define ANTIALIAS2_TAP_NUM 30
+
+extern const int antialias1_taps[];
+extern const int antialias2_taps[];
+
+/* State for both stages decimating block samples at 88 kHz */
+#define ANTIALIAS_DECIMATOR_STATE(block) \
+	(ANTIALIAS1_TAP_NUM + (block) - 1 + ANTIALIAS2_TAP_NUM + (block) / 2 - 1)
+
+/* State for both stages interpolating block samples at 22 kHz */
+#define ANTIALIAS_INTERPOLATOR_STATE(block) \
+	(ANTIALIAS2_TAP_NUM / 2 + (block) - 1 + ANTIALIAS1_TAP_NUM / 2 + 2 * (block) - 1)
+
+#endif /* ANTIALIAS_H_ */
@@ -9,6 +9,8 @@
 #define DAC_H_
 
 void dacInit(void);
+int dacStart(uint32_t rate, int count);
 void dacWrite(uint32_t v);
+void dacWriteBlock(const int * v, int count);
 
 #endif /* DAC_H_ */
@@ -0,0 +1,24 @@
+#ifndef _FIR_BENCH_H_
+#define _FIR_BENCH_H_
+
+#include <stdint.h>
+
+#define FIR_BENCH_SIZES		3
+#define FIR_BENCH_KERNELS	4
+
+/* Tap counts measured: 49, 95 and 255 */
+extern const int firBenchTaps[FIR_BENCH_SIZES];
+
+/* Average DWT cycles per output sample, by tap count and kernel:
+   fir_q31_get, asm_fir_q31_get, asm_fir_fast_q31_get, asm_fir_fast_q15_get */
+extern uint32_t firBenchCycles[FIR_BENCH_SIZES][FIR_BENCH_KERNELS];
+
+/* 1 if the kernel output matched fir_q31_get on the same input, same
+   layout. All must match exactly: the q15 kernel is checked against
+   fir_q31_get with its own taps shifted back to q31, which gives the same
+   sum >> 15. */
+extern uint8_t firBenchOk[FIR_BENCH_SIZES][FIR_BENCH_KERNELS];
+
+void firBenchmark(void);
+
+#endif
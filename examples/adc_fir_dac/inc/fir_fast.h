@@ -0,0 +1,40 @@
+#ifndef _FIR_FAST_H_
+#define _FIR_FAST_H_
+
+/* FIR filters with a mirrored history: every sample is stored twice, N
+   positions apart, so the last N samples are always contiguous and the
+   kernels run without wrap tests.
+
+   history must hold 2 * num_taps samples. q15 kernels must be word aligned;
+   q15 history is read with unaligned word loads. */
+
+typedef struct
+{
+	unsigned int index;
+	int num_taps;
+	const int * kernel;
+	int * history;
+}fir_fast_q31_t;
+
+typedef struct
+{
+	unsigned int index;
+	int num_taps;
+	const short * kernel;
+	short * history;
+}fir_fast_q15_t;
+
+void fir_fast_q31_init(fir_fast_q31_t * f, int * history, const int * kernel, int num_taps);
+void fir_fast_q31_put(fir_fast_q31_t * f, int input);
+void fir_fast_q31_block(fir_fast_q31_t * f, const int * input, int * output, int count);
+
+void fir_fast_q15_init(fir_fast_q15_t * f, short * history, const short * kernel, int num_taps);
+void fir_fast_q15_put(fir_fast_q15_t * f, int input);
+void fir_fast_q15_block(fir_fast_q15_t * f, const int * input, int * output, int count);
+
+/* Four taps per iteration, SMLAL */
+extern int asm_fir_fast_q31_get(fir_fast_q31_t * f);
+/* Eight taps per iteration, SMLALD (two 16 bit MACs) */
+extern int asm_fir_fast_q15_get(fir_fast_q15_t * f);
+
+#endif
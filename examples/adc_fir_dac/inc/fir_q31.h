@@ -12,6 +12,7 @@ typedef struct
 void fir_q31_init(fir_q31_t * f, int * history, const int * kernel, int num_taps);
 void fir_q31_put(fir_q31_t * f, int input);
 int fir_q31_get(fir_q31_t * f);
+void fir_q31_block(fir_q31_t * f, const int * input, int * output, int count);
 
 extern void asm_fir_q31_put(fir_q31_t * f, int input);
 extern int 	asm_fir_q31_get(fir_q31_t * f);
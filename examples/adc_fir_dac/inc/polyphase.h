@@ -0,0 +1,57 @@
+#ifndef _POLYPHASE_H_
+#define _POLYPHASE_H_
+
+#include "arm_math.h"
+
+/* Multi-stage sample rate conversion built on the CMSIS polyphase FIR
+   decimator and interpolator. A decimation stage only computes the outputs
+   it keeps, an interpolation stage skips the zeros it stuffs in, so a chain
+   of short stages costs less than one long filter at the fast rate.
+
+   Stages are listed from the fast rate down for decimators and from the
+   slow rate up for interpolators. Each stage filters at its fast rate and
+   has unity DC gain; as the same tables serve both directions, every
+   interpolation stage attenuates by its factor and the caller folds the
+   total back into its output scaling.
+
+   state must hold, for every stage, num_taps + input block - 1 samples when
+   decimating and num_taps / factor + input block - 1 when interpolating.
+   work must hold one block at the fast rate. */
+
+#define POLYPHASE_MAX_STAGES	4
+
+typedef struct
+{
+	uint8_t factor;
+	uint16_t num_taps;
+	const q31_t * taps;
+}polyphase_stage_t;
+
+typedef struct
+{
+	uint32_t num_stages;
+	uint32_t block_size;	/* input samples at the fast rate */
+	q31_t * work;
+	arm_fir_decimate_instance_q31 stage[POLYPHASE_MAX_STAGES];
+}polyphase_decimator_q31_t;
+
+typedef struct
+{
+	uint32_t num_stages;
+	uint32_t block_size;	/* input samples at the slow rate */
+	uint32_t output_size;
+	q31_t * work;
+	arm_fir_interpolate_instance_q31 stage[POLYPHASE_MAX_STAGES];
+}polyphase_interpolator_q31_t;
+
+arm_status polyphase_decimator_q31_init(polyphase_decimator_q31_t * d,
+		const polyphase_stage_t * stages, uint32_t num_stages,
+		q31_t * state, q31_t * work, uint32_t block_size);
+void polyphase_decimator_q31(polyphase_decimator_q31_t * d, q31_t * input, q31_t * output);
+
+arm_status polyphase_interpolator_q31_init(polyphase_interpolator_q31_t * f,
+		const polyphase_stage_t * stages, uint32_t num_stages,
+		q31_t * state, q31_t * work, uint32_t block_size);
+void polyphase_interpolator_q31(polyphase_interpolator_q31_t * f, q31_t * input, q31_t * output);
+
+#endif
@@ -6,57 +6,117 @@
  */
 
 #include "board.h"
-#include "fir_q31.h"
-#include "main.h"
-
-int adcFlag=0;
+#include "adc.h"
 
 #ifdef lpc4337_m4
 #define LPC_ADC LPC_ADC0
 #define ADC_IRQn ADC0_IRQn
+#define ADC_DMA_CONN GPDMA_CONN_ADC_0
+/* ADC clocks per 10 bit conversion */
+#define ADC_CONV_CLOCKS 11
+#define adcClockRate() Chip_Clock_GetRate(CLK_APB3_ADC0)
+#else
+#define ADC_DMA_CONN GPDMA_CONN_ADC
+#define ADC_CONV_CLOCKS 65
+#define adcClockRate() Chip_Clock_GetPeripheralClockRate(SYSCTL_PCLK_ADC)
 #endif
 
-/* P0.23 -> AD0 */
-void adcInit(void)
+/* Ping-pong buffers: the DMA fills one half while the other is processed */
+static uint32_t adcBuffer[2][ADC_RAW_BLOCK_SIZE];
+static DMA_TransferDescriptor_t adcDesc[2];
+static uint8_t adcChannel;
+static volatile uint32_t * adcBlock;
+static uint32_t adcHalf;
+
+volatile uint32_t adcOverruns;
+
+/* P0.23 -> AD0
+   Returns -1 if no GPDMA channel is free, 0 otherwise */
+int adcInit(void)
 {
 	ADC_CLOCK_SETUP_T adc;
+	DMA_TransferDescriptor_t head;
+	int i;
 
 	Chip_ADC_Init(LPC_ADC, &adc);
 	Chip_ADC_SetSampleRate(LPC_ADC, &adc, 88000);
 
+	/* The channel interrupt flag requests the DMA, no ADC IRQ is used */
 	Chip_ADC_EnableChannel(LPC_ADC, ADC_CH1, ENABLE);
 	Chip_ADC_Int_SetChannelCmd(LPC_ADC, ADC_CH1, ENABLE);
+	NVIC_DisableIRQ(ADC_IRQn);
+
+	/* Circular list: each half interrupts once full and links to the other */
+	adcChannel = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, ADC_DMA_CONN);
+	if(DMA_CHANNEL_BUSY(adcChannel))
+	{
+		return -1;
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &adcDesc[i], ADC_DMA_CONN,
+				(uint32_t)adcBuffer[i], ADC_RAW_BLOCK_SIZE,
+				GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA, &adcDesc[!i]);
+		adcDesc[i].ctrl |= GPDMA_DMACCxControl_I;
+	}
+
+	/* Chip_GPDMA_SGTransfer() takes the peripheral connection instead of
+	   its register address from the first descriptor */
+	head = adcDesc[0];
+	head.src = ADC_DMA_CONN;
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, adcChannel, &head,
+			GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA);
+
+	NVIC_EnableIRQ(DMA_IRQn);
 	Chip_ADC_SetBurstCmd(LPC_ADC, ENABLE);
 
-	NVIC_EnableIRQ(ADC_IRQn);
+	return 0;
 }
 
-#ifdef lpc4337_m4
-void ADC0_IRQHandler(void)
-#else
-void ADC_IRQHandler(void)
-#endif
+/* Actual sample rate after decimation */
+uint32_t adcRate(void)
+{
+	uint32_t div = (LPC_ADC->CR >> 8) & 0xFF;
+
+	return adcClockRate() / ((div + 1) * ADC_CONV_CLOCKS * ADC_DECIMATION);
+}
+
+/* Copies the last block completed by the DMA to x as 10 bit samples at the
+   conversion rate, the caller decimates them by ADC_DECIMATION.
+   Returns the number of samples, 0 if no block is ready. */
+int adcBlockRead(int * x)
 {
-	static uint16_t data;
-	Chip_ADC_ReadValue(LPC_ADC, ADC_CH1, &data);
+	volatile uint32_t * block = adcBlock;
+	int i;
+
+	if(!block)
+		return 0;
+
+	adcBlock = 0;
 
+	for(i = 0; i < ADC_RAW_BLOCK_SIZE; i++)
+	{
 #ifdef lpc4337_m4
-	static uint32_t cont;
-	cont++;
-	if (cont == 4) {
-		cont = 0;
-#if(USAR_FUNCIONES_ASSEMBLER)
-		asm_fir_q31_put(&filtro, data);
+		x[i] = ADC_DR_RESULT(block[i]);
 #else
-		fir_q31_put(&filtro, data);
+		x[i] = ADC_DR_RESULT(block[i]) >> 2;
 #endif
 	}
-#else
-#if(USAR_FUNCIONES_ASSEMBLER)
-	asm_fir_q31_put(&filtro, data>>2);
-#else
-	fir_q31_put(&filtro, data>>2);
-#endif
-#endif
-	adcFlag=1;
+
+	return ADC_RAW_BLOCK_SIZE;
+}
+
+void DMA_IRQHandler(void)
+{
+	if(Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INTTC, adcChannel))
+	{
+		Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTTC, adcChannel);
+
+		if(adcBlock)
+			adcOverruns++;
+
+		adcBlock = adcBuffer[adcHalf];
+		adcHalf ^= 1;
+	}
 }
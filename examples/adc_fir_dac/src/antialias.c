@@ -0,0 +1,55 @@
+/*
+ * antialias.c
+ *
+ *  Anti-alias / anti-image stages for 88 kHz <-> 22 kHz conversion.
+ */
+
+#include "antialias.h"
+
+const int antialias1_taps[ANTIALIAS1_TAP_NUM] = {
+		3231482,
+		17428468,
+		-50742960,
+		-119309698,
+		272598397,
+		950536135,
+		950536135,
+		272598397,
+		-119309698,
+		-50742960,
+		17428468,
+		3231482
+};
+
+const int antialias2_taps[ANTIALIAS2_TAP_NUM] = {
+		-495709,
+		1389270,
+		2900916,
+		-5254783,
+		-8718471,
+		13615024,
+		20348747,
+		-29459297,
+		-41735253,
+		58462531,
+		82015380,
+		-117470745,
+		-178103277,
+		312855600,
+		963391891,
+		963391891,
+		312855600,
+		-178103277,
+		-117470745,
+		82015380,
+		58462531,
+		-41735253,
+		-29459297,
+		20348747,
+		13615024,
+		-8718471,
+		-5254783,
+		2900916,
+		1389270,
+		-495709
+};
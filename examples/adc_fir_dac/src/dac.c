@@ -7,17 +7,76 @@
 
 
 #include "board.h"
+#include "adc.h"
+
+#ifdef lpc4337_m4
+#define dacClockRate() Chip_Clock_GetRate(CLK_APB3_DAC)
+#else
+#define dacClockRate() Chip_Clock_GetPeripheralClockRate(SYSCTL_PCLK_DAC)
+#endif
+
+/* Ping-pong output buffers, up to one block at the conversion rate each */
+static uint32_t dacBuffer[2][ADC_RAW_BLOCK_SIZE];
+static DMA_TransferDescriptor_t dacDesc[2];
+static uint8_t dacChannel;
 
 /* P0.26 -> AOUT */
 void dacInit(void)
 {
 	Chip_DAC_Init(LPC_DAC);
-#ifdef lpc4337_m4
-	Chip_DAC_ConfigDAConverterControl(LPC_DAC, DAC_DMA_ENA);
-#endif
+}
+
+/* Streams both output halves of count samples in a loop, one sample per
+   rate period. Returns -1 if no GPDMA channel is free, 0 otherwise */
+int dacStart(uint32_t rate, int count)
+{
+	DMA_TransferDescriptor_t head;
+	int i;
+
+	dacChannel = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_DAC);
+	if(DMA_CHANNEL_BUSY(dacChannel))
+	{
+		return -1;
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &dacDesc[i],
+				(uint32_t)dacBuffer[i], GPDMA_CONN_DAC, count,
+				GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA, &dacDesc[!i]);
+	}
+
+	/* See adcInit() */
+	head = dacDesc[0];
+	head.dst = GPDMA_CONN_DAC;
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, dacChannel, &head,
+			GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA);
+
+	/* The DAC counter requests a DMA transfer on each timeout */
+	Chip_DAC_SetDMATimeOut(LPC_DAC, dacClockRate() / rate);
+	Chip_DAC_ConfigDAConverterControl(LPC_DAC,
+			DAC_DBLBUF_ENA | DAC_CNT_ENA | DAC_DMA_ENA);
+
+	return 0;
 }
 
 void dacWrite(uint32_t v)
 {
 	Chip_DAC_UpdateValue(LPC_DAC, v);
 }
+
+/* Writes count (as given to dacStart()) samples, saturated to 10 bits, to the
+   half to be played next. The DMA link register points to its descriptor.
+   Output and input DMA are paced by different counters; should their phases
+   cross, a single block gets dropped or repeated. */
+void dacWriteBlock(const int * v, int count)
+{
+	uint32_t * out;
+	int i;
+
+	out = (LPC_GPDMA->CH[dacChannel].LLI == (uint32_t)&dacDesc[0])
+			? dacBuffer[0] : dacBuffer[1];
+
+	for(i = 0; i < count; i++)
+		out[i] = DAC_VALUE(__USAT(v[i], 10));
+}
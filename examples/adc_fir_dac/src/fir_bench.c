@@ -0,0 +1,111 @@
+#include "board.h"
+#include "fir_q31.h"
+#include "fir_fast.h"
+#include "fir_bench.h"
+
+#define FIR_BENCH_MAX_TAPS	255
+#define FIR_BENCH_SAMPLES	64
+
+const int firBenchTaps[FIR_BENCH_SIZES] = { 49, 95, 255 };
+
+uint32_t firBenchCycles[FIR_BENCH_SIZES][FIR_BENCH_KERNELS];
+uint8_t firBenchOk[FIR_BENCH_SIZES][FIR_BENCH_KERNELS];
+
+/* Coefficient values do not change cycle counts */
+static int benchKernel[FIR_BENCH_MAX_TAPS];
+static short benchKernel15[FIR_BENCH_MAX_TAPS] __attribute__ ((aligned (4)));
+/* benchKernel15 back in q31, reference for the q15 kernel */
+static int benchKernel15to31[FIR_BENCH_MAX_TAPS];
+static int benchHistory[2 * FIR_BENCH_MAX_TAPS];
+static short benchHistory15[2 * FIR_BENCH_MAX_TAPS];
+/* 16 bit samples, so the q15 kernel sees the same input */
+static int benchInput[FIR_BENCH_SAMPLES];
+static int benchOutput[FIR_BENCH_SAMPLES];
+static int benchReference[FIR_BENCH_SAMPLES];
+
+/* Times one kernel, its output goes to benchOutput */
+static uint32_t benchRun(int kernel, int taps)
+{
+	fir_q31_t f;
+	fir_fast_q31_t f31;
+	fir_fast_q15_t f15;
+	uint32_t start, end, cycles = 0;
+	int i, y;
+
+	fir_q31_init(&f, benchHistory, benchKernel, taps);
+	fir_fast_q31_init(&f31, benchHistory, benchKernel, taps);
+	fir_fast_q15_init(&f15, benchHistory15, benchKernel15, taps);
+
+	for(i = 0; i < FIR_BENCH_SAMPLES; i++)
+	{
+		switch(kernel)
+		{
+		case 0:
+			fir_q31_put(&f, benchInput[i]);
+			start = DWT->CYCCNT;
+			y = fir_q31_get(&f);
+			break;
+		case 1:
+			asm_fir_q31_put(&f, benchInput[i]);
+			start = DWT->CYCCNT;
+			y = asm_fir_q31_get(&f);
+			break;
+		case 2:
+			fir_fast_q31_put(&f31, benchInput[i]);
+			start = DWT->CYCCNT;
+			y = asm_fir_fast_q31_get(&f31);
+			break;
+		default:
+			fir_fast_q15_put(&f15, benchInput[i]);
+			start = DWT->CYCCNT;
+			y = asm_fir_fast_q15_get(&f15);
+			break;
+		}
+		end = DWT->CYCCNT;
+		cycles += end - start;
+		benchOutput[i] = y;
+	}
+
+	return cycles / FIR_BENCH_SAMPLES;
+}
+
+/* Compares benchOutput with fir_q31_get on the same input */
+static uint8_t benchCheck(int kernel, int taps)
+{
+	fir_q31_t f;
+	int i;
+
+	fir_q31_init(&f, benchHistory, kernel == 3 ? benchKernel15to31 : benchKernel, taps);
+	fir_q31_block(&f, benchInput, benchReference, FIR_BENCH_SAMPLES);
+
+	for(i = 0; i < FIR_BENCH_SAMPLES; i++)
+		if(benchOutput[i] != benchReference[i])
+			return 0;
+	return 1;
+}
+
+/* Fills firBenchCycles and firBenchOk, to be read with the debugger */
+void firBenchmark(void)
+{
+	int i, k;
+
+	for(i = 0; i < FIR_BENCH_MAX_TAPS; i++)
+	{
+		benchKernel[i] = (i * 7919 % 2001 - 1000) * 1000000;
+		benchKernel15[i] = benchKernel[i] >> 16;
+		benchKernel15to31[i] = benchKernel15[i] * 65536;
+	}
+
+	for(i = 0; i < FIR_BENCH_SAMPLES; i++)
+		benchInput[i] = i * 40503 % 65536 - 32768;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for(i = 0; i < FIR_BENCH_SIZES; i++)
+		for(k = 0; k < FIR_BENCH_KERNELS; k++)
+		{
+			firBenchCycles[i][k] = benchRun(k, firBenchTaps[i]);
+			firBenchOk[i][k] = benchCheck(k, firBenchTaps[i]);
+		}
+}
@@ -0,0 +1,77 @@
+#include "fir_fast.h"
+
+/* New samples are stored downwards, so that the kernels walk both kernel
+   and history upwards from the newest sample at history[index]. */
+
+void fir_fast_q31_init(fir_fast_q31_t * f, int * history, const int * kernel, int num_taps)
+{
+	int i;
+
+	f->num_taps = num_taps;
+	f->history = history;
+	f->kernel = kernel;
+
+	for(i = 0; i < 2 * f->num_taps; ++i)
+		f->history[i] = 0;
+	f->index = 0;
+}
+
+void fir_fast_q31_put(fir_fast_q31_t * f, int input)
+{
+	f->index = (f->index != 0 ? f->index : f->num_taps) - 1;
+	f->history[f->index] = input;
+	f->history[f->index + f->num_taps] = input;
+}
+
+void fir_fast_q31_block(fir_fast_q31_t * f, const int * input, int * output, int count)
+{
+	int n;
+	for(n = 0; n < count; ++n)
+	{
+		fir_fast_q31_put(f, input[n]);
+		output[n] = asm_fir_fast_q31_get(f);
+	}
+}
+
+void fir_fast_q15_init(fir_fast_q15_t * f, short * history, const short * kernel, int num_taps)
+{
+	int i;
+
+	f->num_taps = num_taps;
+	f->history = history;
+	f->kernel = kernel;
+
+	for(i = 0; i < 2 * f->num_taps; ++i)
+		f->history[i] = 0;
+	f->index = 0;
+}
+
+void fir_fast_q15_put(fir_fast_q15_t * f, int input)
+{
+	f->index = (f->index != 0 ? f->index : f->num_taps) - 1;
+	f->history[f->index] = input;
+	f->history[f->index + f->num_taps] = input;
+}
+
+void fir_fast_q15_block(fir_fast_q15_t * f, const int * input, int * output, int count)
+{
+	int n;
+	for(n = 0; n < count; ++n)
+	{
+		fir_fast_q15_put(f, input[n]);
+		output[n] = asm_fir_fast_q15_get(f);
+	}
+}
+
+#ifndef __ARM_FEATURE_DSP
+/* No dual 16 bit MAC instructions (Cortex-M3) */
+int asm_fir_fast_q15_get(fir_fast_q15_t * f)
+{
+	const short * x = &f->history[f->index];
+	long long acc = 0;
+	int i;
+	for(i = 0; i < f->num_taps; ++i)
+		acc += (long long)x[i] * f->kernel[i];
+	return acc >> 15;
+}
+#endif
@@ -32,4 +32,13 @@ int fir_q31_get(fir_q31_t * f)
 	return acc >> 31;
 }
 
-
+/* Filters count input samples into output, one call per block */
+void fir_q31_block(fir_q31_t * f, const int * input, int * output, int count)
+{
+	int n;
+	for(n = 0; n < count; ++n)
+	{
+		fir_q31_put(f, input[n]);
+		output[n] = fir_q31_get(f);
+	}
+}
@@ -3,26 +3,71 @@
 #include "lowpass.h"
 #include "bandpass.h"
 #include "fir_q31.h"
+#include "fir_fast.h"
+#include "fir_bench.h"
+#if ADC_DECIMATION > 1
+#include "polyphase.h"
+#include "antialias.h"
+#endif
 
 #define FILTRO_PASA_BANDA			1
 #define FILTRO_PASA_BAJOS			(!FILTRO_PASA_BANDA)
 
 #define USAR_FUNCIONES_ASSEMBLER	1
+/* Kernel q31 con historia duplicada, sin wrap en el loop (fir_fast.h) */
+#define USAR_FIR_FAST				1
+/* Mide ciclos por muestra de cada kernel al inicio (fir_bench.h) */
+#define EJECUTAR_BENCHMARK			0
+/* Diezma 88 kHz -> 22 kHz con filtros anti-alias en vez de descartar 3 de
+   cada 4 muestras, y vuelve a 88 kHz antes del DAC (polyphase.h) */
+#define USAR_DECIMADOR_POLIFASE		(ADC_DECIMATION > 1)
+#define USAR_INTERPOLADOR_POLIFASE	(ADC_DECIMATION > 1)
+
+/* Las muestras de 10 bits se escalan a q31 con este corrimiento para no
+   perder resolucion en las etapas del conversor de frecuencia */
+#define ESCALA_POLIFASE				16
 
 volatile uint32_t * DWT_CTRL = (uint32_t *)0xE0001000;
 volatile uint32_t * DWT_CYCCNT = (uint32_t *)0xE0001004;
 
 fir_q31_t filtro;
+fir_fast_q31_t filtroFast;
 
 #if FILTRO_PASA_BANDA
 int history[BANDPASS_TAP_NUM];
+int historyFast[2 * BANDPASS_TAP_NUM];
 #elif FILTRO_PASA_BAJOS
 int history[LOWPASS_TAP_NUM];
+int historyFast[2 * LOWPASS_TAP_NUM];
+#endif
+
+int raw[ADC_RAW_BLOCK_SIZE];
+int x[ADC_BLOCK_SIZE];
+int y[ADC_BLOCK_SIZE];
+
+#if(USAR_DECIMADOR_POLIFASE || USAR_INTERPOLADOR_POLIFASE)
+/* 88 kHz -> 44 kHz -> 22 kHz y de vuelta */
+const polyphase_stage_t etapasDecimador[] = {
+	{2, ANTIALIAS1_TAP_NUM, (const q31_t *)antialias1_taps},
+	{2, ANTIALIAS2_TAP_NUM, (const q31_t *)antialias2_taps},
+};
+const polyphase_stage_t etapasInterpolador[] = {
+	{2, ANTIALIAS2_TAP_NUM, (const q31_t *)antialias2_taps},
+	{2, ANTIALIAS1_TAP_NUM, (const q31_t *)antialias1_taps},
+};
+
+polyphase_decimator_q31_t decimador;
+polyphase_interpolator_q31_t interpolador;
+q31_t estadoDecimador[ANTIALIAS_DECIMATOR_STATE(ADC_RAW_BLOCK_SIZE)];
+q31_t estadoInterpolador[ANTIALIAS_INTERPOLATOR_STATE(ADC_BLOCK_SIZE)];
+q31_t trabajo[ADC_RAW_BLOCK_SIZE];
 #endif
 
-int y[500];
+/* DWT cycles spent filtering the last block */
+volatile uint32_t cycles;
 
-static void initHardware(void)
+/* Returns -1 if the ADC and DAC did not get their GPDMA channels */
+static int initHardware(void)
 {
 #if defined (__USE_LPCOPEN)
 #if !defined(NO_BOARD_LIB)
@@ -35,44 +80,97 @@ static void initHardware(void)
     Board_LED_Set(0, false);
 #endif
 #endif
-   adcInit();
+   Chip_GPDMA_Init(LPC_GPDMA);
    dacInit();
+   /* The ADC channel is running by the time the DAC asks for one */
+   if(adcInit() != 0)
+   {
+      return -1;
+   }
+#if(USAR_INTERPOLADOR_POLIFASE)
+   return dacStart(adcRate() * ADC_DECIMATION, ADC_RAW_BLOCK_SIZE);
+#else
+   return dacStart(adcRate(), ADC_BLOCK_SIZE);
+#endif
 }
 
 int main(void)
 {
-	int i=0, offset;
+	int i, offset;
 
 #if FILTRO_PASA_BANDA
 	fir_q31_init(&filtro, history, bandpass_taps, BANDPASS_TAP_NUM);
+	fir_fast_q31_init(&filtroFast, historyFast, bandpass_taps, BANDPASS_TAP_NUM);
 	offset=500;
 #elif FILTRO_PASA_BAJOS
 	fir_q31_init(&filtro, history, lowpass_taps, LOWPASS_TAP_NUM);
+	fir_fast_q31_init(&filtroFast, historyFast, lowpass_taps, LOWPASS_TAP_NUM);
 	offset=-100;
 #endif
 
-	initHardware();
+#if(USAR_DECIMADOR_POLIFASE)
+	polyphase_decimator_q31_init(&decimador, etapasDecimador, 2,
+			estadoDecimador, trabajo, ADC_RAW_BLOCK_SIZE);
+#endif
+#if(USAR_INTERPOLADOR_POLIFASE)
+	polyphase_interpolator_q31_init(&interpolador, etapasInterpolador, 2,
+			estadoInterpolador, trabajo, ADC_BLOCK_SIZE);
+#endif
+
+#if(EJECUTAR_BENCHMARK)
+	firBenchmark();
+#endif
+
+	if(initHardware() != 0)
+	{
+		/* Out of GPDMA channels, nothing to stream with */
+		while(1);
+	}
 
 	*DWT_CTRL |= 1;
 
 	while(1)
 	{
-		if(adcFlag)
+		if(adcBlockRead(raw))
 		{
-			adcFlag=0;
 			*DWT_CYCCNT=0; /* para medir tiempos de ejecucion */
-#if(USAR_FUNCIONES_ASSEMBLER)
-			y[i] = asm_fir_q31_get(&filtro)+offset;
-			y[i] = __USAT(y[i],10);
+#if(USAR_DECIMADOR_POLIFASE)
+			for(i = 0; i < ADC_RAW_BLOCK_SIZE; i++)
+				raw[i] <<= ESCALA_POLIFASE;
+			polyphase_decimator_q31(&decimador, (q31_t *)raw, (q31_t *)x);
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+				x[i] >>= ESCALA_POLIFASE;
+#else
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+				x[i] = raw[i * ADC_DECIMATION];
+#endif
+#if(USAR_FIR_FAST)
+			fir_fast_q31_block(&filtroFast, x, y, ADC_BLOCK_SIZE);
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+				y[i] += offset;
+#elif(USAR_FUNCIONES_ASSEMBLER)
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+			{
+				asm_fir_q31_put(&filtro, x[i]);
+				y[i] = asm_fir_q31_get(&filtro)+offset;
+			}
+#else
+			fir_q31_block(&filtro, x, y, ADC_BLOCK_SIZE);
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+				y[i] += offset;
+#endif
+#if(USAR_INTERPOLADOR_POLIFASE)
+			/* Cada etapa atenua por 2: se corre 2 bits menos al volver */
+			for(i = 0; i < ADC_BLOCK_SIZE; i++)
+				y[i] <<= ESCALA_POLIFASE;
+			polyphase_interpolator_q31(&interpolador, (q31_t *)y, (q31_t *)raw);
+			for(i = 0; i < ADC_RAW_BLOCK_SIZE; i++)
+				raw[i] >>= ESCALA_POLIFASE - 2;
+			dacWriteBlock(raw, ADC_RAW_BLOCK_SIZE);
 #else
-			y[i] = fir_q31_get(&filtro)+offset;
-			if(y[i]>0x3FF) y[i] = 0x3FF;
-			else if(y[i]<0) y[i] = 0;
+			dacWriteBlock(y, ADC_BLOCK_SIZE);
 #endif
-			dacWrite(y[i]);
-			i++;
-			if(i==500)
-				i=0;
+			cycles = *DWT_CYCCNT;
 		}
 	}
 }
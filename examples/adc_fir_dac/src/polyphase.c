@@ -0,0 +1,104 @@
+#include "polyphase.h"
+
+/* Intermediate blocks alternate between both halves of work, the last stage
+   writes straight to the caller's output. */
+
+arm_status polyphase_decimator_q31_init(polyphase_decimator_q31_t * d,
+		const polyphase_stage_t * stages, uint32_t num_stages,
+		q31_t * state, q31_t * work, uint32_t block_size)
+{
+	arm_status status;
+	uint32_t i;
+
+	if(num_stages == 0 || num_stages > POLYPHASE_MAX_STAGES)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	d->num_stages = num_stages;
+	d->block_size = block_size;
+	d->work = work;
+
+	for(i = 0; i < num_stages; i++)
+	{
+		status = arm_fir_decimate_init_q31(&d->stage[i], stages[i].num_taps,
+				stages[i].factor, (q31_t *)stages[i].taps, state, block_size);
+		if(status != ARM_MATH_SUCCESS)
+			return status;
+
+		state += stages[i].num_taps + block_size - 1;
+		block_size /= stages[i].factor;
+	}
+
+	return ARM_MATH_SUCCESS;
+}
+
+void polyphase_decimator_q31(polyphase_decimator_q31_t * d, q31_t * input, q31_t * output)
+{
+	uint32_t count = d->block_size;
+	q31_t * src = input;
+	q31_t * dst;
+	uint32_t i;
+
+	for(i = 0; i < d->num_stages; i++)
+	{
+		if(i == d->num_stages - 1)
+			dst = output;
+		else
+			dst = d->work + (i & 1) * (d->block_size / 2);
+
+		arm_fir_decimate_q31(&d->stage[i], src, dst, count);
+
+		count /= d->stage[i].M;
+		src = dst;
+	}
+}
+
+arm_status polyphase_interpolator_q31_init(polyphase_interpolator_q31_t * f,
+		const polyphase_stage_t * stages, uint32_t num_stages,
+		q31_t * state, q31_t * work, uint32_t block_size)
+{
+	arm_status status;
+	uint32_t i;
+
+	if(num_stages == 0 || num_stages > POLYPHASE_MAX_STAGES)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	f->num_stages = num_stages;
+	f->block_size = block_size;
+	f->work = work;
+
+	for(i = 0; i < num_stages; i++)
+	{
+		status = arm_fir_interpolate_init_q31(&f->stage[i], stages[i].factor,
+				stages[i].num_taps, (q31_t *)stages[i].taps, state, block_size);
+		if(status != ARM_MATH_SUCCESS)
+			return status;
+
+		state += stages[i].num_taps / stages[i].factor + block_size - 1;
+		block_size *= stages[i].factor;
+	}
+
+	f->output_size = block_size;
+
+	return ARM_MATH_SUCCESS;
+}
+
+void polyphase_interpolator_q31(polyphase_interpolator_q31_t * f, q31_t * input, q31_t * output)
+{
+	uint32_t count = f->block_size;
+	q31_t * src = input;
+	q31_t * dst;
+	uint32_t i;
+
+	for(i = 0; i < f->num_stages; i++)
+	{
+		if(i == f->num_stages - 1)
+			dst = output;
+		else
+			dst = f->work + (i & 1) * (f->output_size / 2);
+
+		arm_fir_interpolate_q31(&f->stage[i], src, dst, count);
+
+		count *= f->stage[i].L;
+		src = dst;
+	}
+}
@@ -0,0 +1,188 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/** @brief host benchmark of the fastconv direct form / FFT crossover
+ **
+ ** Runs fastconv.c and the bundled CMSIS-DSP real FFT on the host, checks
+ ** that both paths agree and prints the time per output sample of each one
+ ** for growing kernels, then the shortest kernel where the FFT wins.
+ **
+ ** The absolute numbers are the host's, only the crossover is meant to be
+ ** compared with FASTCONV_DIRECT_MAX_TAPS; bench_fastconv() in conv.c gives
+ ** the Cortex-M4 cycles. Build without optimization like the firmware, and
+ ** at -O2 for DSP_FROM_SOURCE=y, from this folder:
+ **
+ **   D=../../../../modules/dsp
+ **   T=$D/src/dspcode/TransformFunctions
+ **   gcc -O0 -std=gnu99 -w -DARM_MATH_CM4 -D__FPU_PRESENT=1 -I../inc -I$D/inc \
+ **       -o convbench convbench.c $T/arm_rfft_fast_f32.c $T/arm_cfft_f32.c \
+ **       $T/arm_cfft_radix8_f32.c $T/arm_rfft_fast_init_f32.c \
+ **       $D/src/dspcode/CommonTables/arm_common_tables.c \
+ **       $D/src/dspcode/SupportFunctions/arm_fill_f32.c
+ **   ./convbench [block]
+ **
+ ** -w hides the pointer size warnings of arm_math.h on 64 bit hosts.
+ **/
+
+/*==================[inclusions]=============================================*/
+
+#include "../src/fastconv.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*==================[macros and definitions]=================================*/
+
+#define BENCH_MAX_TAPS	1024
+#define BENCH_MAX_BLOCK	512
+#define BENCH_BLOCKS	64		/**< blocks timed per run */
+#define BENCH_RUNS		5		/**< fastest run is kept */
+
+/*==================[internal data definition]===============================*/
+
+static int bench_h[BENCH_MAX_TAPS];
+static int bench_x[BENCH_BLOCKS * BENCH_MAX_BLOCK];
+static int bench_direct[BENCH_BLOCKS * BENCH_MAX_BLOCK];
+static int bench_fft[BENCH_BLOCKS * BENCH_MAX_BLOCK];
+static uint32_t bench_work[FASTCONV_WORK_SIZE(BENCH_MAX_TAPS, BENCH_MAX_BLOCK)];
+
+/*==================[external functions definition]==========================*/
+
+/* arm_bitreversal2.S is Cortex-M only, this is its C equivalent: the table
+   holds byte offsets of the complex pairs to swap */
+void arm_bitreversal_32(uint32_t * pSrc, const uint16_t bitRevLen,
+		const uint16_t * pBitRevTable)
+{
+	uint32_t a, b, i, tmp;
+
+	for(i = 0; i < bitRevLen; i += 2)
+	{
+		a = pBitRevTable[i] >> 2;
+		b = pBitRevTable[i + 1] >> 2;
+
+		tmp = pSrc[a];
+		pSrc[a] = pSrc[b];
+		pSrc[b] = tmp;
+
+		tmp = pSrc[a + 1];
+		pSrc[a + 1] = pSrc[b + 1];
+		pSrc[b + 1] = tmp;
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* nanoseconds per output sample of one path, out gets every block */
+static double bench_run(int nh, uint32_t block, uint32_t flags, int * out)
+{
+	fastconv_t c;
+	double t, best = 0;
+	int r, b;
+
+	for(r = 0; r < BENCH_RUNS; r++)
+	{
+		if(fastconvInit(&c, bench_h, nh, block, flags, bench_work)
+				!= ARM_MATH_SUCCESS)
+		{
+			fprintf(stderr, "fastconvInit failed, %d taps\n", nh);
+			exit(1);
+		}
+
+		t = now();
+		for(b = 0; b < BENCH_BLOCKS; b++)
+			fastconvBlock(&c, &bench_x[b * block], &out[b * block]);
+		t = (now() - t) / (BENCH_BLOCKS * block);
+
+		if(r == 0 || t < best)
+			best = t;
+	}
+
+	return best;
+}
+
+int main(int argc, char * argv[])
+{
+	uint32_t block = 128;
+	int nh, i, diff, max, crossover = 0;
+	double direct, fft;
+
+	if(argc > 1)
+		block = atoi(argv[1]);
+	if(block < 16 || block > BENCH_MAX_BLOCK || (block & (block - 1)))
+	{
+		fprintf(stderr, "block: power of two, 16 to %d\n", BENCH_MAX_BLOCK);
+		return 1;
+	}
+
+	/* kernel and input in the ranges of the h and x3k tables in conv.c */
+	srand(1);
+	for(i = 0; i < BENCH_MAX_TAPS; i++)
+		bench_h[i] = (rand() % 65536 - 32768) * 1024;
+	for(i = 0; i < BENCH_BLOCKS * BENCH_MAX_BLOCK; i++)
+		bench_x[i] = (rand() % 65536 - 32768) * 256;
+
+	printf("block %u\ntaps,direct,fft,max diff (ns/sample)\n", block);
+	for(nh = 8; nh <= BENCH_MAX_TAPS; nh += (nh < 128) ? 8 : 64)
+	{
+		direct = bench_run(nh, block, FASTCONV_FORCE_DIRECT, bench_direct);
+		fft = bench_run(nh, block, FASTCONV_FORCE_FFT, bench_fft);
+
+		max = 0;
+		for(i = 0; i < BENCH_BLOCKS * (int)block; i++)
+		{
+			diff = bench_direct[i] - bench_fft[i];
+			if(diff < 0)
+				diff = -diff;
+			if(diff > max)
+				max = diff;
+		}
+
+		printf("%d,%.1f,%.1f,%d\n", nh, direct, fft, max);
+
+		if(!crossover && fft < direct)
+			crossover = nh;
+	}
+
+	printf("FFT faster from %d taps, FASTCONV_DIRECT_MAX_TAPS is %d\n",
+			crossover, FASTCONV_DIRECT_MAX_TAPS);
+
+	return 0;
+}
+
+/*==================[end of file]============================================*/
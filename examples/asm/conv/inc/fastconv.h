@@ -0,0 +1,137 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _FASTCONV_H_
+#define _FASTCONV_H_
+
+/** \addtogroup fastconv fast convolution
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "arm_math.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** Kernels up to this length run in direct form, longer ones through the
+ * FFT. host/convbench.c puts the crossover between 24 and 32 taps for 64 to
+ * 256 sample blocks, at -O0 and -O2; at 32 taps both cost about the same and
+ * the direct form is exact and needs no spectra. bench_fastconv() in conv.c
+ * prints the Cortex-M4 cycles per sample of both paths. */
+#define FASTCONV_DIRECT_MAX_TAPS	32
+
+/** fastconvInit() flags */
+#define FASTCONV_CORRELATE		1	/**< y[n] = sum(h[k] * x[n - nh + 1 + k]) >> 32 */
+#define FASTCONV_FORCE_DIRECT	2	/**< direct form whatever the kernel length */
+#define FASTCONV_FORCE_FFT		4	/**< FFT path whatever the kernel length */
+
+/** Kernel partitions for a given kernel and block length */
+#define FASTCONV_PARTITIONS(nh, block)	(((nh) + (block) - 1) / (block))
+
+/** Words of work memory fastconvInit() needs: kernel spectra and their
+ * input counterparts for every partition, two 2 * block scratch buffers and
+ * the previous input block. This also covers the nh - 1 + block samples of
+ * direct form history. */
+#define FASTCONV_WORK_SIZE(nh, block) \
+	((2 * FASTCONV_PARTITIONS(nh, block) + 2) * 2 * (block) + (block))
+
+/*==================[typedef]================================================*/
+
+/** Uniformly partitioned overlap-save convolution.
+ *
+ * h is split into P partitions of block taps, each one transformed once at
+ * init with a 2 * block real FFT. Every block of input is transformed once
+ * and kept in a frequency domain delay line; the output spectrum is the sum
+ * of the last P input spectra times the P kernel spectra, so a block costs
+ * one forward and one inverse FFT plus P spectral products whatever the
+ * kernel length. Output latency is one block.
+ *
+ * Samples and scaling follow conv_c(): y[n] = sum(h[j] * x[n - j]) >> 32. */
+typedef struct
+{
+	const int * h;
+	uint32_t nh;
+	uint32_t block;
+	uint32_t flags;
+	uint32_t fft;			/**< FFT length, 0 for direct form */
+	uint32_t partitions;
+	uint32_t head;			/**< newest slot of the delay line */
+	arm_rfft_fast_instance_f32 rfft;
+	float32_t * H;			/**< partitions * 2 * block, kernel spectra */
+	float32_t * X;			/**< partitions * 2 * block, input spectra */
+	float32_t * acc;		/**< 2 * block, FFT input, then output spectrum */
+	float32_t * out;		/**< 2 * block, inverse FFT output */
+	float32_t * prev;		/**< block, previous input block */
+	int * history;			/**< direct form, nh - 1 + block samples */
+}fastconv_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+
+/** @brief prepares a convolution with kernel h
+ * @param c       instance
+ * @param h       kernel, nh samples; kept by reference in direct form
+ * @param nh      kernel length
+ * @param block   samples per fastconvBlock() call, power of two 16 - 2048
+ * @param flags   FASTCONV_xxx
+ * @param work    FASTCONV_WORK_SIZE(nh, block) words
+ * @return ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR for a bad block
+ */
+arm_status fastconvInit(fastconv_t * c, const int * h, uint32_t nh,
+		uint32_t block, uint32_t flags, uint32_t * work);
+
+/** @brief filters one block
+ * @param c  instance
+ * @param x  block input samples
+ * @param y  block output samples, the matching conv_c() outputs of the
+ *           whole stream since fastconvInit()
+ */
+void fastconvBlock(fastconv_t * c, const int * x, int * y);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _FASTCONV_H_ */
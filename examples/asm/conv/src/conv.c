@@ -35,6 +35,7 @@
 
 #include "math.h"
 #include "ciaaUART.h"
+#include "fastconv.h"
 #include <stdio.h>
 
 volatile uint32_t * DWT_CTRL   = (uint32_t *)0xE0001000;
@@ -54,6 +55,17 @@ extern void conv_asm(convData_t * datos);
 int y[612];
 int y_c[612];
 
+/* fastconv benchmark: kernels of 8 to BENCH_MAX_TAPS taps, 128 sample blocks */
+#define BENCH_BLOCK		128
+#define BENCH_MAX_TAPS	1024
+
+int bench_h[BENCH_MAX_TAPS];
+int bench_direct[2 * BENCH_BLOCK];
+int bench_fft[2 * BENCH_BLOCK];
+/* spectra do not fit next to the stack, they go to the 40 KB local SRAM */
+uint32_t bench_work[FASTCONV_WORK_SIZE(BENCH_MAX_TAPS, BENCH_BLOCK)]
+	__attribute__ ((section(".bss.$RAM2")));
+
 const int x1k[300] = {
 		0	,
 		4616	,
@@ -732,6 +744,54 @@ const int h[49] = {
 		  -8858824
 };
 
+/* Two blocks of x3k through one path, returns the cycles of the second one
+   (the first one also fills history and delay line) */
+uint32_t bench_run(int nh, uint32_t flags, int * out)
+{
+	fastconv_t c;
+	uint32_t ciclos;
+
+	fastconvInit(&c, bench_h, nh, BENCH_BLOCK, flags, bench_work);
+	fastconvBlock(&c, x3k, out);
+
+	*DWT_CYCCNT = 0;
+	fastconvBlock(&c, x3k + BENCH_BLOCK, out + BENCH_BLOCK);
+	ciclos = *DWT_CYCCNT;
+
+	return ciclos;
+}
+
+/* Cycles per output sample of direct form and FFT for growing kernels, the
+   kernel length where the FFT wins is where FASTCONV_DIRECT_MAX_TAPS goes */
+void bench_fastconv(void)
+{
+	int nh, i, diff, max;
+	uint32_t directo, fft;
+
+	for(i=0; i<BENCH_MAX_TAPS; i++)
+		bench_h[i] = h[i % 49];
+
+	printf("taps,directo,fft,dif max (ciclos/muestra)\r\n");
+	for(nh=8; nh<=BENCH_MAX_TAPS; nh*=2)
+	{
+		directo = bench_run(nh, FASTCONV_FORCE_DIRECT, bench_direct);
+		fft = bench_run(nh, FASTCONV_FORCE_FFT, bench_fft);
+
+		max = 0;
+		for(i=0; i<2*BENCH_BLOCK; i++)
+		{
+			diff = bench_direct[i] - bench_fft[i];
+			if(diff < 0)
+				diff = -diff;
+			if(diff > max)
+				max = diff;
+		}
+
+		printf("%d,%lu,%lu,%d\r\n", nh, directo / BENCH_BLOCK,
+				fft / BENCH_BLOCK, max);
+	}
+}
+
 void conv_c(convData_t * datos)
 {
 	int i,j;
@@ -807,6 +867,8 @@ int main(void)
 		printf("%d,%d,%d\r\n", i, y[i], y_c[i]);
 	}
 
+	bench_fastconv();
+
 	return 0;
 }
 
@@ -0,0 +1,270 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief uniformly partitioned overlap-save convolution
+ **
+ ** arm_rfft_fast_f32() packs the real DC and Nyquist bins into the first
+ ** complex pair of its output, every other pair is a complex bin.
+ **/
+
+/** \addtogroup fastconv fast convolution
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "fastconv.h"
+#include "arm_common_tables.h"
+
+/*==================[macros and definitions]=================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/* The bundled arm_rfft_fast_init_f32() (CMSIS-DSP V1.4.1) only fills in the
+   bit reversal tables, both twiddle pointers are set here after it. */
+static arm_status rfftInit(arm_rfft_fast_instance_f32 * s, uint32_t n)
+{
+	if(arm_rfft_fast_init_f32(s, n) != ARM_MATH_SUCCESS)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	switch(n)
+	{
+	case 32:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_16;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_32;
+		break;
+	case 64:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_32;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_64;
+		break;
+	case 128:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_64;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_128;
+		break;
+	case 256:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_128;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_256;
+		break;
+	case 512:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_256;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_512;
+		break;
+	case 1024:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_512;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_1024;
+		break;
+	case 2048:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_1024;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_2048;
+		break;
+	case 4096:
+		s->Sint.pTwiddle = (float32_t *)twiddleCoef_2048;
+		s->pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_4096;
+		break;
+	default:
+		return ARM_MATH_ARGUMENT_ERROR;
+	}
+	return ARM_MATH_SUCCESS;
+}
+
+/* kernel tap j as seen by the convolution */
+static int tap(fastconv_t * c, uint32_t j)
+{
+	if(c->flags & FASTCONV_CORRELATE)
+		return c->h[c->nh - 1 - j];
+	return c->h[j];
+}
+
+/* acc += x * h over one packed spectrum of n real samples */
+static void spectrumMac(float32_t * acc, const float32_t * x,
+		const float32_t * h, uint32_t n)
+{
+	uint32_t k;
+	float32_t xr, xi, hr, hi;
+
+	acc[0] += x[0] * h[0];
+	acc[1] += x[1] * h[1];
+
+	for(k = 2; k < n; k += 2)
+	{
+		xr = x[k];
+		xi = x[k + 1];
+		hr = h[k];
+		hi = h[k + 1];
+		acc[k] += xr * hr - xi * hi;
+		acc[k + 1] += xr * hi + xi * hr;
+	}
+}
+
+static void directBlock(fastconv_t * c, const int * x, int * y)
+{
+	int * hist = c->history;
+	uint32_t i, j;
+	int64_t acum;
+
+	for(i = 0; i < c->block; i++)
+		hist[c->nh - 1 + i] = x[i];
+
+	for(i = 0; i < c->block; i++)
+	{
+		acum = 0;
+		if(c->flags & FASTCONV_CORRELATE)
+		{
+			for(j = 0; j < c->nh; j++)
+				acum += (int64_t)c->h[j] * hist[i + j];
+		}
+		else
+		{
+			for(j = 0; j < c->nh; j++)
+				acum += (int64_t)c->h[j] * hist[c->nh - 1 + i - j];
+		}
+		y[i] = acum >> 32;
+	}
+
+	/* keep the last nh - 1 samples for the next block */
+	for(i = 0; i < c->nh - 1; i++)
+		hist[i] = hist[c->block + i];
+}
+
+static void fftBlock(fastconv_t * c, const int * x, int * y)
+{
+	uint32_t n = c->fft;
+	uint32_t b = c->block;
+	uint32_t i, p, slot;
+
+	/* previous and current block, transformed into the newest slot */
+	for(i = 0; i < b; i++)
+	{
+		c->acc[i] = c->prev[i];
+		c->acc[b + i] = c->prev[i] = x[i];
+	}
+
+	c->head = (c->head + 1) % c->partitions;
+	arm_rfft_fast_f32(&c->rfft, c->acc, &c->X[c->head * n], 0);
+
+	/* partition p of the kernel meets the input from p blocks ago */
+	arm_fill_f32(0.0f, c->acc, n);
+	slot = c->head;
+	for(p = 0; p < c->partitions; p++)
+	{
+		spectrumMac(c->acc, &c->X[slot * n], &c->H[p * n], n);
+		slot = (slot ? slot : c->partitions) - 1;
+	}
+
+	/* the first half wraps around, the second one is the linear result */
+	arm_rfft_fast_f32(&c->rfft, c->acc, c->out, 1);
+	for(i = 0; i < b; i++)
+		y[i] = c->out[b + i];
+}
+
+/*==================[external functions definition]==========================*/
+
+arm_status fastconvInit(fastconv_t * c, const int * h, uint32_t nh,
+		uint32_t block, uint32_t flags, uint32_t * work)
+{
+	uint32_t n = 2 * block;
+	uint32_t i, j, p;
+	int direct;
+
+	if(nh == 0 || block < 16 || block > 2048 || (block & (block - 1)))
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	c->h = h;
+	c->nh = nh;
+	c->block = block;
+	c->flags = flags;
+	c->partitions = FASTCONV_PARTITIONS(nh, block);
+	c->head = 0;
+
+	direct = (nh <= FASTCONV_DIRECT_MAX_TAPS);
+	if(flags & FASTCONV_FORCE_DIRECT)
+		direct = 1;
+	else if(flags & FASTCONV_FORCE_FFT)
+		direct = 0;
+
+	if(direct)
+	{
+		c->fft = 0;
+		c->history = (int *)work;
+		for(i = 0; i < nh - 1 + block; i++)
+			c->history[i] = 0;
+		return ARM_MATH_SUCCESS;
+	}
+
+	c->fft = n;
+	c->H = (float32_t *)work;
+	c->X = c->H + c->partitions * n;
+	c->acc = c->X + c->partitions * n;
+	c->out = c->acc + n;
+	c->prev = c->out + n;
+
+	if(rfftInit(&c->rfft, n) != ARM_MATH_SUCCESS)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	/* kernel spectra, zero padded to n and scaled by 2^-32 as in conv_c() */
+	for(p = 0; p < c->partitions; p++)
+	{
+		arm_fill_f32(0.0f, c->acc, n);
+		for(i = 0; i < block; i++)
+		{
+			j = p * block + i;
+			if(j < nh)
+				c->acc[i] = tap(c, j) * (1.0f / 4294967296.0f);
+		}
+		arm_rfft_fast_f32(&c->rfft, c->acc, &c->H[p * n], 0);
+	}
+
+	arm_fill_f32(0.0f, c->X, c->partitions * n);
+	arm_fill_f32(0.0f, c->prev, block);
+
+	return ARM_MATH_SUCCESS;
+}
+
+void fastconvBlock(fastconv_t * c, const int * x, int * y)
+{
+	if(c->fft)
+		fftBlock(c, x, y);
+	else
+		directBlock(c, x, y);
+}
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
@@ -0,0 +1,124 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _SAMPLEPACK_H_
+#define _SAMPLEPACK_H_
+
+/** \addtogroup samplepack sample packer
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "board.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** Bytes taken by n packed samples of each format */
+#define SAMPLEPACK_U8_BYTES(n)	(n)
+#define SAMPLEPACK_S8_BYTES(n)	(n)
+#define SAMPLEPACK_U12_BYTES(n)	(((n) * 3 + 1) / 2)
+#define SAMPLEPACK_S16_BYTES(n)	((n) * 2)
+
+/*==================[typedef]================================================*/
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+
+/* Packed formats:
+ *
+ * u8   0 .. 255, one byte per sample
+ * s8   -128 .. 127, one byte per sample
+ * u12  0 .. 4095, two samples every three bytes, little endian bit stream:
+ *      byte 0 = s0[7:0], byte 1 = s1[3:0] s0[11:8], byte 2 = s1[11:4]
+ * s16  -32768 .. 32767, one halfword per sample
+ *
+ * int16 samples (ADC counts, the muestras[] of packer.c) are packed as they
+ * are, values out of the packed range saturate. q31 and float samples are
+ * full scale fractions: signed formats cover [-1, 1), unsigned ones [0, 1),
+ * anything outside saturates.
+ *
+ * The int16 packers run 4 samples per iteration with SSAT16/USAT16 and
+ * PKHBT, the unpackers with SXTB16/UXTB16, so n must be a multiple of 4 and
+ * the int16 buffers word aligned. u12 buffers must be halfword aligned. */
+
+/** @brief int16 samples to u8, same result as empaquetar_c() */
+void pack_s16_u8(const int16_t * in, uint32_t n, uint8_t * out);
+void pack_s16_s8(const int16_t * in, uint32_t n, int8_t * out);
+void pack_s16_u12(const int16_t * in, uint32_t n, uint8_t * out);
+
+/** @brief packed samples back to int16, zero or sign extended */
+void unpack_u8_s16(const uint8_t * in, uint32_t n, int16_t * out);
+void unpack_s8_s16(const int8_t * in, uint32_t n, int16_t * out);
+void unpack_u12_s16(const uint8_t * in, uint32_t n, int16_t * out);
+
+/** @brief q31 to packed samples, truncating */
+void pack_q31_u8(const int32_t * in, uint32_t n, uint8_t * out);
+void pack_q31_s8(const int32_t * in, uint32_t n, int8_t * out);
+void pack_q31_u12(const int32_t * in, uint32_t n, uint8_t * out);
+void pack_q31_s16(const int32_t * in, uint32_t n, int16_t * out);
+
+/** @brief packed samples to q31 */
+void unpack_u8_q31(const uint8_t * in, uint32_t n, int32_t * out);
+void unpack_s8_q31(const int8_t * in, uint32_t n, int32_t * out);
+void unpack_u12_q31(const uint8_t * in, uint32_t n, int32_t * out);
+void unpack_s16_q31(const int16_t * in, uint32_t n, int32_t * out);
+
+/** @brief float to packed samples, truncating */
+void pack_f32_u8(const float * in, uint32_t n, uint8_t * out);
+void pack_f32_s8(const float * in, uint32_t n, int8_t * out);
+void pack_f32_u12(const float * in, uint32_t n, uint8_t * out);
+void pack_f32_s16(const float * in, uint32_t n, int16_t * out);
+
+/** @brief packed samples to float */
+void unpack_u8_f32(const uint8_t * in, uint32_t n, float * out);
+void unpack_s8_f32(const int8_t * in, uint32_t n, float * out);
+void unpack_u12_f32(const uint8_t * in, uint32_t n, float * out);
+void unpack_s16_f32(const int16_t * in, uint32_t n, float * out);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _SAMPLEPACK_H_ */
@@ -36,8 +36,11 @@
 #include "packer.h"
 
 #include "pack.h"
+#include "samplepack.h"
 #include "samples.h"
 
+#include <string.h>
+
 /*==================[macros and definitions]=================================*/
 
 /*==================[internal data declaration]==============================*/
@@ -53,6 +56,19 @@ static void initHardware(void);
 
 samples salida[64];
 samples salida_c[64];
+uint8_t salida_simd[256];
+uint8_t salida_u12[SAMPLEPACK_U12_BYTES(256)] __attribute__ ((aligned(4)));
+int16_t recuperadas[256] __attribute__ ((aligned(4)));
+
+/** ciclos de empaquetar_c(), pack() y pack_s16_u8() sobre las 256 muestras */
+volatile uint32_t ciclos_c, ciclos_asm, ciclos_simd;
+
+/** ciclos de ida y vuelta por u12 */
+volatile uint32_t ciclos_u12, ciclos_u12_vuelta;
+
+/** 1 si pack_s16_u8() coincide con empaquetar_c() y la ida y vuelta por u12
+ * devuelve las muestras saturadas a 0..4095 */
+volatile uint32_t resultado_ok;
 
 /*==================[external data definition]===============================*/
 
@@ -70,7 +86,7 @@ static void initHardware(void)
 static void empaquetar_c(int16_t * muestras, int n, uint32_t * salida)
 {
 	uint32_t i = 0;
-	int8_t muestra;
+	uint8_t muestra;
 
 	for(i=0; i<n; i++) {
 		if(muestras[i] > 255)
@@ -101,15 +117,38 @@ static void empaquetar_c(int16_t * muestras, int n, uint32_t * salida)
 
 int main(void)
 {
+	uint32_t i, ok;
+
 	initHardware();
 
 	*DWT_CTRL  |= 1;
 
 	*DWT_CYCCNT = 0;
 	empaquetar_c(muestras, 256, (uint32_t*)salida_c);
+	ciclos_c = *DWT_CYCCNT;
 
 	*DWT_CYCCNT = 0;
 	pack(muestras, 256, (uint32_t*)salida);
+	ciclos_asm = *DWT_CYCCNT;
+
+	*DWT_CYCCNT = 0;
+	pack_s16_u8(muestras, 256, salida_simd);
+	ciclos_simd = *DWT_CYCCNT;
+
+	*DWT_CYCCNT = 0;
+	pack_s16_u12(muestras, 256, salida_u12);
+	ciclos_u12 = *DWT_CYCCNT;
+
+	*DWT_CYCCNT = 0;
+	unpack_u12_s16(salida_u12, 256, recuperadas);
+	ciclos_u12_vuelta = *DWT_CYCCNT;
+
+	ok = memcmp(salida_c, salida_simd, sizeof(salida_simd)) == 0;
+	for(i = 0; i < 256; i++) {
+		if (recuperadas[i] != (muestras[i] < 0 ? 0 : muestras[i]))
+			ok = 0;
+	}
+	resultado_ok = ok;
 
 	while (1) {}
 }
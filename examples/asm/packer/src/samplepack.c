@@ -0,0 +1,276 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief sample packer/unpacker
+ **
+ ** q31 and float conversions, u12 helpers and the C versions of the int16
+ ** kernels for cores without the DSP extension (asm_samplepack.S otherwise).
+ **
+ **/
+
+/** \addtogroup samplepack sample packer
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "samplepack.h"
+
+/*==================[macros and definitions]=================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/** @brief stores sample i of a u12 stream, samples go in ascending order */
+static void u12Put(uint8_t * out, uint32_t i, uint32_t v);
+
+/** @brief reads sample i of a u12 stream */
+static uint32_t u12Get(const uint8_t * in, uint32_t i);
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+static void u12Put(uint8_t * out, uint32_t i, uint32_t v)
+{
+	out += i / 2 * 3;
+	if (i & 1) {
+		out[1] |= v << 4;
+		out[2] = v >> 4;
+	}
+	else {
+		out[0] = v;
+		out[1] = v >> 8;
+	}
+}
+
+static uint32_t u12Get(const uint8_t * in, uint32_t i)
+{
+	in += i / 2 * 3;
+	if (i & 1)
+		return (in[1] >> 4) | (in[2] << 4);
+	else
+		return in[0] | ((in[1] & 0x0F) << 8);
+}
+
+/*==================[external functions definition]==========================*/
+
+#ifndef __ARM_FEATURE_DSP
+
+void pack_s16_u8(const int16_t * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __USAT(in[i], 8);
+}
+
+void pack_s16_s8(const int16_t * in, uint32_t n, int8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __SSAT(in[i], 8);
+}
+
+void pack_s16_u12(const int16_t * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		u12Put(out, i, __USAT(in[i], 12));
+}
+
+void unpack_u8_s16(const uint8_t * in, uint32_t n, int16_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i];
+}
+
+void unpack_s8_s16(const int8_t * in, uint32_t n, int16_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i];
+}
+
+void unpack_u12_s16(const uint8_t * in, uint32_t n, int16_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = u12Get(in, i);
+}
+
+#endif /* __ARM_FEATURE_DSP */
+
+void pack_q31_u8(const int32_t * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __USAT(in[i] >> 23, 8);
+}
+
+void pack_q31_s8(const int32_t * in, uint32_t n, int8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i] >> 24;
+}
+
+void pack_q31_u12(const int32_t * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		u12Put(out, i, __USAT(in[i] >> 19, 12));
+}
+
+void pack_q31_s16(const int32_t * in, uint32_t n, int16_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i] >> 16;
+}
+
+void unpack_u8_q31(const uint8_t * in, uint32_t n, int32_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = (uint32_t)in[i] << 23;
+}
+
+void unpack_s8_q31(const int8_t * in, uint32_t n, int32_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = (int32_t)((uint32_t)in[i] << 24);
+}
+
+void unpack_u12_q31(const uint8_t * in, uint32_t n, int32_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = u12Get(in, i) << 19;
+}
+
+void unpack_s16_q31(const int16_t * in, uint32_t n, int32_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = (int32_t)((uint32_t)in[i] << 16);
+}
+
+/* vcvt trunca hacia cero y satura a int32, __SSAT/__USAT recortan al rango
+ * del formato */
+
+void pack_f32_u8(const float * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __USAT((int32_t)(in[i] * 256.0f), 8);
+}
+
+void pack_f32_s8(const float * in, uint32_t n, int8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __SSAT((int32_t)(in[i] * 128.0f), 8);
+}
+
+void pack_f32_u12(const float * in, uint32_t n, uint8_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		u12Put(out, i, __USAT((int32_t)(in[i] * 4096.0f), 12));
+}
+
+void pack_f32_s16(const float * in, uint32_t n, int16_t * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = __SSAT((int32_t)(in[i] * 32768.0f), 16);
+}
+
+void unpack_u8_f32(const uint8_t * in, uint32_t n, float * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i] * (1.0f / 256.0f);
+}
+
+void unpack_s8_f32(const int8_t * in, uint32_t n, float * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i] * (1.0f / 128.0f);
+}
+
+void unpack_u12_f32(const uint8_t * in, uint32_t n, float * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = u12Get(in, i) * (1.0f / 4096.0f);
+}
+
+void unpack_s16_f32(const int16_t * in, uint32_t n, float * out)
+{
+	uint32_t i;
+
+	for(i = 0; i < n; i++)
+		out[i] = in[i] * (1.0f / 32768.0f);
+}
+
+/** @} doxygen end group definition */
+
+/*==================[end of file]============================================*/
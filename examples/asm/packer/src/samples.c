@@ -33,7 +33,8 @@
 
 #include "board.h"
 
-int16_t muestras[256] =
+/* alineado a palabra para los ldrd de samplepack */
+int16_t muestras[256] __attribute__ ((aligned(4))) =
 {
 		120	,
 		213	,
@@ -0,0 +1,311 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief CMSIS-DSP benchmark
+ **
+ ** Times the kernels the examples lean on. Build it once against the
+ ** prebuilt CMSIS_DSPLIB_CM4 and once with DSP_FROM_SOURCE=y, the cycle
+ ** counts are printed on the debug UART as CSV.
+ **
+ ** The same plain C FIR is also timed from flash and from RamLoc40
+ ** (.ramfunc.$RAM2) to show what the flash accelerator wait states cost a
+ ** tight loop.
+ **
+ **/
+
+/** \addtogroup dsp_bench CMSIS-DSP benchmark
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "main.h"
+#include "board.h"
+#include "ciaaUART.h"
+
+#include <stdio.h>
+
+/*==================[macros and definitions]=================================*/
+
+#define BLOCK			256		/**< samples per kernel call */
+#define FIR_TAPS		64
+#define BIQUAD_STAGES	4
+#define CFFT_LEN		BLOCK	/**< complex points, arm_cfft_sR_f32_len256 */
+#define MAT_DIM			16
+#define REPEAT			8		/**< calls per kernel, the fastest one counts */
+
+/** code copied to RamLoc40 by the startup code, see etc/ld/lpc4337_m4.ld */
+#define RAMFUNC			__attribute__ ((section(".ramfunc.$RAM2")))
+
+typedef struct
+{
+	const char * name;
+	void (*run)(void);
+	uint32_t samples;			/**< samples or outputs per call */
+}bench_t;
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/** @brief hardware initialization function
+ *	@return none
+ */
+static void initHardware(void);
+
+static void runFirF32(void);
+static void runFirQ31(void);
+static void runBiquadF32(void);
+static void runCfftF32(void);
+static void runMatMultF32(void);
+static void runFirFlash(void);
+static void runFirRam(void);
+
+/** @brief direct form FIR, inlined into both runFirFlash() and runFirRam()
+ * so the two only differ in where the loop is fetched from */
+static inline __attribute__((always_inline)) void firLoop(void);
+
+/** @brief fills inputs and kernel instances */
+static void initKernels(void);
+
+/** @brief calls b->run REPEAT times
+ * @return cycles of the fastest call
+ */
+static uint32_t benchRun(const bench_t * b);
+
+/*==================[internal data definition]===============================*/
+
+static float32_t inF32[BLOCK];
+static float32_t outF32[BLOCK];
+static q31_t inQ31[BLOCK];
+static q31_t outQ31[BLOCK];
+
+static float32_t firCoeffsF32[FIR_TAPS];
+static float32_t firStateF32[FIR_TAPS + BLOCK - 1];
+static arm_fir_instance_f32 firF32;
+
+static q31_t firCoeffsQ31[FIR_TAPS];
+static q31_t firStateQ31[FIR_TAPS + BLOCK - 1];
+static arm_fir_instance_q31 firQ31;
+
+static float32_t biquadCoeffs[5 * BIQUAD_STAGES];
+static float32_t biquadState[4 * BIQUAD_STAGES];
+static arm_biquad_casd_df1_inst_f32 biquad;
+
+static float32_t cfftBuf[2 * CFFT_LEN];
+
+/** FIR_TAPS - 1 samples of history followed by the block */
+static float32_t firLoopIn[FIR_TAPS - 1 + BLOCK];
+
+static float32_t matAData[MAT_DIM * MAT_DIM];
+static float32_t matBData[MAT_DIM * MAT_DIM];
+static float32_t matCData[MAT_DIM * MAT_DIM];
+static arm_matrix_instance_f32 matA;
+static arm_matrix_instance_f32 matB;
+static arm_matrix_instance_f32 matC;
+
+static const bench_t benches[] =
+{
+	{"arm_fir_f32 64 taps", runFirF32, BLOCK},
+	{"arm_fir_q31 64 taps", runFirQ31, BLOCK},
+	{"arm_biquad_cascade_df1_f32 4 etapas", runBiquadF32, BLOCK},
+	{"arm_cfft_f32 256", runCfftF32, CFFT_LEN},
+	{"arm_mat_mult_f32 16x16", runMatMultF32, MAT_DIM * MAT_DIM},
+	{"FIR C 64 taps en flash", runFirFlash, BLOCK},
+	{"FIR C 64 taps en RAM", runFirRam, BLOCK},
+};
+
+#define BENCHES	(sizeof(benches) / sizeof(benches[0]))
+
+/*==================[external data definition]===============================*/
+
+volatile uint32_t * DWT_CTRL   = (uint32_t *)0xE0001000;
+volatile uint32_t * DWT_CYCCNT = (uint32_t *)0xE0001004;
+
+/** ciclos por llamada de cada kernel, en el orden de benches[] */
+volatile uint32_t benchCycles[BENCHES];
+
+/* the prebuilt library headers do not ship arm_const_structs.h */
+extern const arm_cfft_instance_f32 arm_cfft_sR_f32_len256;
+
+/*==================[internal functions definition]==========================*/
+
+static void initHardware(void)
+{
+	Board_Init();
+	SystemCoreClockUpdate();
+	ciaaUARTInit();
+}
+
+static void runFirF32(void)
+{
+	arm_fir_f32(&firF32, inF32, outF32, BLOCK);
+}
+
+static void runFirQ31(void)
+{
+	arm_fir_q31(&firQ31, inQ31, outQ31, BLOCK);
+}
+
+static void runBiquadF32(void)
+{
+	arm_biquad_cascade_df1_f32(&biquad, inF32, outF32, BLOCK);
+}
+
+static void runCfftF32(void)
+{
+	arm_cfft_f32(&arm_cfft_sR_f32_len256, cfftBuf, 0, 1);
+}
+
+static void runMatMultF32(void)
+{
+	arm_mat_mult_f32(&matA, &matB, &matC);
+}
+
+static inline __attribute__((always_inline)) void firLoop(void)
+{
+	uint32_t n, k;
+	float32_t acc;
+
+	for(n = 0; n < BLOCK; n++)
+	{
+		acc = 0;
+		for(k = 0; k < FIR_TAPS; k++)
+			acc += firCoeffsF32[k] * firLoopIn[n + FIR_TAPS - 1 - k];
+		outF32[n] = acc;
+	}
+}
+
+static void runFirFlash(void)
+{
+	firLoop();
+}
+
+RAMFUNC static void runFirRam(void)
+{
+	firLoop();
+}
+
+static void initKernels(void)
+{
+	uint32_t i;
+	float32_t mitad;
+
+	for(i = 0; i < BLOCK; i++)
+	{
+		inF32[i] = arm_sin_f32(0.05f * i) + 0.25f * arm_sin_f32(1.3f * i);
+		mitad = inF32[i] / 2;
+		arm_float_to_q31(&mitad, &inQ31[i], 1);
+	}
+
+	//pasabajos con ventana triangular, ganancia 1
+	for(i = 0; i < FIR_TAPS; i++)
+		firCoeffsF32[i] = (i < FIR_TAPS / 2 ? i + 1 : FIR_TAPS - i) / 1056.0f;
+	arm_float_to_q31(firCoeffsF32, firCoeffsQ31, FIR_TAPS);
+	arm_fir_init_f32(&firF32, FIR_TAPS, firCoeffsF32, firStateF32, BLOCK);
+	arm_fir_init_q31(&firQ31, FIR_TAPS, firCoeffsQ31, firStateQ31, BLOCK);
+	arm_copy_f32(inF32, firLoopIn + FIR_TAPS - 1, BLOCK);
+
+	//b0 b1 b2 a1 a2 de una etapa estable, repetida
+	for(i = 0; i < BIQUAD_STAGES; i++)
+	{
+		biquadCoeffs[5 * i + 0] = 0.2f;
+		biquadCoeffs[5 * i + 1] = 0.4f;
+		biquadCoeffs[5 * i + 2] = 0.2f;
+		biquadCoeffs[5 * i + 3] = 0.3f;
+		biquadCoeffs[5 * i + 4] = -0.1f;
+	}
+	arm_biquad_cascade_df1_init_f32(&biquad, BIQUAD_STAGES, biquadCoeffs, biquadState);
+
+	for(i = 0; i < MAT_DIM * MAT_DIM; i++)
+	{
+		matAData[i] = (float32_t)(i % 7) - 3;
+		matBData[i] = (float32_t)(i % 5) * 0.5f;
+	}
+	arm_mat_init_f32(&matA, MAT_DIM, MAT_DIM, matAData);
+	arm_mat_init_f32(&matB, MAT_DIM, MAT_DIM, matBData);
+	arm_mat_init_f32(&matC, MAT_DIM, MAT_DIM, matCData);
+}
+
+static uint32_t benchRun(const bench_t * b)
+{
+	uint32_t i, ciclos, min = 0xFFFFFFFF;
+
+	for(i = 0; i < REPEAT; i++)
+	{
+		//la CFFT es in place: cada corrida arranca de la misma senal
+		arm_copy_f32(inF32, cfftBuf, BLOCK);
+		arm_copy_f32(inF32, cfftBuf + BLOCK, BLOCK);
+
+		*DWT_CYCCNT = 0;
+		b->run();
+		ciclos = *DWT_CYCCNT;
+
+		if (ciclos < min)
+			min = ciclos;
+	}
+
+	return min;
+}
+
+/*==================[external functions definition]==========================*/
+
+int main(void)
+{
+	uint32_t i;
+
+	initHardware();
+	initKernels();
+
+	*DWT_CTRL |= 1;
+
+#ifdef CMSIS_DSP_FROM_SOURCE
+	printf("CMSIS-DSP compilada desde modules/dsp\r\n");
+#else
+	printf("CMSIS-DSP precompilada (CMSIS_DSPLIB_CM4)\r\n");
+#endif
+	printf("kernel,ciclos,ciclos/muestra\r\n");
+
+	for(i = 0; i < BENCHES; i++)
+	{
+		benchCycles[i] = benchRun(&benches[i]);
+		printf("%s,%lu,%lu\r\n", benches[i].name, benchCycles[i],
+				benchCycles[i] / benches[i].samples);
+	}
+
+	while (1) {}
+}
+
+/** @} doxygen end group definition */
+
+/*==================[end of file]============================================*/
@@ -0,0 +1,92 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _ADC_H_
+#define _ADC_H_
+
+/** \addtogroup stft short-time FFT
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "board.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** Samples per DMA block, one STFT hop */
+#define ADC_BLOCK_SIZE		256
+
+/** Blocks in the DMA ring, power of two */
+#define ADC_RING_BLOCKS		4
+
+/*==================[typedef]================================================*/
+
+/*==================[external data declaration]==============================*/
+
+/** Blocks overwritten by the DMA before they were released */
+extern volatile uint32_t adcOverruns;
+
+/*==================[external functions declaration]=========================*/
+
+/** @brief starts burst conversions into the DMA ring
+ * @param rate  requested sample rate
+ */
+void adcInit(uint32_t rate);
+
+/** @brief actual sample rate */
+uint32_t adcRate(void);
+
+/** @brief oldest completed block, in place in the ring
+ * @return ADC_BLOCK_SIZE ADC data register words, NULL if none is ready
+ */
+const uint32_t * adcBlockGet(void);
+
+/** @brief gives the block returned by adcBlockGet() back to the DMA */
+void adcBlockRelease(void);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _ADC_H_ */
@@ -0,0 +1,119 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _GOERTZEL_H_
+#define _GOERTZEL_H_
+
+/** \addtogroup goertzel tone detector bank
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "arm_math.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** Tones per bank, one bit each in goertzel_t.detected */
+#define GOERTZEL_MAX_TONES	8
+
+/*==================[typedef]================================================*/
+
+typedef struct
+{
+	float32_t coeff;		/**< 2 * cos(2 * pi * f / rate) */
+	float32_t threshold;	/**< detection amplitude */
+	float32_t s1;
+	float32_t s2;
+	float32_t amplitude;	/**< result of the last complete block */
+}goertzelTone_t;
+
+/** Goertzel filters for a few known frequencies. Every tone costs one
+ * multiply-add per sample, against the whole spectrum of an FFT; samples
+ * may arrive in chunks of any size, a decision is made every length
+ * samples. */
+typedef struct
+{
+	uint32_t tones;
+	uint32_t length;		/**< samples per decision */
+	uint32_t count;			/**< samples into the current block */
+	uint32_t blocks;		/**< decisions since goertzelInit() */
+	uint32_t detected;		/**< bit n set: tone n above its threshold */
+	goertzelTone_t tone[GOERTZEL_MAX_TONES];
+}goertzel_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+
+/** @brief prepares an empty bank
+ * @param g       instance
+ * @param length  samples per decision; frequency resolution is
+ *                rate / length
+ */
+void goertzelInit(goertzel_t * g, uint32_t length);
+
+/** @brief adds a tone to the bank
+ * @param g          instance
+ * @param freq       tone frequency in Hz
+ * @param rate       sample rate in Hz
+ * @param threshold  amplitude above which the tone counts as present
+ * @return tone index, -1 if the bank is full
+ */
+int goertzelAddTone(goertzel_t * g, float32_t freq, float32_t rate,
+		float32_t threshold);
+
+/** @brief runs count samples through every tone
+ * @param g      instance
+ * @param x      samples
+ * @param count  number of samples, any size
+ * @return 1 if at least one block completed, detected and amplitudes then
+ * hold the last one
+ */
+int goertzelUpdate(goertzel_t * g, const float32_t * x, uint32_t count);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _GOERTZEL_H_ */
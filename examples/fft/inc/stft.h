@@ -0,0 +1,129 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _STFT_H_
+#define _STFT_H_
+
+/** \addtogroup stft short-time FFT
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "arm_math.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** FFT length and window size */
+#define STFT_SIZE		1024
+
+/** Bins from DC to Nyquist */
+#define STFT_BINS		(STFT_SIZE / 2 + 1)
+
+/** Spectrum buffers: one being written, one being read, one ready */
+#define STFT_SPECTRA	3
+
+/*==================[typedef]================================================*/
+
+/** One analysis frame, handed to consumers without copying */
+typedef struct
+{
+	float32_t magnitude[STFT_BINS];	/**< amplitude per bin, window gain removed */
+	uint32_t peakBin;				/**< strongest bin above DC */
+	float32_t peakValue;
+	uint32_t frame;					/**< frames since stftInit() */
+}stftSpectrum_t;
+
+/** Streaming STFT. Every hop new samples slide into the last STFT_SIZE,
+ * the frame is windowed, transformed with arm_rfft_fast_f32() and reduced
+ * to magnitudes and a peak. Spectra are triple buffered: the analyzer
+ * always has a buffer to write, a consumer keeps the one it acquired until
+ * its next stftAcquire() and the third one carries the newest result. */
+typedef struct
+{
+	const float32_t * window;		/**< half window, see window.h */
+	float32_t scale;				/**< 2 / sum(window) */
+	uint32_t hop;
+	uint32_t frames;
+	arm_rfft_fast_instance_f32 rfft;
+	float32_t frame[STFT_SIZE];
+	float32_t work[STFT_SIZE];
+	float32_t spectrum[STFT_SIZE];
+	stftSpectrum_t spectra[STFT_SPECTRA];
+	uint8_t writing;
+	uint8_t ready;
+	uint8_t reading;
+	volatile uint8_t fresh;
+}stft_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+
+/** @brief prepares an analyzer
+ * @param s       instance
+ * @param window  windowHann or windowBlackman
+ * @param hop     new samples per frame, STFT_SIZE / 2 or STFT_SIZE / 4 for
+ *                50 or 75 % overlap
+ * @return ARM_MATH_SUCCESS or ARM_MATH_ARGUMENT_ERROR
+ */
+arm_status stftInit(stft_t * s, const float32_t * window, uint32_t hop);
+
+/** @brief analyzes one frame and publishes its spectrum
+ * @param s  instance
+ * @param x  hop new samples
+ */
+void stftHop(stft_t * s, const float32_t * x);
+
+/** @brief takes the newest spectrum
+ * @param s  instance
+ * @return spectrum published since the last call, NULL if none. It stays
+ * valid until the next call.
+ */
+const stftSpectrum_t * stftAcquire(stft_t * s);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _STFT_H_ */
@@ -0,0 +1,162 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief ADC sampling into a DMA ring
+ **
+ ** The GPDMA runs a circular list of ADC_RING_BLOCKS descriptors and
+ ** interrupts once per block; blocks are read in place.
+ **/
+
+/** \addtogroup stft short-time FFT
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "adc.h"
+
+/*==================[macros and definitions]=================================*/
+
+#ifdef lpc4337_m4
+#define LPC_ADC			LPC_ADC0
+#define ADC_IRQn		ADC0_IRQn
+#define ADC_DMA_CONN	GPDMA_CONN_ADC_0
+/* ADC clocks per 10 bit conversion */
+#define ADC_CONV_CLOCKS	11
+#define adcClockRate()	Chip_Clock_GetRate(CLK_APB3_ADC0)
+#else
+#define ADC_DMA_CONN	GPDMA_CONN_ADC
+#define ADC_CONV_CLOCKS	65
+#define adcClockRate()	Chip_Clock_GetPeripheralClockRate(SYSCTL_PCLK_ADC)
+#endif
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+static uint32_t adcRing[ADC_RING_BLOCKS][ADC_BLOCK_SIZE];
+static DMA_TransferDescriptor_t adcDesc[ADC_RING_BLOCKS];
+static uint8_t adcChannel;
+
+/* Blocks completed by the DMA and blocks released, both free running */
+static volatile uint32_t adcWritten;
+static uint32_t adcRead;
+
+/*==================[external data definition]===============================*/
+
+volatile uint32_t adcOverruns;
+
+/*==================[internal functions definition]==========================*/
+
+/*==================[external functions definition]==========================*/
+
+void adcInit(uint32_t rate)
+{
+	ADC_CLOCK_SETUP_T adc;
+	DMA_TransferDescriptor_t head;
+	int i;
+
+	Chip_ADC_Init(LPC_ADC, &adc);
+	Chip_ADC_SetSampleRate(LPC_ADC, &adc, rate);
+
+	/* The channel interrupt flag requests the DMA, no ADC IRQ is used */
+	Chip_ADC_EnableChannel(LPC_ADC, ADC_CH1, ENABLE);
+	Chip_ADC_Int_SetChannelCmd(LPC_ADC, ADC_CH1, ENABLE);
+	NVIC_DisableIRQ(ADC_IRQn);
+
+	Chip_GPDMA_Init(LPC_GPDMA);
+	adcChannel = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, ADC_DMA_CONN);
+	for(i = 0; i < ADC_RING_BLOCKS; i++)
+	{
+		Chip_GPDMA_PrepareDescriptor(LPC_GPDMA, &adcDesc[i], ADC_DMA_CONN,
+				(uint32_t)adcRing[i], ADC_BLOCK_SIZE,
+				GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA,
+				&adcDesc[(i + 1) % ADC_RING_BLOCKS]);
+		/* PrepareDescriptor() clears the interrupt bit of linked blocks */
+		adcDesc[i].ctrl |= GPDMA_DMACCxControl_I;
+	}
+
+	/* Chip_GPDMA_SGTransfer() takes the peripheral connection instead of
+	   its register address from the first descriptor */
+	head = adcDesc[0];
+	head.src = ADC_DMA_CONN;
+	Chip_GPDMA_SGTransfer(LPC_GPDMA, adcChannel, &head,
+			GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA);
+
+	NVIC_EnableIRQ(DMA_IRQn);
+	Chip_ADC_SetBurstCmd(LPC_ADC, ENABLE);
+}
+
+uint32_t adcRate(void)
+{
+	uint32_t div = (LPC_ADC->CR >> 8) & 0xFF;
+
+	return adcClockRate() / ((div + 1) * ADC_CONV_CLOCKS);
+}
+
+const uint32_t * adcBlockGet(void)
+{
+	uint32_t written = adcWritten;
+
+	/* the DMA is filling block written, everything up to one ring behind
+	   it is still intact */
+	if(written - adcRead > ADC_RING_BLOCKS - 1)
+	{
+		adcOverruns += written - adcRead - (ADC_RING_BLOCKS - 1);
+		adcRead = written - (ADC_RING_BLOCKS - 1);
+	}
+
+	if(adcRead == written)
+		return NULL;
+
+	return adcRing[adcRead % ADC_RING_BLOCKS];
+}
+
+void adcBlockRelease(void)
+{
+	adcRead++;
+}
+
+void DMA_IRQHandler(void)
+{
+	if(Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INTTC, adcChannel))
+	{
+		Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTTC, adcChannel);
+		adcWritten++;
+	}
+}
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
@@ -43,6 +43,10 @@
 #include "arm_const_structs.h"
 #include "board.h"
 #include "fft.h"
+#include "adc.h"
+#include "stft.h"
+#include "window.h"
+#include "goertzel.h"
 
 /* -------------------------------------------------------------------
 * External Input and Output buffer Declarations for FFT Bin Example
@@ -57,6 +61,29 @@ uint32_t ifftFlag = 0;
 uint32_t doBitReverse = 1;
 /* Reference index at which max energy of bin ocuurs */
 uint32_t refIndex = 213, testIndex = 0;
+/* ------------------------------------------------------------------
+* Streaming STFT: 75 % overlap, one ADC block per hop
+* ------------------------------------------------------------------- */
+#define STFT_RATE 40000
+/* too big for the 32 KB SRAM next to the test vectors */
+static stft_t stft __attribute__ ((section(".bss.$RAM2")));
+static float32_t hopSamples[ADC_BLOCK_SIZE];
+/* Latest peak, for the debugger */
+volatile float32_t peakHz, peakValue;
+volatile uint32_t spectra;
+/* ------------------------------------------------------------------
+* Goertzel bank on the same samples: a few known tones, 50 Hz bins
+* ------------------------------------------------------------------- */
+#define TONE_LENGTH 800
+#define TONE_THRESHOLD 0.05f
+static const float32_t toneHz[] = {1000, 2000, 5000, 10000};
+static goertzel_t tones;
+/* Bit n set while toneHz[n] is present */
+volatile uint32_t tonesDetected;
+/* DWT cycles per hop of each path */
+volatile uint32_t * DWT_CTRL = (uint32_t *)0xE0001000;
+volatile uint32_t * DWT_CYCCNT = (uint32_t *)0xE0001004;
+volatile uint32_t stftCycles, goertzelCycles;
 /* ----------------------------------------------------------------------
 * Max magnitude FFT Bin test
 * ------------------------------------------------------------------- */
@@ -88,5 +115,54 @@ int main(void)
   {
     while (1);
   }
-  while (1);                             /* main function does not return */
+  /* ----------------------------------------------------------------------
+  ** Continuous analysis of the ADC input
+  ** ------------------------------------------------------------------- */
+  const uint32_t * block;
+  const stftSpectrum_t * spectrum;
+  uint32_t i;
+
+  stftInit(&stft, windowHann, ADC_BLOCK_SIZE);
+  adcInit(STFT_RATE);
+
+  goertzelInit(&tones, TONE_LENGTH);
+  for (i = 0; i < sizeof(toneHz) / sizeof(toneHz[0]); i++)
+  {
+    goertzelAddTone(&tones, toneHz[i], adcRate(), TONE_THRESHOLD);
+  }
+
+  *DWT_CTRL |= 1;
+
+  while (1)                              /* main function does not return */
+  {
+    /* producer: 10 bit samples centered around 0, scaled to +-1 */
+    block = adcBlockGet();
+    if (block)
+    {
+      for (i = 0; i < ADC_BLOCK_SIZE; i++)
+      {
+        hopSamples[i] = ((int32_t)ADC_DR_RESULT(block[i]) - 512) / 512.0f;
+      }
+      adcBlockRelease();
+
+      *DWT_CYCCNT = 0;
+      stftHop(&stft, hopSamples);
+      stftCycles = *DWT_CYCCNT;
+
+      *DWT_CYCCNT = 0;
+      if (goertzelUpdate(&tones, hopSamples, ADC_BLOCK_SIZE))
+      {
+        tonesDetected = tones.detected;
+      }
+      goertzelCycles = *DWT_CYCCNT;
+    }
+    /* consumer: reads the spectrum in place */
+    spectrum = stftAcquire(&stft);
+    if (spectrum)
+    {
+      peakHz = (float32_t)spectrum->peakBin * adcRate() / STFT_SIZE;
+      peakValue = spectrum->peakValue;
+      spectra++;
+    }
+  }
 }
@@ -0,0 +1,162 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief Goertzel tone detector bank
+ **
+ ** s[n] = x[n] + coeff * s[n - 1] - s[n - 2] per tone; after length
+ ** samples the squared magnitude of the tone's DFT term is
+ ** s1^2 + s2^2 - coeff * s1 * s2.
+ **/
+
+/** \addtogroup goertzel tone detector bank
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "goertzel.h"
+
+/*==================[macros and definitions]=================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/* Tone state stays in registers for the whole run */
+static void filter(goertzelTone_t * t, const float32_t * x, uint32_t count)
+{
+	float32_t s0, s1 = t->s1, s2 = t->s2;
+	float32_t coeff = t->coeff;
+
+	while(count--)
+	{
+		s0 = *x++ + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+
+	t->s1 = s1;
+	t->s2 = s2;
+}
+
+static void decide(goertzel_t * g)
+{
+	goertzelTone_t * t;
+	float32_t power;
+	uint32_t i;
+
+	g->detected = 0;
+	for(i = 0; i < g->tones; i++)
+	{
+		t = &g->tone[i];
+		power = t->s1 * t->s1 + t->s2 * t->s2 - t->coeff * t->s1 * t->s2;
+		/* a sine of amplitude A gives A * length / 2 */
+		arm_sqrt_f32(power, &t->amplitude);
+		t->amplitude *= 2.0f / g->length;
+
+		if(t->amplitude > t->threshold)
+			g->detected |= 1 << i;
+
+		t->s1 = 0;
+		t->s2 = 0;
+	}
+
+	g->count = 0;
+	g->blocks++;
+}
+
+/*==================[external functions definition]==========================*/
+
+void goertzelInit(goertzel_t * g, uint32_t length)
+{
+	g->tones = 0;
+	g->length = length;
+	g->count = 0;
+	g->blocks = 0;
+	g->detected = 0;
+}
+
+int goertzelAddTone(goertzel_t * g, float32_t freq, float32_t rate,
+		float32_t threshold)
+{
+	goertzelTone_t * t;
+
+	if(g->tones == GOERTZEL_MAX_TONES)
+		return -1;
+
+	t = &g->tone[g->tones];
+	t->coeff = 2 * arm_cos_f32(2 * PI * freq / rate);
+	t->threshold = threshold;
+	t->s1 = 0;
+	t->s2 = 0;
+	t->amplitude = 0;
+
+	return g->tones++;
+}
+
+int goertzelUpdate(goertzel_t * g, const float32_t * x, uint32_t count)
+{
+	uint32_t chunk, i;
+	int done = 0;
+
+	while(count)
+	{
+		chunk = g->length - g->count;
+		if(chunk > count)
+			chunk = count;
+
+		for(i = 0; i < g->tones; i++)
+			filter(&g->tone[i], x, chunk);
+
+		g->count += chunk;
+		x += chunk;
+		count -= chunk;
+
+		if(g->count == g->length)
+		{
+			decide(g);
+			done = 1;
+		}
+	}
+
+	return done;
+}
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
@@ -0,0 +1,165 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief streaming short-time FFT
+ **
+ ** arm_rfft_fast_f32() packs the real DC and Nyquist bins into the first
+ ** complex pair of its output, every other pair is a complex bin.
+ **/
+
+/** \addtogroup stft short-time FFT
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "stft.h"
+#include "arm_common_tables.h"
+
+/*==================[macros and definitions]=================================*/
+
+#if STFT_SIZE != 1024
+#error stftInit() takes the 1024 point twiddle tables
+#endif
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+/* Publishing and acquiring swap buffer indexes; the interrupt mask keeps
+   them consistent if either side runs from an interrupt handler. */
+static void publish(stft_t * s)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t tmp;
+
+	__disable_irq();
+	tmp = s->ready;
+	s->ready = s->writing;
+	s->writing = tmp;
+	s->fresh = 1;
+	__set_PRIMASK(primask);
+}
+
+/*==================[external functions definition]==========================*/
+
+arm_status stftInit(stft_t * s, const float32_t * window, uint32_t hop)
+{
+	float32_t sum = 0;
+	uint32_t n;
+
+	if(hop == 0 || hop > STFT_SIZE)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	if(arm_rfft_fast_init_f32(&s->rfft, STFT_SIZE) != ARM_MATH_SUCCESS)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	/* the bundled arm_rfft_fast_init_f32() leaves both twiddle pointers unset */
+	s->rfft.Sint.pTwiddle = (float32_t *)twiddleCoef_512;
+	s->rfft.pTwiddleRFFT = (float32_t *)twiddleCoef_rfft_1024;
+
+	/* w[0] and w[N / 2] appear once, every other point twice */
+	for(n = 1; n < STFT_SIZE / 2; n++)
+		sum += window[n];
+	sum = 2 * sum + window[0] + window[STFT_SIZE / 2];
+
+	s->window = window;
+	s->scale = 2 / sum;
+	s->hop = hop;
+	s->frames = 0;
+	s->writing = 0;
+	s->ready = 1;
+	s->reading = 2;
+	s->fresh = 0;
+
+	arm_fill_f32(0, s->frame, STFT_SIZE);
+
+	return ARM_MATH_SUCCESS;
+}
+
+void stftHop(stft_t * s, const float32_t * x)
+{
+	stftSpectrum_t * sp = &s->spectra[s->writing];
+	uint32_t n;
+	uint32_t bin;
+
+	/* slide the new samples in */
+	arm_copy_f32(s->frame + s->hop, s->frame, STFT_SIZE - s->hop);
+	arm_copy_f32((float32_t *)x, s->frame + STFT_SIZE - s->hop, s->hop);
+
+	/* the FFT overwrites its input, the frame is kept for the next hop */
+	arm_mult_f32(s->frame, (float32_t *)s->window, s->work, STFT_SIZE / 2 + 1);
+	for(n = STFT_SIZE / 2 + 1; n < STFT_SIZE; n++)
+		s->work[n] = s->frame[n] * s->window[STFT_SIZE - n];
+
+	arm_rfft_fast_f32(&s->rfft, s->work, s->spectrum, 0);
+
+	sp->magnitude[0] = fabsf(s->spectrum[0]) / 2;
+	sp->magnitude[STFT_SIZE / 2] = fabsf(s->spectrum[1]) / 2;
+	arm_cmplx_mag_f32(s->spectrum + 2, sp->magnitude + 1, STFT_SIZE / 2 - 1);
+	arm_scale_f32(sp->magnitude, s->scale, sp->magnitude, STFT_BINS);
+
+	arm_max_f32(sp->magnitude + 1, STFT_BINS - 1, &sp->peakValue, &bin);
+	sp->peakBin = bin + 1;
+	sp->frame = s->frames++;
+
+	publish(s);
+}
+
+const stftSpectrum_t * stftAcquire(stft_t * s)
+{
+	uint32_t primask;
+	uint8_t tmp;
+
+	if(!s->fresh)
+		return NULL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	tmp = s->reading;
+	s->reading = s->ready;
+	s->ready = tmp;
+	s->fresh = 0;
+	__set_PRIMASK(primask);
+
+	return &s->spectra[s->reading];
+}
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
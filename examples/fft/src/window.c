@@ -0,0 +1,192 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief STFT analysis windows
+ **
+ ** Periodic windows of STFT_SIZE points. Only the first half plus the
+ ** middle point is stored, w[n] = w[STFT_SIZE - n] gives the rest.
+ **/
+
+/** \addtogroup stft short-time FFT
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "window.h"
+
+/*==================[external data definition]===============================*/
+
+/** Hann, 0.5 - 0.5 * cos(2 * pi * n / N): -31 dB sidelobes, sums to a
+ * constant at 50 % and 75 % overlap */
+const float32_t windowHann[STFT_SIZE / 2 + 1] = {
+0.000000000, 0.000009412, 0.000037649, 0.000084709, 0.000150591, 0.000235291, 0.000338808, 0.000461136,
+0.000602272, 0.000762210, 0.000940944, 0.001138467, 0.001354772, 0.001589850, 0.001843694, 0.002116293,
+0.002407637, 0.002717715, 0.003046515, 0.003394025, 0.003760233, 0.004145123, 0.004548682, 0.004970895,
+0.005411745, 0.005871216, 0.006349291, 0.006845951, 0.007361179, 0.007894954, 0.008447256, 0.009018065,
+0.009607360, 0.010215117, 0.010841315, 0.011485929, 0.012148935, 0.012830309, 0.013530024, 0.014248055,
+0.014984373, 0.015738953, 0.016511764, 0.017302779, 0.018111967, 0.018939298, 0.019784740, 0.020648263,
+0.021529832, 0.022429416, 0.023346980, 0.024282490, 0.025235910, 0.026207204, 0.027196337, 0.028203271,
+0.029227967, 0.030270388, 0.031330494, 0.032408245, 0.033503601, 0.034616519, 0.035746960, 0.036894879,
+0.038060234, 0.039242980, 0.040443074, 0.041660470, 0.042895122, 0.044146984, 0.045416008, 0.046702148,
+0.048005353, 0.049325576, 0.050662767, 0.052016875, 0.053387849, 0.054775638, 0.056180190, 0.057601451,
+0.059039368, 0.060493887, 0.061964953, 0.063452511, 0.064956504, 0.066476877, 0.068013572, 0.069566531,
+0.071135695, 0.072721006, 0.074322403, 0.075939828, 0.077573217, 0.079222511, 0.080887647, 0.082568563,
+0.084265194, 0.085977477, 0.087705349, 0.089448743, 0.091207593, 0.092981835, 0.094771401, 0.096576223,
+0.098396234, 0.100231365, 0.102081548, 0.103946711, 0.105826786, 0.107721701, 0.109631386, 0.111555767,
+0.113494773, 0.115448331, 0.117416367, 0.119398807, 0.121395577, 0.123406600, 0.125431803, 0.127471107,
+0.129524437, 0.131591716, 0.133672864, 0.135767805, 0.137876459, 0.139998746, 0.142134587, 0.144283902,
+0.146446609, 0.148622628, 0.150811875, 0.153014270, 0.155229728, 0.157458166, 0.159699501, 0.161953648,
+0.164220523, 0.166500039, 0.168792111, 0.171096653, 0.173413579, 0.175742799, 0.178084229, 0.180437778,
+0.182803358, 0.185180881, 0.187570256, 0.189971394, 0.192384205, 0.194808597, 0.197244479, 0.199691760,
+0.202150348, 0.204620149, 0.207101071, 0.209593021, 0.212095904, 0.214609627, 0.217134095, 0.219669212,
+0.222214883, 0.224771014, 0.227337506, 0.229914264, 0.232501190, 0.235098188, 0.237705159, 0.240322005,
+0.242948628, 0.245584929, 0.248230808, 0.250886167, 0.253550904, 0.256224920, 0.258908114, 0.261600385,
+0.264301632, 0.267011752, 0.269730645, 0.272458206, 0.275194335, 0.277938928, 0.280691881, 0.283453091,
+0.286222453, 0.288999865, 0.291785220, 0.294578414, 0.297379343, 0.300187900, 0.303003980, 0.305827477,
+0.308658284, 0.311496295, 0.314341403, 0.317193501, 0.320052482, 0.322918237, 0.325790660, 0.328669641,
+0.331555073, 0.334446847, 0.337344854, 0.340248985, 0.343159130, 0.346075180, 0.348997025, 0.351924556,
+0.354857661, 0.357796231, 0.360740155, 0.363689322, 0.366643621, 0.369602941, 0.372567170, 0.375536197,
+0.378509910, 0.381488197, 0.384470946, 0.387458044, 0.390449380, 0.393444840, 0.396444312, 0.399447683,
+0.402454839, 0.405465668, 0.408480056, 0.411497890, 0.414519056, 0.417543440, 0.420570928, 0.423601407,
+0.426634763, 0.429670880, 0.432709646, 0.435750945, 0.438794662, 0.441840685, 0.444888896, 0.447939183,
+0.450991430, 0.454045522, 0.457101344, 0.460158781, 0.463217718, 0.466278040, 0.469339632, 0.472402378,
+0.475466163, 0.478530872, 0.481596389, 0.484662598, 0.487729386, 0.490796635, 0.493864231, 0.496932058,
+0.500000000, 0.503067942, 0.506135769, 0.509203365, 0.512270614, 0.515337402, 0.518403611, 0.521469128,
+0.524533837, 0.527597622, 0.530660368, 0.533721960, 0.536782282, 0.539841219, 0.542898656, 0.545954478,
+0.549008570, 0.552060817, 0.555111104, 0.558159315, 0.561205338, 0.564249055, 0.567290354, 0.570329120,
+0.573365237, 0.576398593, 0.579429072, 0.582456560, 0.585480944, 0.588502110, 0.591519944, 0.594534332,
+0.597545161, 0.600552317, 0.603555688, 0.606555160, 0.609550620, 0.612541956, 0.615529054, 0.618511803,
+0.621490090, 0.624463803, 0.627432830, 0.630397059, 0.633356379, 0.636310678, 0.639259845, 0.642203769,
+0.645142339, 0.648075444, 0.651002975, 0.653924820, 0.656840870, 0.659751015, 0.662655146, 0.665553153,
+0.668444927, 0.671330359, 0.674209340, 0.677081763, 0.679947518, 0.682806499, 0.685658597, 0.688503705,
+0.691341716, 0.694172523, 0.696996020, 0.699812100, 0.702620657, 0.705421586, 0.708214780, 0.711000135,
+0.713777547, 0.716546909, 0.719308119, 0.722061072, 0.724805665, 0.727541794, 0.730269355, 0.732988248,
+0.735698368, 0.738399615, 0.741091886, 0.743775080, 0.746449096, 0.749113833, 0.751769192, 0.754415071,
+0.757051372, 0.759677995, 0.762294841, 0.764901812, 0.767498810, 0.770085736, 0.772662494, 0.775228986,
+0.777785117, 0.780330788, 0.782865905, 0.785390373, 0.787904096, 0.790406979, 0.792898929, 0.795379851,
+0.797849652, 0.800308240, 0.802755521, 0.805191403, 0.807615795, 0.810028606, 0.812429744, 0.814819119,
+0.817196642, 0.819562222, 0.821915771, 0.824257201, 0.826586421, 0.828903347, 0.831207889, 0.833499961,
+0.835779477, 0.838046352, 0.840300499, 0.842541834, 0.844770272, 0.846985730, 0.849188125, 0.851377372,
+0.853553391, 0.855716098, 0.857865413, 0.860001254, 0.862123541, 0.864232195, 0.866327136, 0.868408284,
+0.870475563, 0.872528893, 0.874568197, 0.876593400, 0.878604423, 0.880601193, 0.882583633, 0.884551669,
+0.886505227, 0.888444233, 0.890368614, 0.892278299, 0.894173214, 0.896053289, 0.897918452, 0.899768635,
+0.901603766, 0.903423777, 0.905228599, 0.907018165, 0.908792407, 0.910551257, 0.912294651, 0.914022523,
+0.915734806, 0.917431437, 0.919112353, 0.920777489, 0.922426783, 0.924060172, 0.925677597, 0.927278994,
+0.928864305, 0.930433469, 0.931986428, 0.933523123, 0.935043496, 0.936547489, 0.938035047, 0.939506113,
+0.940960632, 0.942398549, 0.943819810, 0.945224362, 0.946612151, 0.947983125, 0.949337233, 0.950674424,
+0.951994647, 0.953297852, 0.954583992, 0.955853016, 0.957104878, 0.958339530, 0.959556926, 0.960757020,
+0.961939766, 0.963105121, 0.964253040, 0.965383481, 0.966496399, 0.967591755, 0.968669506, 0.969729612,
+0.970772033, 0.971796729, 0.972803663, 0.973792796, 0.974764090, 0.975717510, 0.976653020, 0.977570584,
+0.978470168, 0.979351737, 0.980215260, 0.981060702, 0.981888033, 0.982697221, 0.983488236, 0.984261047,
+0.985015627, 0.985751945, 0.986469976, 0.987169691, 0.987851065, 0.988514071, 0.989158685, 0.989784883,
+0.990392640, 0.990981935, 0.991552744, 0.992105046, 0.992638821, 0.993154049, 0.993650709, 0.994128784,
+0.994588255, 0.995029105, 0.995451318, 0.995854877, 0.996239767, 0.996605975, 0.996953485, 0.997282285,
+0.997592363, 0.997883707, 0.998156306, 0.998410150, 0.998645228, 0.998861533, 0.999059056, 0.999237790,
+0.999397728, 0.999538864, 0.999661192, 0.999764709, 0.999849409, 0.999915291, 0.999962351, 0.999990588,
+1.000000000
+};
+
+/** Blackman, 0.42 - 0.5 * cos(2 * pi * n / N) + 0.08 * cos(4 * pi * n / N):
+ * -58 dB sidelobes for peaks next to strong tones, sums to a constant at
+ * 75 % overlap */
+const float32_t windowBlackman[STFT_SIZE / 2 + 1] = {
+-0.000000000, 0.000003389, 0.000013555, 0.000030500, 0.000054227, 0.000084740, 0.000122044, 0.000166145,
+0.000217050, 0.000274767, 0.000339306, 0.000410678, 0.000488892, 0.000573964, 0.000665905, 0.000764732,
+0.000870459, 0.000983104, 0.001102685, 0.001229222, 0.001362733, 0.001503241, 0.001650768, 0.001805336,
+0.001966972, 0.002135699, 0.002311545, 0.002494537, 0.002684704, 0.002882075, 0.003086680, 0.003298552,
+0.003517722, 0.003744225, 0.003978095, 0.004219367, 0.004468078, 0.004724266, 0.004987968, 0.005259224,
+0.005538075, 0.005824560, 0.006118724, 0.006420608, 0.006730256, 0.007047713, 0.007373026, 0.007706239,
+0.008047401, 0.008396560, 0.008753765, 0.009119065, 0.009492512, 0.009874157, 0.010264052, 0.010662249,
+0.011068804, 0.011483769, 0.011907202, 0.012339157, 0.012779691, 0.013228861, 0.013686726, 0.014153345,
+0.014628776, 0.015113080, 0.015606318, 0.016108550, 0.016619839, 0.017140246, 0.017669836, 0.018208671,
+0.018756816, 0.019314336, 0.019881294, 0.020457758, 0.021043794, 0.021639467, 0.022244845, 0.022859996,
+0.023484986, 0.024119886, 0.024764762, 0.025419685, 0.026084724, 0.026759948, 0.027445427, 0.028141232,
+0.028847434, 0.029564103, 0.030291310, 0.031029127, 0.031777625, 0.032536876, 0.033306952, 0.034087926,
+0.034879868, 0.035682853, 0.036496952, 0.037322237, 0.038158782, 0.039006659, 0.039865940, 0.040736699,
+0.041619008, 0.042512941, 0.043418568, 0.044335964, 0.045265201, 0.046206350, 0.047159485, 0.048124677,
+0.049101999, 0.050091522, 0.051093318, 0.052107459, 0.053134015, 0.054173057, 0.055224657, 0.056288884,
+0.057365809, 0.058455501, 0.059558029, 0.060673464, 0.061801872, 0.062943324, 0.064097886, 0.065265625,
+0.066446609, 0.067640905, 0.068848577, 0.070069692, 0.071304314, 0.072552507, 0.073814336, 0.075089863,
+0.076379151, 0.077682262, 0.078999257, 0.080330197, 0.081675141, 0.083034148, 0.084407277, 0.085794587,
+0.087196132, 0.088611970, 0.090042157, 0.091486745, 0.092945790, 0.094419344, 0.095907459, 0.097410185,
+0.098927574, 0.100459673, 0.102006532, 0.103568198, 0.105144716, 0.106736133, 0.108342492, 0.109963836,
+0.111600209, 0.113251650, 0.114918201, 0.116599899, 0.118296783, 0.120008889, 0.121736252, 0.123478908,
+0.125236889, 0.127010227, 0.128798953, 0.130603096, 0.132422684, 0.134257745, 0.136108304, 0.137974386,
+0.139856013, 0.141753207, 0.143665989, 0.145594378, 0.147538391, 0.149498044, 0.151473353, 0.153464332,
+0.155470991, 0.157493341, 0.159531393, 0.161585152, 0.163654627, 0.165739820, 0.167840736, 0.169957377,
+0.172089741, 0.174237829, 0.176401636, 0.178581159, 0.180776392, 0.182987326, 0.185213952, 0.187456260,
+0.189714237, 0.191987869, 0.194277140, 0.196582032, 0.198902527, 0.201238604, 0.203590240, 0.205957412,
+0.208340092, 0.210738255, 0.213151870, 0.215580907, 0.218025332, 0.220485113, 0.222960211, 0.225450590,
+0.227956209, 0.230477027, 0.233013002, 0.235564087, 0.238130236, 0.240711401, 0.243307531, 0.245918574,
+0.248544476, 0.251185181, 0.253840632, 0.256510769, 0.259195530, 0.261894854, 0.264608674, 0.267336924,
+0.270079536, 0.272836439, 0.275607560, 0.278392827, 0.281192162, 0.284005488, 0.286832726, 0.289673793,
+0.292528607, 0.295397083, 0.298279132, 0.301174668, 0.304083597, 0.307005829, 0.309941269, 0.312889820,
+0.315851385, 0.318825863, 0.321813152, 0.324813149, 0.327825749, 0.330850844, 0.333888325, 0.336938082,
+0.340000000, 0.343073966, 0.346159864, 0.349257574, 0.352366978, 0.355487953, 0.358620375, 0.361764119,
+0.364919059, 0.368085065, 0.371262005, 0.374449749, 0.377648161, 0.380857106, 0.384076445, 0.387306039,
+0.390545748, 0.393795427, 0.397054933, 0.400324119, 0.403602837, 0.406890938, 0.410188269, 0.413494678,
+0.416810010, 0.420134109, 0.423466817, 0.426807974, 0.430157419, 0.433514989, 0.436880520, 0.440253846,
+0.443634798, 0.447023209, 0.450418908, 0.453821721, 0.457231477, 0.460647998, 0.464071110, 0.467500633,
+0.470936389, 0.474378195, 0.477825871, 0.481279230, 0.484738090, 0.488202262, 0.491671559, 0.495145792,
+0.498624770, 0.502108300, 0.505596190, 0.509088244, 0.512584268, 0.516084063, 0.519587432, 0.523094175,
+0.526604090, 0.530116977, 0.533632632, 0.537150851, 0.540671428, 0.544194157, 0.547718830, 0.551245239,
+0.554773174, 0.558302423, 0.561832776, 0.565364020, 0.568895941, 0.572428323, 0.575960953, 0.579493612,
+0.583026084, 0.586558150, 0.590089592, 0.593620189, 0.597149720, 0.600677965, 0.604204700, 0.607729703,
+0.611252750, 0.614773616, 0.618292076, 0.621807905, 0.625320877, 0.628830763, 0.632337336, 0.635840370,
+0.639339633, 0.642834898, 0.646325935, 0.649812513, 0.653294402, 0.656771372, 0.660243189, 0.663709623,
+0.667170442, 0.670625413, 0.674074302, 0.677516879, 0.680952907, 0.684382156, 0.687804389, 0.691219375,
+0.694626878, 0.698026665, 0.701418500, 0.704802150, 0.708177381, 0.711543957, 0.714901645, 0.718250209,
+0.721589416, 0.724919031, 0.728238820, 0.731548549, 0.734847984, 0.738136890, 0.741415035, 0.744682185,
+0.747938106, 0.751182567, 0.754415334, 0.757636175, 0.760844858, 0.764041153, 0.767224826, 0.770395649,
+0.773553391, 0.776697821, 0.779828711, 0.782945832, 0.786048955, 0.789137854, 0.792212301, 0.795272069,
+0.798316934, 0.801346669, 0.804361051, 0.807359856, 0.810342861, 0.813309844, 0.816260584, 0.819194860,
+0.822112452, 0.825013143, 0.827896713, 0.830762947, 0.833611628, 0.836442541, 0.839255473, 0.842050210,
+0.844826540, 0.847584253, 0.850323138, 0.853042988, 0.855743595, 0.858424752, 0.861086254, 0.863727898,
+0.866349481, 0.868950801, 0.871531658, 0.874091854, 0.876631190, 0.879149471, 0.881646503, 0.884122091,
+0.886576044, 0.889008171, 0.891418283, 0.893806193, 0.896171715, 0.898514664, 0.900834857, 0.903132112,
+0.905406251, 0.907657094, 0.909884466, 0.912088190, 0.914268095, 0.916424008, 0.918555760, 0.920663183,
+0.922746109, 0.924804376, 0.926837819, 0.928846278, 0.930829594, 0.932787610, 0.934720169, 0.936627120,
+0.938508309, 0.940363587, 0.942192807, 0.943995822, 0.945772489, 0.947522667, 0.949246214, 0.950942993,
+0.952612869, 0.954255707, 0.955871377, 0.957459748, 0.959020693, 0.960554086, 0.962059805, 0.963537728,
+0.964987737, 0.966409714, 0.967803545, 0.969169118, 0.970506322, 0.971815049, 0.973095195, 0.974346655,
+0.975569328, 0.976763115, 0.977927920, 0.979063649, 0.980170208, 0.981247510, 0.982295466, 0.983313991,
+0.984303003, 0.985262421, 0.986192168, 0.987092167, 0.987962346, 0.988802635, 0.989612964, 0.990393267,
+0.991143482, 0.991863547, 0.992553403, 0.993212995, 0.993842268, 0.994441171, 0.995009655, 0.995547675,
+0.996055186, 0.996532146, 0.996978517, 0.997394263, 0.997779349, 0.998133744, 0.998457419, 0.998750348,
+0.999012506, 0.999243873, 0.999444429, 0.999614158, 0.999753046, 0.999861082, 0.999938256, 0.999984564,
+1.000000000
+};
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
@@ -42,6 +42,7 @@
 
 #include "board.h"
 #include "ff.h"
+#include "diskio.h"
 
 /*==================[macros and definitions]=================================*/
 
@@ -73,6 +74,9 @@ static void initHardware(void)
 	Chip_SSP_Init(LPC_SSP1);
 	Chip_SSP_Enable(LPC_SSP1);
 
+	/* mmc.c takes two GPDMA channels for SSP1 on disk_initialize() */
+	Chip_GPDMA_Init(LPC_GPDMA);
+
 	/* EDU-CIAA USART2 configuration */
 	// P7_1 pin -> U2_TXD @ FUNC6 [UM:Table 190]
 	// P7_2 pin -> U2_RXD @ FUNC6
@@ -97,6 +101,11 @@ void SysTick_Handler(void)
 	}
 }
 
+void DMA_IRQHandler(void)
+{
+	disk_dmaproc();     /* SD data block transfer completion */
+}
+
 int main(void)
 {
 	UINT nbytes;
@@ -40,6 +40,7 @@
 /*==================[inclusions]=============================================*/
 
 #include "arm_math.h"
+#include "trilat.h"
 
 /*==================[cplusplus]==============================================*/
 
@@ -51,13 +52,6 @@ extern "C" {
 
 /*==================[typedef]================================================*/
 
-typedef struct _p3d
-{
-	float32_t x;
-	float32_t y;
-	float32_t z;
-}p3d;
-
 /*==================[external data declaration]==============================*/
 
 /*==================[external functions declaration]=========================*/
@@ -0,0 +1,133 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _TRILAT_H_
+#define _TRILAT_H_
+
+/** \addtogroup trilat trilateration
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "arm_math.h"
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*==================[macros]=================================================*/
+
+/** anchors a solver can hold, at least 4 are needed for a 3D fix */
+#define TRILAT_MAX_ANCHORS	16
+
+/*==================[typedef]================================================*/
+
+typedef struct _p3d
+{
+	float32_t x;
+	float32_t y;
+	float32_t z;
+}p3d;
+
+/** Least squares trilateration against a fixed anchor set.
+ *
+ * Subtracting the sphere of anchor 0 from the others leaves A x = b, with
+ * A rows ref[i] - ref[0] and b[i] = (r[0]^2 - r[i]^2 + |ref[i] - ref[0]|^2) / 2.
+ * A only depends on the anchors, so (A'A)^-1 A' is computed once and
+ * folded with the constant part of b into
+ *
+ *     x = offset + w * (r[0]^2 ... r[N-1]^2)'
+ *
+ * which is all trilatSolve() evaluates: N squares and 3 N products. */
+typedef struct
+{
+	uint32_t anchors;
+	p3d ref[TRILAT_MAX_ANCHORS];
+	float32_t ata[3 * 3];							/**< A'A, kept for trilatSetAnchor() */
+	float32_t w[3][TRILAT_MAX_ANCHORS];				/**< weights of r[i]^2 */
+	float32_t offset[3];
+}trilat_t;
+
+/*==================[external data declaration]==============================*/
+
+/*==================[external functions declaration]=========================*/
+
+/** @brief prepares a solver for a set of anchors
+ * @param t        solver
+ * @param ref      anchors, copied
+ * @param anchors  4 to TRILAT_MAX_ANCHORS
+ * @return ARM_MATH_SUCCESS, ARM_MATH_ARGUMENT_ERROR for a bad anchor count
+ *         or ARM_MATH_SINGULAR when the anchors are coplanar
+ */
+arm_status trilatInit(trilat_t * t, const p3d * ref, uint32_t anchors);
+
+/** @brief moves one anchor
+ *
+ * Anchor 0 is the origin of every row of A, moving it rebuilds the whole
+ * solver. Any other anchor only changes one row: A'A gets a rank one
+ * downdate and update instead of being rebuilt.
+ *
+ * @param t  solver
+ * @param i  anchor index
+ * @param p  new position
+ * @return as trilatInit(); on error the solver keeps the previous anchors
+ */
+arm_status trilatSetAnchor(trilat_t * t, uint32_t i, p3d p);
+
+/** @brief position from one set of measured distances
+ * @param t  solver
+ * @param r  distance to each anchor, in anchor order
+ * @return least squares position
+ */
+p3d trilatSolve(const trilat_t * t, const float32_t * r);
+
+/** @brief positions from several sets of measured distances
+ * @param t      solver
+ * @param r      fixes rows of t->anchors distances each
+ * @param fixes  number of rows
+ * @param out    fixes positions
+ */
+void trilatSolveBatch(const trilat_t * t, const float32_t * r, uint32_t fixes, p3d * out);
+
+/*==================[cplusplus]==============================================*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} doxygen end group definition */
+/*==================[end of file]============================================*/
+#endif /* #ifndef _TRILAT_H_ */
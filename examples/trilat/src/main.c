@@ -42,6 +42,10 @@
 
 /*==================[macros and definitions]=================================*/
 
+/** anclas usadas y mediciones del lote de trilatSolveBatch() */
+#define ANCLAS	8
+#define FIXES	32
+
 /*==================[internal data declaration]==============================*/
 
 /*==================[internal functions declaration]=========================*/
@@ -53,8 +57,22 @@ static void initHardware(void);
 
 /*==================[internal data definition]===============================*/
 
+static trilat_t solver;
+static float32_t lote[FIXES][ANCLAS];
+static p3d posiciones[FIXES];
+
 /*==================[external data definition]===============================*/
 
+volatile uint32_t * DWT_CTRL   = (uint32_t *)0xE0001000;
+volatile uint32_t * DWT_CYCCNT = (uint32_t *)0xE0001004;
+
+/** ciclos de trilaterate(), de trilatInit(), de trilatSolve() y por fix de
+ * trilatSolveBatch() */
+volatile uint32_t ciclos_trilaterate, ciclos_init, ciclos_solve, ciclos_fix;
+
+/** diferencia maxima entre trilaterate() y trilatSolve(), por componente */
+volatile float32_t error_solver;
+
 /*==================[internal functions definition]==========================*/
 
 static void initHardware(void)
@@ -190,7 +208,47 @@ int main(void)
 	};
 
 
-	p = trilaterate(referencias, distancias, 8);
+	p3d q, mueve = {9,1,2};
+	uint32_t i, j;
+
+	*DWT_CTRL  |= 1;
+
+	*DWT_CYCCNT = 0;
+	p = trilaterate(referencias, distancias, ANCLAS);
+	ciclos_trilaterate = *DWT_CYCCNT;
+
+	//misma solucion con la pseudo inversa precalculada
+	*DWT_CYCCNT = 0;
+	trilatInit(&solver, referencias, ANCLAS);
+	ciclos_init = *DWT_CYCCNT;
+
+	*DWT_CYCCNT = 0;
+	q = trilatSolve(&solver, distancias);
+	ciclos_solve = *DWT_CYCCNT;
+
+	error_solver = fabsf(q.x - p.x);
+	if (fabsf(q.y - p.y) > error_solver)
+		error_solver = fabsf(q.y - p.y);
+	if (fabsf(q.z - p.z) > error_solver)
+		error_solver = fabsf(q.z - p.z);
+
+	//lote de mediciones sin error a lo largo de una recta, con una ancla
+	//movida de lugar
+	trilatSetAnchor(&solver, 3, mueve);
+	referencias[3] = mueve;
+
+	for(i = 0; i < FIXES; i++)
+	{
+		q.x = i * 0.25f;
+		q.y = -1;
+		q.z = 4 - i * 0.1f;
+		for(j = 0; j < ANCLAS; j++)
+			lote[i][j] = dist3d(referencias[j], q);
+	}
+
+	*DWT_CYCCNT = 0;
+	trilatSolveBatch(&solver, &lote[0][0], FIXES, posiciones);
+	ciclos_fix = *DWT_CYCCNT / FIXES;
 
 
 	return 0 ;
@@ -0,0 +1,219 @@
+/* Copyright 2016, Pablo Ridolfi
+ * All rights reserved.
+ *
+ * This file is part of Workspace.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/** @brief least squares trilateration solver
+ **
+ **/
+
+/** \addtogroup trilat trilateration
+ ** @{ */
+
+/*==================[inclusions]=============================================*/
+
+#include "trilat.h"
+
+#include <string.h>
+
+/*==================[macros and definitions]=================================*/
+
+/*==================[internal data declaration]==============================*/
+
+/*==================[internal functions declaration]=========================*/
+
+/** @brief ata += sign * a a' */
+static void ataAdd(float32_t * ata, p3d a, float32_t sign);
+
+/** @brief row of A for anchor i, i > 0 */
+static p3d rowOf(const p3d * ref, uint32_t i);
+
+/** @brief computes the solver weights for ref and its A'A
+ *
+ * t is only written once A'A has been inverted, so a failed call leaves
+ * it untouched.
+ */
+static arm_status trilatBuild(trilat_t * t, const p3d * ref, const float32_t * ata, uint32_t anchors);
+
+/*==================[internal data definition]===============================*/
+
+/*==================[external data definition]===============================*/
+
+/*==================[internal functions definition]==========================*/
+
+static void ataAdd(float32_t * ata, p3d a, float32_t sign)
+{
+	float32_t v[3] = {a.x, a.y, a.z};
+	uint32_t i, j;
+
+	for(i = 0; i < 3; i++)
+		for(j = 0; j < 3; j++)
+			ata[3 * i + j] += sign * v[i] * v[j];
+}
+
+static p3d rowOf(const p3d * ref, uint32_t i)
+{
+	p3d a = {ref[i].x - ref[0].x, ref[i].y - ref[0].y, ref[i].z - ref[0].z};
+
+	return a;
+}
+
+static arm_status trilatBuild(trilat_t * t, const p3d * ref, const float32_t * ata, uint32_t anchors)
+{
+	uint32_t rows = anchors - 1;
+	float32_t srcData[3 * 3];
+	float32_t invData[3 * 3];
+	float32_t atData[3 * (TRILAT_MAX_ANCHORS - 1)];
+	float32_t pData[3 * (TRILAT_MAX_ANCHORS - 1)];
+	arm_matrix_instance_f32 matSrc = {3, 3, srcData};
+	arm_matrix_instance_f32 matInv = {3, 3, invData};
+	arm_matrix_instance_f32 matAT = {3, rows, atData};
+	arm_matrix_instance_f32 matP = {3, rows, pData};
+	arm_status s;
+	uint32_t i, j;
+	p3d a;
+	float32_t k;
+
+	//arm_mat_inverse_f32 destruye la matriz fuente
+	memcpy(srcData, ata, sizeof(srcData));
+	s = arm_mat_inverse_f32(&matSrc, &matInv);
+	if (s != ARM_MATH_SUCCESS)
+		return s;
+
+	//A' -> P = (A'A)^-1 * A'
+	for(i = 0; i < rows; i++)
+	{
+		a = rowOf(ref, i + 1);
+		atData[i] = a.x;
+		atData[rows + i] = a.y;
+		atData[2 * rows + i] = a.z;
+	}
+	s = arm_mat_mult_f32(&matInv, &matAT, &matP);
+	if (s != ARM_MATH_SUCCESS)
+		return s;
+
+	if (t->ref != ref)
+		memcpy(t->ref, ref, anchors * sizeof(p3d));
+	memcpy(t->ata, ata, sizeof(t->ata));
+	t->anchors = anchors;
+
+	//b[i] = r[0]^2/2 - r[i+1]^2/2 + |A[i]|^2/2: la parte constante va al
+	//offset, la de r[0]^2 se junta de todas las filas en w[][0]
+	t->offset[0] = ref[0].x;
+	t->offset[1] = ref[0].y;
+	t->offset[2] = ref[0].z;
+	for(j = 0; j < 3; j++)
+		t->w[j][0] = 0;
+
+	for(i = 0; i < rows; i++)
+	{
+		a = rowOf(ref, i + 1);
+		k = (a.x * a.x + a.y * a.y + a.z * a.z) / 2;
+		for(j = 0; j < 3; j++)
+		{
+			t->offset[j] += pData[j * rows + i] * k;
+			t->w[j][0] += pData[j * rows + i] / 2;
+			t->w[j][i + 1] = -pData[j * rows + i] / 2;
+		}
+	}
+
+	return ARM_MATH_SUCCESS;
+}
+
+/*==================[external functions definition]==========================*/
+
+arm_status trilatInit(trilat_t * t, const p3d * ref, uint32_t anchors)
+{
+	float32_t ata[3 * 3] = {0};
+	uint32_t i;
+
+	if (anchors < 4 || anchors > TRILAT_MAX_ANCHORS)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	for(i = 1; i < anchors; i++)
+		ataAdd(ata, rowOf(ref, i), 1);
+
+	return trilatBuild(t, ref, ata, anchors);
+}
+
+arm_status trilatSetAnchor(trilat_t * t, uint32_t i, p3d p)
+{
+	p3d ref[TRILAT_MAX_ANCHORS];
+	float32_t ata[3 * 3];
+
+	if (i >= t->anchors)
+		return ARM_MATH_ARGUMENT_ERROR;
+
+	memcpy(ref, t->ref, t->anchors * sizeof(p3d));
+	ref[i] = p;
+
+	if (i == 0)
+		return trilatInit(t, ref, t->anchors);
+
+	memcpy(ata, t->ata, sizeof(ata));
+	ataAdd(ata, rowOf(t->ref, i), -1);
+	ataAdd(ata, rowOf(ref, i), 1);
+
+	return trilatBuild(t, ref, ata, t->anchors);
+}
+
+p3d trilatSolve(const trilat_t * t, const float32_t * r)
+{
+	p3d res = {t->offset[0], t->offset[1], t->offset[2]};
+	float32_t r2;
+	uint32_t i;
+
+	for(i = 0; i < t->anchors; i++)
+	{
+		r2 = r[i] * r[i];
+		res.x += t->w[0][i] * r2;
+		res.y += t->w[1][i] * r2;
+		res.z += t->w[2][i] * r2;
+	}
+
+	return res;
+}
+
+void trilatSolveBatch(const trilat_t * t, const float32_t * r, uint32_t fixes, p3d * out)
+{
+	uint32_t n = t->anchors;
+
+	while (fixes--)
+	{
+		*out++ = trilatSolve(t, r);
+		r += n;
+	}
+}
+
+/** @} doxygen end group definition */
+
+/*==================[end of file]============================================*/
@@ -103,6 +103,10 @@ typedef struct {
 	DWORD	dirbase;		/* Root directory start sector (FAT32:Cluster#) */
 	DWORD	database;		/* Data start sector */
 	DWORD	winsect;		/* Current sector appearing in the win[] */
+#if _USE_STATS
+	DWORD	n_direct;		/* Bytes transferred directly to/from caller buffers */
+	DWORD	n_copied;		/* Bytes copied through the sector buffer */
+#endif
 	BYTE	win[_MAX_SS];	/* Disk access window for Directory, FAT (and Data on tiny cfg) */
 } FATFS;
 
@@ -52,6 +52,15 @@
 /* To enable fast seek feature, set _USE_FASTSEEK to 1. */
 
 
+#ifndef _USE_STATS
+#define	_USE_STATS	0	/* 0:Disable or 1:Enable */
+#endif
+/* To count the bytes f_read/f_write move directly between the disk and the
+/  caller buffer (n_direct) and through the sector buffer (n_copied), set
+/  _USE_STATS to 1, ie with SYMBOLS += -D_USE_STATS=1 in the project Makefile.
+/  Only whole sectors at sector aligned file offsets go direct. */
+
+
 
 /*---------------------------------------------------------------------------/
 / Locale and Namespace Configurations
@@ -2265,6 +2265,9 @@ FRESULT f_mount (
 
 	if (fs) {
 		fs->fs_type = 0;		/* Clear new fs object */
+#if _USE_STATS
+		fs->n_direct = fs->n_copied = 0;
+#endif
 #if _FS_REENTRANT				/* Create sync object for the new volume */
 		if (!ff_cre_syncobj(vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -2475,6 +2478,9 @@ FRESULT f_read (
 #endif
 #endif
 				rcnt = SS(fp->fs) * cc;			/* Number of bytes transferred */
+#if _USE_STATS
+				fp->fs->n_direct += rcnt;
+#endif
 				continue;
 			}
 #if !_FS_TINY
@@ -2500,6 +2506,9 @@ FRESULT f_read (
 		mem_cpy(rbuff, &fp->fs->win[fp->fptr % SS(fp->fs)], rcnt);	/* Pick partial sector */
 #else
 		mem_cpy(rbuff, &fp->buf[fp->fptr % SS(fp->fs)], rcnt);	/* Pick partial sector */
+#endif
+#if _USE_STATS
+		fp->fs->n_copied += rcnt;
 #endif
 	}
 
@@ -2591,6 +2600,9 @@ FRESULT f_write (
 				}
 #endif
 				wcnt = SS(fp->fs) * cc;		/* Number of bytes transferred */
+#if _USE_STATS
+				fp->fs->n_direct += wcnt;
+#endif
 				continue;
 			}
 #if _FS_TINY
@@ -2617,6 +2629,9 @@ FRESULT f_write (
 #else
 		mem_cpy(&fp->buf[fp->fptr % SS(fp->fs)], wbuff, wcnt);	/* Fit partial sector */
 		fp->flag |= FA__DIRTY;
+#endif
+#if _USE_STATS
+		fp->fs->n_copied += wcnt;
 #endif
 	}
 
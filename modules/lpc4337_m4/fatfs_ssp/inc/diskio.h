@@ -37,6 +37,13 @@ DSTATUS disk_status (BYTE);
 DRESULT disk_read (BYTE, BYTE*, DWORD, UINT);
 DRESULT disk_write (BYTE, const BYTE*, DWORD, UINT);
 DRESULT disk_ioctl (BYTE, BYTE, void*);
+void disk_timerproc (void);
+void disk_dmaproc (void);
+
+/* Scheduling hooks (weak, may be overridden by an RTOS) */
+void disk_sleep (void);
+void disk_wakeup (void);
+void disk_yield (void);
 
 
 /* Disk Status Bits (DSTATUS) */
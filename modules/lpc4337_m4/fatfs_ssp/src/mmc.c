@@ -34,8 +34,14 @@
 #define CS_LOW()    Chip_GPIO_SetPinOutLow(LPC_GPIO_PORT, 3, 0)
 #define CS_HIGH()   Chip_GPIO_SetPinOutHigh(LPC_GPIO_PORT, 3, 0)
 
-#define	FCLK_SLOW()					/* Set slow clock (100k-400k) */
-#define	FCLK_FAST()					/* Set fast clock (depends on the CSD) */
+#define	FCLK_SLOW()	Chip_SSP_SetBitRate(LPC_SSP1, 400000)	/* Set slow clock (100k-400k) */
+#define	FCLK_FAST()	Chip_SSP_SetBitRate(LPC_SSP1, 25000000)	/* Set fast clock (depends on the CSD) */
+
+/* GPDMA transfer status */
+#define DMA_IDLE	0
+#define DMA_BUSY	1
+#define DMA_DONE	2
+#define DMA_ERROR	3
 
 
 /*--------------------------------------------------------------------------
@@ -53,6 +59,15 @@ BYTE Timer1, Timer2;	/* 100Hz decrement timer */
 static
 BYTE CardType;			/* Card type flags */
 
+static volatile
+BYTE DmaStat = DMA_IDLE;	/* GPDMA transfer status */
+
+static
+BYTE DmaTxCh, DmaRxCh;	/* GPDMA channels for SSP1 Tx/Rx */
+
+static
+BYTE DmaFill = 0xFF, DmaSink;	/* Source/sink for the unused direction */
+
 static void SSPSend(uint8_t *buf, uint32_t Length)
 {
     Chip_SSP_DATA_SETUP_T xferConfig;
@@ -80,6 +95,138 @@ void SSPReceive( uint8_t *buf, uint32_t Length )
 }
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Scheduling hooks  (Platform dependent)                                */
+/*-----------------------------------------------------------------------*/
+/* disk_sleep() is called while a data block is moved by the GPDMA and   */
+/* disk_yield() between polls of a busy card. disk_wakeup() is called    */
+/* from disk_dmaproc() when the transfer ends. The defaults sleep the    */
+/* core until the next event; an RTOS may override them to block the     */
+/* calling task on a semaphore released by disk_wakeup().                */
+
+__attribute__((weak))
+void disk_sleep (void)
+{
+	__WFE();
+}
+
+__attribute__((weak))
+void disk_wakeup (void)
+{
+}
+
+__attribute__((weak))
+void disk_yield (void)
+{
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Transfer a data block by GPDMA  (Platform dependent)                  */
+/*-----------------------------------------------------------------------*/
+/* The Rx channel drains SSP1 into the buffer (or DmaSink) while the Tx  */
+/* channel feeds it from the buffer (or a constant 0xFF). Rx finishes    */
+/* last, so its terminal count ends the transfer.                        */
+/* The application initializes the GPDMA (Chip_GPDMA_Init()) beforehand; */
+/* doing it here would free the channels other drivers hold.             */
+
+static
+BOOL dma_init (void)
+{
+	static BOOL ready;
+
+
+	if (ready) return TRUE;
+
+	/* Chip_GPDMA_GetFreeChannel() hands out the lowest free channel, but */
+	/* returns 0 as well when none is left. Rx is taken after Tx, so it   */
+	/* can only be 0 if there were not two channels free. */
+	DmaTxCh = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_SSP1_Tx);
+	DmaRxCh = Chip_GPDMA_GetFreeChannel(LPC_GPDMA, GPDMA_CONN_SSP1_Rx);
+	if (DmaRxCh == 0) {
+		if (DmaTxCh) Chip_GPDMA_Stop(LPC_GPDMA, DmaTxCh);	/* Give back the one taken */
+		return FALSE;
+	}
+
+	NVIC_ClearPendingIRQ(DMA_IRQn);
+	NVIC_EnableIRQ(DMA_IRQn);
+	ready = TRUE;
+
+	return TRUE;
+}
+
+static
+void dma_abort (void)
+{
+	Chip_GPDMA_ChannelCmd(LPC_GPDMA, DmaTxCh, DISABLE);
+	Chip_GPDMA_ChannelCmd(LPC_GPDMA, DmaRxCh, DISABLE);
+	Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTTC, DmaRxCh);
+	Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTERR, DmaTxCh);
+	Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTERR, DmaRxCh);
+
+	while (Chip_SSP_GetStatus(LPC_SSP1, SSP_STAT_BSY));		/* Flush Rx FIFO */
+	while (Chip_SSP_GetStatus(LPC_SSP1, SSP_STAT_RNE))
+		Chip_SSP_ReceiveFrame(LPC_SSP1);
+}
+
+static
+BOOL xfer_dma (
+	const BYTE *tx,		/* Data to be sent (NULL: send 0xFF) */
+	BYTE *rx,			/* Buffer to store received data (NULL: discard) */
+	UINT n				/* Byte count (1..4095) */
+)
+{
+	DMA_TransferDescriptor_t dtx, drx;
+
+
+	drx.src  = GPDMA_CONN_SSP1_Rx;
+	drx.dst  = rx ? (uint32_t)rx : (uint32_t)&DmaSink;
+	drx.lli  = 0;
+	drx.ctrl = GPDMA_DMACCxControl_TransferSize(n)
+			 | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+			 | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+			 | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+			 | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+			 | GPDMA_DMACCxControl_SrcTransUseAHBMaster1
+			 | (rx ? GPDMA_DMACCxControl_DI : 0)
+			 | GPDMA_DMACCxControl_I;
+
+	dtx.src  = tx ? (uint32_t)tx : (uint32_t)&DmaFill;
+	dtx.dst  = GPDMA_CONN_SSP1_Tx;
+	dtx.lli  = 0;
+	dtx.ctrl = GPDMA_DMACCxControl_TransferSize(n)
+			 | GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_4)
+			 | GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_4)
+			 | GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+			 | GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+			 | GPDMA_DMACCxControl_DestTransUseAHBMaster1
+			 | (tx ? GPDMA_DMACCxControl_SI : 0);
+
+	DmaStat = DMA_BUSY;
+	Chip_SSP_DMA_Enable(LPC_SSP1);
+	if (Chip_GPDMA_SGTransfer(LPC_GPDMA, DmaRxCh, &drx, GPDMA_TRANSFERTYPE_P2M_CONTROLLER_DMA) != SUCCESS
+		|| Chip_GPDMA_SGTransfer(LPC_GPDMA, DmaTxCh, &dtx, GPDMA_TRANSFERTYPE_M2P_CONTROLLER_DMA) != SUCCESS) {
+		DmaStat = DMA_ERROR;
+	}
+
+	Timer1 = 10;					/* Wait for completion in timeout of 100ms */
+	while ((DmaStat == DMA_BUSY) && Timer1)
+		disk_sleep();
+
+	Chip_SSP_DMA_Disable(LPC_SSP1);
+	if (DmaStat != DMA_DONE) {
+		DmaStat = DMA_IDLE;
+		dma_abort();
+		return FALSE;
+	}
+	DmaStat = DMA_IDLE;
+
+	return TRUE;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /* Transmit a byte to MMC via SPI  (Platform dependent)                  */
 /*-----------------------------------------------------------------------*/
@@ -105,14 +252,6 @@ BYTE rcvr_spi (void)
     return data;
 }
 
-/* Alternative macro to receive data fast */
-
-#define rcvr_spi_m(dst) \
-    do { \
-        SSPReceive((uint8_t*)(dst), 1); \
-    } while(0)
-
-
 
 
 /*-----------------------------------------------------------------------*/
@@ -127,9 +266,8 @@ BYTE wait_ready (void)
 
 	Timer2 = 50;	/* Wait for ready in timeout of 500ms */
 	rcvr_spi();
-	do
-		res = rcvr_spi();
-	while ((res != 0xFF) && Timer2);
+	while (((res = rcvr_spi()) != 0xFF) && Timer2)
+		disk_yield();
 
 	return res;
 }
@@ -204,17 +342,12 @@ BOOL rcvr_datablock (
 
 
 	Timer1 = 20;
-	do {							/* Wait for data packet in timeout of 200ms */
-		token = rcvr_spi();
-	} while ((token == 0xFF) && Timer1);
+	while (((token = rcvr_spi()) == 0xFF) && Timer1)	/* Wait for data packet in timeout of 200ms */
+		disk_yield();
 	if(token != 0xFE) return FALSE;	/* If not valid data token, retutn with error */
 
-	do {							/* Receive the data block into buffer */
-		rcvr_spi_m(buff++);
-		rcvr_spi_m(buff++);
-		rcvr_spi_m(buff++);
-		rcvr_spi_m(buff++);
-	} while (btr -= 4);
+	if (!xfer_dma(0, buff, btr))	/* Receive the data block into buffer */
+		return FALSE;
 	rcvr_spi();						/* Discard CRC */
 	rcvr_spi();
 
@@ -234,18 +367,15 @@ BOOL xmit_datablock (
 	BYTE token			/* Data/Stop token */
 )
 {
-	BYTE resp, wc;
+	BYTE resp;
 
 
 	if (wait_ready() != 0xFF) return FALSE;
 
 	xmit_spi(token);					/* Xmit data token */
 	if (token != 0xFD) {	/* Is data token */
-		wc = 0;
-		do {							/* Xmit the 512 byte data block to MMC */
-			xmit_spi(*buff++);
-			xmit_spi(*buff++);
-		} while (--wc);
+		if (!xfer_dma(buff, 0, 512))	/* Xmit the 512 byte data block to MMC */
+			return FALSE;
 		xmit_spi(0xFF);					/* CRC (Dummy) */
 		xmit_spi(0xFF);
 		resp = rcvr_spi();				/* Reveive data response */
@@ -325,6 +455,7 @@ DSTATUS disk_initialize (
 	if (drv) return STA_NOINIT;			/* Supports only single drive */
 	if (Stat & STA_NODISK) return Stat;	/* No card in the socket */
 
+	if (!dma_init()) return Stat;		/* No GPDMA channels for SSP1 */
 	power_on();							/* Force socket power on */
 	FCLK_SLOW();
 	for (n = 10; n; n--) rcvr_spi();	/* 80 dummy clocks */
@@ -634,3 +765,29 @@ void disk_timerproc (void)
 	}
 }
 
+
+
+/*-----------------------------------------------------------------------*/
+/* Device DMA Interrupt Procedure  (Platform dependent)                  */
+/*-----------------------------------------------------------------------*/
+/* This function must be called from DMA_IRQHandler                      */
+
+void disk_dmaproc (void)
+{
+	if (DmaStat != DMA_BUSY) return;	/* Not our transfer */
+
+	if (Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INTERR, DmaTxCh)
+		|| Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INTERR, DmaRxCh)) {
+		Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTERR, DmaTxCh);
+		Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTERR, DmaRxCh);
+		DmaStat = DMA_ERROR;
+	}
+	else if (Chip_GPDMA_IntGetStatus(LPC_GPDMA, GPDMA_STAT_INTTC, DmaRxCh)) {
+		Chip_GPDMA_ClearIntPending(LPC_GPDMA, GPDMA_STATCLR_INTTC, DmaRxCh);
+		DmaStat = DMA_DONE;
+	}
+	else return;
+
+	__SEV();						/* Wake up disk_sleep() */
+	disk_wakeup();
+}
@@ -2,6 +2,7 @@
 #include "board.h"
 #include "retrociaa/m4/base/variant.h"
 #include "retrociaa/m4/base/uart_util.h"
+#include "retrociaa/m4/base/binlog.h"
 
 
 #define         MEMPOOL_SIZE            5120
@@ -13,12 +14,16 @@ uint8_t         g_mem[MEMPOOL_SIZE]     ATTR_DataAlign8;
 
 const char *    g_TaskInputName         = "Input";
 const char *    g_TaskLedName           = "Led";
-const char *    g_TaskUartName          = "Uart";
 const char *    g_LedNames[4]           = { "Rojo",
                                             "Verde",
                                             "Azul",
                                             "Amarillo" };
+#ifdef APP_LOG_BINARY
+// El texto solo queda en firmware.axf, se envia su ID (ver binlog.h).
+const char      g_SendMessageText[]     BINLOG_Text =
+#else
 const char *    g_SendMessageText       =
+#endif
                 "Led %1 encendido:\n\r"
                 "\t Tiempo encendido: %2 ms \n\r"
                 "\t Tiempo entre flancos descendentes: %3 ms \n\r"
@@ -78,7 +83,12 @@ void sendMessage (struct LedParams *lp)
     VARIANT_SetUint32   (&args[2], lp->fallTime);
     VARIANT_SetUint32   (&args[3], lp->riseTime);
 
+#ifdef APP_LOG_BINARY
+    BINLOG_Put          (&lp->uart.send, g_SendMessageText, args, 4);
+    UART_Send           (&lp->uart);
+#else
     UART_PutMessageArgs (&lp->uart, g_SendMessageText, args, 4);
+#endif
 }
 
 
@@ -97,14 +107,9 @@ enum OS_Result appDataInit (struct AppData *ad)
     ad->stacks.taskLed
         = MEMPOOL_Block (&ad->mempool,
                             OS_TaskMinBufferSize(OS_TaskType_Generic, NULL)
-                            + 512,
+                            + 256,
                             g_TaskInputName);
 
-    ad->stacks.taskUart
-        = MEMPOOL_Block (&ad->mempool,
-                            OS_TaskMinBufferSize(OS_TaskType_Generic, NULL),
-                            g_TaskUartName);
-
     void * uartRecvBuffer
         = MEMPOOL_Block (&ad->mempool,
                             RECV_BUFFER_SIZE,
@@ -14,14 +14,12 @@
 
 extern const char *g_TaskInputName;
 extern const char *g_TaskLedName;
-extern const char *g_TaskUartName;
 
 
 struct Stacks
 {
     void                    *taskInput;
     void                    *taskLed;
-    void                    *taskUart;
 };
 
 
@@ -99,27 +99,6 @@ OS_TaskRetVal taskLed (OS_TaskParam arg)
 }
 
 
-OS_TaskRetVal taskUart (OS_TaskParam arg)
-{
-    struct LedParams    *ledParams = (struct LedParams *) arg;
-    enum OS_Result      r;
-
-    (void) r;
-
-    while (1)
-    {
-        while (UART_SendPendingCount (&ledParams->uart))
-        {
-            UART_Send (&ledParams->uart);
-        }
-
-        r = OS_TaskDelay (50);
-    }
-
-    return 0;
-}
-
-
 OS_TaskRetVal boot (OS_TaskParam arg)
 {
     struct AppData  *ad = (struct AppData *) arg;
@@ -148,15 +127,6 @@ OS_TaskRetVal boot (OS_TaskParam arg)
         return 3;
     }
 
-    if ((r = OS_TaskStart (ad->stacks.taskUart,
-                                  MEMPOOL_BlockSize(ad->stacks.taskUart),
-                                  taskUart, &ad->ledParams,
-                                  OS_TaskPriority_Kernel1,
-                                  g_TaskUartName)) != OS_Result_OK)
-    {
-        return 4;
-    }
-
     return 0;
 }
 
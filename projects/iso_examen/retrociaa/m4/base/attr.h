@@ -39,8 +39,26 @@
 
 #define ATTR_EnumForceUint32(s)     s ## __FORCE32 = ((uint32_t) - 1)
 #define ATTR_NeverReturn            __attribute__((noreturn))
+// Inlined even at -O0, ie header helpers called from ATTR_RamFunc code that
+// should neither be a call back to flash nor get a RAM copy per user.
+#define ATTR_AlwaysInline           __attribute__((always_inline))
 #define ATTR_DataAlign4             __attribute__ ((aligned (4)))
 #define ATTR_DataAlign8             __attribute__ ((aligned (8)))
+#define ATTR_DataAlign32            __attribute__ ((aligned (32)))
+
+// Hot code and data placement in RamLoc40, a zero wait state SRAM bank apart
+// from the RamLoc32 one holding .bss and the stacks. The linker script copies
+// both sections from flash at startup (.data_RAM2 in the section table).
+// Calls between flash and RAM go through linker veneers, so tag whole call
+// chains instead of isolated functions. Defining ATTR_NO_RAMFUNC leaves
+// everything at its default location, ie to measure the difference.
+#ifndef ATTR_NO_RAMFUNC
+    #define ATTR_RamFunc            __attribute__ ((section (".ramfunc.$RAM2")))
+    #define ATTR_FastData           __attribute__ ((section (".data.$RAM2")))
+#else
+    #define ATTR_RamFunc
+    #define ATTR_FastData
+#endif
 
 uint32_t    ATTR_RoundTo4   (uint32_t size);
 uint32_t    ATTR_RoundTo8   (uint32_t size);
@@ -0,0 +1,215 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Binary log records with deferred (host side) formatting.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "binlog.h"
+#include <string.h>
+
+
+/*
+    Record layout (little endian), before framing:
+
+    varint      message ID (BINLOG_Text address)
+    uint8       argument count (0 to BINLOG_MaxArgs)
+    uint8[]     argument types, one VARIANT_Type per nibble, low nibble first
+    ...         argument values:
+                    VARIANT_TypeUint32  varint
+                    VARIANT_TypeInt32   zigzag varint
+                    VARIANT_TypeFloat   4 bytes IEEE-754
+                    VARIANT_TypePointer 4 bytes
+                    VARIANT_TypeString  varint length + bytes (truncated to
+                                        BINLOG_MAX_STRING_LENGTH)
+
+    Records are COBS encoded and terminated by BINLOG_FrameDelimiter, so the
+    host can resynchronize on any zero byte.
+*/
+
+
+static uint32_t putVarint (uint8_t *p, uint32_t u)
+{
+    uint32_t count = 0;
+
+    while (u >= 0x80)
+    {
+        p[count ++] = (uint8_t)(u | 0x80);
+        u >>= 7;
+    }
+
+    p[count ++] = (uint8_t) u;
+    return count;
+}
+
+
+static uint32_t putRaw32 (uint8_t *p, uint32_t u)
+{
+    p[0] = (uint8_t) u;
+    p[1] = (uint8_t)(u >> 8);
+    p[2] = (uint8_t)(u >> 16);
+    p[3] = (uint8_t)(u >> 24);
+    return 4;
+}
+
+
+// Returns the number of bytes written or 0 if the value does not fit.
+static uint32_t putValue (uint8_t *p, uint32_t room, struct VARIANT *v)
+{
+    // Worst case for any numeric value (5 byte varint).
+    if (room < 5)
+    {
+        return 0;
+    }
+
+    switch (v->type)
+    {
+        case VARIANT_TypeUint32:
+            return putVarint (p, v->u);
+
+        case VARIANT_TypeInt32:
+            return putVarint (p, ((uint32_t) v->i << 1)
+                                    ^ (uint32_t)(v->i >> 31));
+
+        case VARIANT_TypeFloat:
+        {
+            uint32_t u;
+            memcpy (&u, &v->f, sizeof(u));
+            return putRaw32 (p, u);
+        }
+
+        case VARIANT_TypePointer:
+            return putRaw32 (p, (uint32_t) v->p);
+
+        case VARIANT_TypeString:
+        {
+            const char *s = v->s? v->s : "";
+            uint32_t len = 0;
+            while (len < BINLOG_MAX_STRING_LENGTH && s[len])
+            {
+                ++ len;
+            }
+
+            if (len + 1 > room)
+            {
+                len = room - 1;
+            }
+
+            const uint32_t Count = putVarint (p, len);
+            memcpy (&p[Count], s, len);
+            return Count + len;
+        }
+    }
+
+    return 0;
+}
+
+
+// Consistent Overhead Byte Stuffing: no zero bytes are sent inside a frame.
+static void putFrame (struct CYCLIC *c, const uint8_t *data, uint32_t size)
+{
+    while (1)
+    {
+        uint32_t block = 0;
+        while (block < size && block < 254 && data[block])
+        {
+            ++ block;
+        }
+
+        CYCLIC_In (c, (uint8_t)(block + 1));
+        if (block)
+        {
+            CYCLIC_InFromBuffer (c, data, block);
+        }
+
+        // A full 254 byte block carries no implicit zero.
+        const uint32_t Skip = (block < 254)? block + 1 : block;
+        if (Skip > size)
+        {
+            break;
+        }
+
+        data += Skip;
+        size -= Skip;
+
+        if (!size && block == 254)
+        {
+            break;
+        }
+    }
+
+    CYCLIC_In (c, BINLOG_FrameDelimiter);
+}
+
+
+bool BINLOG_Put (struct CYCLIC *c, const char *msgId,
+                 struct VARIANT argValues[], uint32_t argCount)
+{
+    if (!c || !msgId || (argCount && !argValues))
+    {
+        return false;
+    }
+
+    if (argCount > BINLOG_MaxArgs)
+    {
+        argCount = BINLOG_MaxArgs;
+    }
+
+    uint8_t     record[BINLOG_MAX_RECORD_SIZE];
+    uint32_t    size = putVarint (record, (uint32_t) msgId);
+
+    uint8_t *count = &record[size ++];
+    uint8_t *types = &record[size];
+
+    size += (argCount + 1) >> 1;
+    memset (types, 0, (argCount + 1) >> 1);
+
+    uint32_t i;
+    for (i = 0; i < argCount; ++i)
+    {
+        const uint32_t Written = putValue (&record[size],
+                                           sizeof(record) - size,
+                                           &argValues[i]);
+        if (!Written)
+        {
+            break;
+        }
+
+        types[i >> 1] |= (uint8_t)((argValues[i].type & 0x0F)
+                                                        << ((i & 1) << 2));
+        size += Written;
+    }
+
+    *count = (uint8_t) i;
+
+    putFrame (c, record, size);
+
+    return (i == argCount);
+}
@@ -0,0 +1,68 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Binary log records with deferred (host side) formatting.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "cyclic.h"
+#include "variant.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Message texts tagged with BINLOG_Text are placed in the ".binlog" section.
+// The linker script must keep it as a non loaded (INFO) section starting at
+// address 1, ie:
+//
+//      .binlog 1 (INFO) : { KEEP(*(.binlog .binlog.*)) }
+//
+// A text address is its message ID; texts never reach the target flash and
+// must not be dereferenced on the target. The host decoder reads them back
+// from the ELF file (see retrociaa/tools/binlog_decode.py).
+#define BINLOG_Text                 __attribute__((section(".binlog"), used))
+
+// Largest record before COBS framing. Arguments not fitting are dropped.
+#ifndef BINLOG_MAX_RECORD_SIZE
+    #define BINLOG_MAX_RECORD_SIZE  96
+#endif
+
+#ifndef BINLOG_MAX_STRING_LENGTH
+    #define BINLOG_MAX_STRING_LENGTH    32
+#endif
+
+#define BINLOG_MaxArgs              9
+#define BINLOG_FrameDelimiter       0x00
+
+
+bool    BINLOG_Put          (struct CYCLIC *c, const char *msgId,
+                             struct VARIANT argValues[], uint32_t argCount);
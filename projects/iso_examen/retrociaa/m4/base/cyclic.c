@@ -215,6 +215,44 @@ uint32_t CYCLIC_OutToStream (struct CYCLIC *c,
 }
 
 
+// Returns the number of pending bytes stored contiguously from *data on, ie to
+// feed a hardware FIFO or DMA transfer without copying. Call
+// CYCLIC_OutAdvance() once they are consumed. The remaining pending bytes, if
+// any, will be returned by the next call (buffer start).
+uint32_t CYCLIC_OutSpan (struct CYCLIC *c, const uint8_t **data)
+{
+    if (!c || !data)
+    {
+        return 0;
+    }
+
+    const uint32_t Pending  = CYCLIC_Pending (c);
+    const uint32_t ToEnd    = c->capacity - c->outIndex;
+
+    *data = &c->data[c->outIndex];
+    return (Pending < ToEnd)? Pending : ToEnd;
+}
+
+
+bool CYCLIC_OutAdvance (struct CYCLIC *c, uint32_t count)
+{
+    if (!c)
+    {
+        return false;
+    }
+
+    const uint32_t Pending = CYCLIC_Pending (c);
+    if (count > Pending)
+    {
+        count = Pending;
+    }
+
+    c->reads += count;
+    c->outIndex = (c->outIndex + count) & (c->capacity - 1);
+    return true;
+}
+
+
 // Call CYCLIC_Pending() before to know how much data is available
 uint8_t CYCLIC_Peek (struct CYCLIC *c, uint32_t offset)
 {
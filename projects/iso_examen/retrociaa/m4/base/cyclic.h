@@ -74,6 +74,8 @@ uint32_t    CYCLIC_OutToStream      (struct CYCLIC *c,
                                      STREAM_ByteOutFunc streamFunc,
                                      void *streamFuncHandler,
                                      uint32_t maxBytes);
+uint32_t    CYCLIC_OutSpan          (struct CYCLIC *c, const uint8_t **data);
+bool        CYCLIC_OutAdvance       (struct CYCLIC *c, uint32_t count);
 uint8_t     CYCLIC_Peek             (struct CYCLIC *c, uint32_t offset);
 bool        CYCLIC_PeekToBuffer     (struct CYCLIC *c, uint32_t offset,
                                      uint8_t *data, uint32_t size);
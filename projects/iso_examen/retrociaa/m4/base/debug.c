@@ -33,9 +33,11 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "debug.h"
+#include "attr.h"
 #include "chip.h"   // CMSIS
 
 
+ATTR_RamFunc
 bool DEBUG_Assert (const bool condition)
 {
     if (!condition)
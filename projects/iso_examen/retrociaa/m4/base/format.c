@@ -0,0 +1,540 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Allocation free number and text formatting.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "format.h"
+#include <string.h>
+
+
+static const uint32_t g_Pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+    1000000000
+};
+
+static const char g_DigitsLower[] = "0123456789abcdef";
+static const char g_DigitsUpper[] = "0123456789ABCDEF";
+
+
+// Writes "u" backwards ending at "end", at least "minDigits" long. Returns the
+// first written character.
+static char * putDigits (char *end, uint32_t u, uint32_t minDigits,
+                         uint32_t base, const char *digits)
+{
+    char *p = end;
+
+    do
+    {
+        *(-- p) = digits[u % base];
+        u /= base;
+    }
+    while (u);
+
+    while ((uint32_t)(end - p) < minDigits)
+    {
+        *(-- p) = '0';
+    }
+
+    return p;
+}
+
+
+// Lays out sign, prefix, padding and digits in "out" (FORMAT_MaxLength bytes)
+// according to spec width and flags. Returns the field length.
+static uint32_t putField (char *out, char sign, const char *prefix,
+                          const char *digits, uint32_t count,
+                          const struct FORMAT_Spec *spec)
+{
+    const uint32_t PrefixLen = prefix? strlen (prefix) : 0;
+    const uint32_t NumLen    = (sign? 1 : 0) + PrefixLen + count;
+    uint32_t       width     = spec->width;
+
+    if (width > FORMAT_MaxLength)
+    {
+        width = FORMAT_MaxLength;
+    }
+
+    const uint32_t Pad = (width > NumLen)? width - NumLen : 0;
+    char *p = out;
+
+    if (!(spec->flags & (FORMAT_FlagLeftAlign | FORMAT_FlagZeroPad)))
+    {
+        memset (p, ' ', Pad);
+        p += Pad;
+    }
+
+    if (sign)
+    {
+        *p ++ = sign;
+    }
+
+    memcpy (p, prefix, PrefixLen);
+    p += PrefixLen;
+
+    if ((spec->flags & FORMAT_FlagZeroPad)
+            && !(spec->flags & FORMAT_FlagLeftAlign))
+    {
+        memset (p, '0', Pad);
+        p += Pad;
+    }
+
+    memcpy (p, digits, count);
+    p += count;
+
+    if (spec->flags & FORMAT_FlagLeftAlign)
+    {
+        memset (p, ' ', Pad);
+        p += Pad;
+    }
+
+    return (uint32_t)(p - out);
+}
+
+
+// Writes "ip.fr" backwards ending at "end", "fr" being exactly "precision"
+// digits long.
+static char * putDecimal (char *end, uint32_t ip, uint32_t fr,
+                          uint32_t precision)
+{
+    char *p = end;
+
+    if (precision)
+    {
+        p = putDigits (p, fr, precision, 10, g_DigitsLower);
+        *(-- p) = '.';
+    }
+
+    return putDigits (p, ip, 1, 10, g_DigitsLower);
+}
+
+
+static char * putFloat (char *end, float f, uint32_t precision)
+{
+    if (precision > FORMAT_MaxFloatPrecision)
+    {
+        precision = FORMAT_MaxFloatPrecision;
+    }
+
+    char *p = end;
+
+    if (f != f)
+    {
+        p -= 3;
+        memcpy (p, "nan", 3);
+        return p;
+    }
+
+    // Values not fitting in the integer part are scaled down and printed in
+    // exponential notation ("d.ddde+XX").
+    uint32_t exp = 0;
+    if (f >= 4294967040.0f)
+    {
+        if (f > 3.4028235e38f)
+        {
+            p -= 3;
+            memcpy (p, "inf", 3);
+            return p;
+        }
+
+        while (f >= 10.0f)
+        {
+            f /= 10.0f;
+            ++ exp;
+        }
+    }
+
+    const uint32_t Scale = g_Pow10[precision];
+    uint32_t ip = (uint32_t) f;
+    uint32_t fr = (uint32_t) ((f - (float) ip) * (float) Scale + 0.5f);
+
+    if (fr >= Scale)
+    {
+        fr -= Scale;
+        ++ ip;
+    }
+
+    if (exp)
+    {
+        p = putDigits (p, exp, 2, 10, g_DigitsLower);
+        *(-- p) = '+';
+        *(-- p) = 'e';
+    }
+
+    return putDecimal (p, ip, fr, precision);
+}
+
+
+static char * putFixed (char *end, uint32_t u, uint32_t fracBits,
+                        uint32_t precision)
+{
+    if (!fracBits || fracBits > 31)
+    {
+        fracBits = FORMAT_DefaultFracBits;
+    }
+
+    if (precision > 9)
+    {
+        precision = 9;
+    }
+
+    const uint32_t Scale    = g_Pow10[precision];
+    const uint32_t FracMask = (1u << fracBits) - 1;
+
+    uint32_t ip = u >> fracBits;
+    uint32_t fr = (uint32_t) (((uint64_t)(u & FracMask) * Scale
+                                + (1u << (fracBits - 1))) >> fracBits);
+    if (fr >= Scale)
+    {
+        fr -= Scale;
+        ++ ip;
+    }
+
+    return putDecimal (end, ip, fr, precision);
+}
+
+
+static char resolveType (struct VARIANT *v, const struct FORMAT_Spec *spec)
+{
+    if (spec->type && !(spec->type == 's' && v->type != VARIANT_TypeString))
+    {
+        return spec->type;
+    }
+
+    switch (v->type)
+    {
+        case VARIANT_TypeUint32:
+            return 'u';
+
+        case VARIANT_TypeInt32:
+            return 'd';
+
+        case VARIANT_TypeFloat:
+            return 'f';
+
+        case VARIANT_TypePointer:
+            return 'p';
+
+        case VARIANT_TypeString:
+            return 's';
+    }
+
+    return 'u';
+}
+
+
+// Formats any non-string conversion into "out" (FORMAT_MaxLength bytes).
+static uint32_t formatNumber (char *out, struct VARIANT *v, const char Type,
+                              const struct FORMAT_Spec *spec)
+{
+    char        num[FORMAT_MaxLength];
+    char        *end        = &num[sizeof(num)];
+    char        *p          = end;
+    char        sign        = 0;
+    const char  *prefix     = NULL;
+    uint32_t    precision   = spec->precision;
+    // Minimum integer digits, bounded so any field fits in FORMAT_MaxLength.
+    uint32_t    intDigits   = (precision == FORMAT_DefaultPrecision)
+                                            ? 1 : precision;
+    if (intDigits > FORMAT_MaxIntDigits)
+    {
+        intDigits = FORMAT_MaxIntDigits;
+    }
+
+    switch (Type)
+    {
+        case 'd':
+        case 'q':
+        {
+            const int32_t I = VARIANT_ToInt32 (v);
+            const uint32_t U = (I < 0)? (uint32_t)(-(I + 1)) + 1
+                                      : (uint32_t) I;
+            if (I < 0)
+            {
+                sign = '-';
+            }
+
+            if (Type == 'q')
+            {
+                p = putFixed (end, U, spec->fracBits,
+                              (precision == FORMAT_DefaultPrecision)
+                                            ? 3 : precision);
+            }
+            else
+            {
+                p = putDigits (end, U, intDigits, 10, g_DigitsLower);
+            }
+            break;
+        }
+
+        case 'x':
+        case 'X':
+            p = putDigits (end, VARIANT_ToUint32 (v), intDigits, 16,
+                           (Type == 'X')? g_DigitsUpper : g_DigitsLower);
+            break;
+
+        case 'p':
+            prefix  = "0x";
+            p       = putDigits (end, (v->type == VARIANT_TypePointer)
+                                            ? (uint32_t) v->p
+                                            : VARIANT_ToUint32 (v),
+                                 8, 16, g_DigitsLower);
+            break;
+
+        case 'f':
+        {
+            float f = VARIANT_ToFloat (v);
+            if (f < 0)
+            {
+                sign = '-';
+                f    = -f;
+            }
+
+            p = putFloat (end, f, (precision == FORMAT_DefaultPrecision)
+                                            ? 6 : precision);
+            break;
+        }
+
+        case 'u':
+        default:
+            p = putDigits (end, VARIANT_ToUint32 (v), intDigits, 10,
+                           g_DigitsLower);
+            break;
+    }
+
+    return putField (out, sign, prefix, p, (uint32_t)(end - p), spec);
+}
+
+
+static uint32_t stringLength (const char *s, const struct FORMAT_Spec *spec)
+{
+    const uint32_t Max = (spec->precision == FORMAT_DefaultPrecision)
+                                            ? (uint32_t) -1 : spec->precision;
+    uint32_t len = 0;
+
+    while (len < Max && s[len])
+    {
+        ++ len;
+    }
+
+    return len;
+}
+
+
+void FORMAT_SpecInit (struct FORMAT_Spec *spec)
+{
+    if (!spec)
+    {
+        return;
+    }
+
+    spec->type      = 0;
+    spec->flags     = 0;
+    spec->width     = 0;
+    spec->precision = FORMAT_DefaultPrecision;
+    spec->fracBits  = FORMAT_DefaultFracBits;
+}
+
+
+// Parses "[0|-][width][.precision][type[fracBits]]". Returns the first
+// character after the spec or NULL if it is not valid.
+const char* FORMAT_ParseSpec (const char *s, struct FORMAT_Spec *spec)
+{
+    if (!s || !spec)
+    {
+        return NULL;
+    }
+
+    FORMAT_SpecInit (spec);
+
+    while (*s == '0' || *s == '-')
+    {
+        spec->flags |= (*s ++ == '0')? FORMAT_FlagZeroPad
+                                     : FORMAT_FlagLeftAlign;
+    }
+
+    uint32_t width = 0;
+    while (*s >= '0' && *s <= '9')
+    {
+        width = width * 10 + (uint32_t)(*s ++ - '0');
+    }
+
+    spec->width = (width > FORMAT_MaxLength)? FORMAT_MaxLength : width;
+
+    if (*s == '.')
+    {
+        uint32_t precision = 0;
+        ++ s;
+        while (*s >= '0' && *s <= '9')
+        {
+            precision = precision * 10 + (uint32_t)(*s ++ - '0');
+        }
+
+        spec->precision = (precision >= FORMAT_DefaultPrecision)
+                                ? FORMAT_DefaultPrecision - 1 : precision;
+    }
+
+    switch (*s)
+    {
+        case 'u': case 'd': case 'x': case 'X':
+        case 'p': case 'f': case 's':
+            spec->type = *s ++;
+            break;
+
+        case 'q':
+        {
+            spec->type = *s ++;
+            uint32_t fracBits = 0;
+            while (*s >= '0' && *s <= '9')
+            {
+                fracBits = fracBits * 10 + (uint32_t)(*s ++ - '0');
+            }
+
+            if (fracBits > 31)
+            {
+                return NULL;
+            }
+
+            if (fracBits)
+            {
+                spec->fracBits = fracBits;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return s;
+}
+
+
+// Always NULL terminates "buf" (if size > 0). Returns the number of characters
+// written, not counting the terminator.
+uint32_t FORMAT_ToBuffer (char *buf, uint32_t size, struct VARIANT *v,
+                          const struct FORMAT_Spec *spec)
+{
+    if (!buf || !size || !v)
+    {
+        return 0;
+    }
+
+    struct FORMAT_Spec defaultSpec;
+    if (!spec)
+    {
+        FORMAT_SpecInit (&defaultSpec);
+        spec = &defaultSpec;
+    }
+
+    const char  Type = resolveType (v, spec);
+    char        field[FORMAT_MaxLength];
+    const char  *src;
+    uint32_t    count;
+
+    if (Type == 's')
+    {
+        src     = v->s? v->s : "";
+        count   = stringLength (src, spec);
+    }
+    else
+    {
+        src     = field;
+        count   = formatNumber (field, v, Type, spec);
+    }
+
+    if (count > size - 1)
+    {
+        count = size - 1;
+    }
+
+    memcpy (buf, src, count);
+    buf[count] = '\0';
+
+    return count;
+}
+
+
+// Formats straight into the cyclic buffer, no intermediate string is built
+// for string arguments. Returns the number of bytes written.
+uint32_t FORMAT_ToCyclic (struct CYCLIC *c, struct VARIANT *v,
+                          const struct FORMAT_Spec *spec)
+{
+    if (!c || !v)
+    {
+        return 0;
+    }
+
+    struct FORMAT_Spec defaultSpec;
+    if (!spec)
+    {
+        FORMAT_SpecInit (&defaultSpec);
+        spec = &defaultSpec;
+    }
+
+    const char Type = resolveType (v, spec);
+
+    if (Type != 's')
+    {
+        char field[FORMAT_MaxLength];
+        const uint32_t Count = formatNumber (field, v, Type, spec);
+
+        CYCLIC_InFromBuffer (c, (const uint8_t *) field, Count);
+        return Count;
+    }
+
+    const char      *s      = v->s? v->s : "";
+    const uint32_t  Len     = stringLength (s, spec);
+    const uint32_t  Pad     = (spec->width > Len)? spec->width - Len : 0;
+
+    if (!(spec->flags & FORMAT_FlagLeftAlign))
+    {
+        for (uint32_t i = Pad; i; --i)
+        {
+            CYCLIC_In (c, ' ');
+        }
+    }
+
+    if (Len)
+    {
+        CYCLIC_InFromBuffer (c, (const uint8_t *) s, Len);
+    }
+
+    if (spec->flags & FORMAT_FlagLeftAlign)
+    {
+        for (uint32_t i = Pad; i; --i)
+        {
+            CYCLIC_In (c, ' ');
+        }
+    }
+
+    return Pad + Len;
+}
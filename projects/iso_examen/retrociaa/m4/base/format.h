@@ -0,0 +1,77 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Allocation free number and text formatting.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "cyclic.h"
+#include "variant.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// Longest field (including padding) a number can be formatted to.
+#define FORMAT_MaxLength            24
+#define FORMAT_MaxIntDigits         16
+#define FORMAT_MaxFloatPrecision    7
+#define FORMAT_DefaultPrecision     0xFF
+#define FORMAT_DefaultFracBits      16
+
+#define FORMAT_FlagZeroPad          0x01
+#define FORMAT_FlagLeftAlign        0x02
+
+
+// Conversion types:
+//  'u' unsigned, 'd' signed, 'x'/'X' hexadecimal, 'p' pointer (0x + 8 hex
+//  digits), 'f' float, 'q' signed fixed point (fracBits fractional bits) and
+//  's' string. Zero means "use the VARIANT own type".
+//
+// Precision means minimum digits for integers, decimals for floats and fixed
+// point numbers and maximum characters for strings.
+struct FORMAT_Spec
+{
+    char        type;
+    uint8_t     flags;
+    uint8_t     width;
+    uint8_t     precision;
+    uint8_t     fracBits;
+};
+
+
+void        FORMAT_SpecInit         (struct FORMAT_Spec *spec);
+const char* FORMAT_ParseSpec        (const char *s, struct FORMAT_Spec *spec);
+uint32_t    FORMAT_ToBuffer         (char *buf, uint32_t size,
+                                     struct VARIANT *v,
+                                     const struct FORMAT_Spec *spec);
+uint32_t    FORMAT_ToCyclic         (struct CYCLIC *c, struct VARIANT *v,
+                                     const struct FORMAT_Spec *spec);
@@ -0,0 +1,431 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host QUEUE benchmark on the scheduler task transitions.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Times the QUEUE operations OS_Scheduler() runs on every call: moving
+// waiting tasks whose timeout expired to their ready queue, queueing the
+// task that just ran and popping the next one, highest priority first.
+// The same task behavior (yield or sleep a few ticks) is run once on the
+// sentinel based QUEUE in ../queue.h and once on the head/tail QUEUE it
+// replaced, copied below with its DEBUG_Assert calls as LEGACY_*.
+//
+// Host timings only show the relative cost; cycles on the target come from
+// g_OS_SchedulerCycles. The ratio of each alternated pair of runs is printed
+// too, as a noise gauge. On a one CPU x86-64 VM, gcc 12, 8 tasks, the -O0
+// ratio spread from 0.92x to 1.18x over 20 invocations, so no gain shows
+// there. At -O2 it stayed between 1.51x and 1.71x. Build at -O0 like the
+// firmware, and at -O2:
+//
+//   gcc -O0 -std=gnu99 -o queuebench queuebench.c ../queue.c
+//   ./queuebench [-t tasks] [-n calls] [-x seed]
+
+#include "../queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define QUEUEBENCH_Priorities   8
+#define QUEUEBENCH_MaxTasks     64
+#define QUEUEBENCH_Runs         9
+
+
+struct Task
+{
+    struct QUEUE_Node   node;
+    uint32_t            priority;
+    uint32_t            wake;
+};
+
+
+struct LEGACY_QUEUE
+{
+    struct QUEUE_Node   *head;
+    struct QUEUE_Node   *tail;
+    uint32_t            elements;
+};
+
+
+static struct Task          g_Tasks[QUEUEBENCH_MaxTasks];
+static struct QUEUE         g_Ready[QUEUEBENCH_Priorities];
+static struct QUEUE         g_Waiting[QUEUEBENCH_Priorities];
+static struct LEGACY_QUEUE  g_LegacyReady[QUEUEBENCH_Priorities];
+static struct LEGACY_QUEUE  g_LegacyWaiting[QUEUEBENCH_Priorities];
+static uint32_t             g_Rng;
+static volatile uint32_t    g_AssertFailed;
+
+
+// Out of line, as base/debug.c is on the target.
+__attribute__((noinline))
+static bool DEBUG_Assert (const bool condition)
+{
+    if (!condition)
+    {
+        ++ g_AssertFailed;
+    }
+    return condition;
+}
+
+
+// QUEUE as it was before the sentinel list.
+static void legacyNodePush (struct QUEUE_Node *lastNode,
+                            struct QUEUE_Node *newNode)
+{
+    if (!lastNode)
+    {
+        return;
+    }
+
+    lastNode->next = newNode;
+    newNode->prev  = lastNode;
+}
+
+
+static void legacyNodeDetach (struct QUEUE_Node *node)
+{
+    if (node->prev)
+    {
+        node->prev->next = node->next;
+    }
+
+    if (node->next)
+    {
+        node->next->prev = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+
+static bool LEGACY_PushNode (struct LEGACY_QUEUE *queue,
+                             struct QUEUE_Node *node)
+{
+    if (!queue || !node)
+    {
+        return false;
+    }
+
+    if (!queue->head)
+    {
+        DEBUG_Assert (!queue->tail);
+        queue->head = node;
+    }
+    else
+    {
+        DEBUG_Assert (queue->tail);
+        legacyNodePush (queue->tail, node);
+    }
+
+    queue->tail = node;
+    ++ queue->elements;
+
+    return true;
+}
+
+
+static bool LEGACY_DetachNode (struct LEGACY_QUEUE *queue,
+                               struct QUEUE_Node *node)
+{
+    if (!queue || !node)
+    {
+        return false;
+    }
+
+    DEBUG_Assert ((queue->head && queue->tail)
+                    || (!queue->head && !queue->tail));
+
+    DEBUG_Assert (queue->elements);
+
+    const bool NodeIsHead = (queue->head == node);
+    const bool NodeIsTail = (queue->tail == node);
+
+    if (NodeIsHead && NodeIsTail)
+    {
+        DEBUG_Assert (!node->prev && !node->next);
+        queue->head = NULL;
+        queue->tail = NULL;
+    }
+    else if (NodeIsHead)
+    {
+        DEBUG_Assert (node->next);
+        queue->head = node->next;
+    }
+    else if (NodeIsTail)
+    {
+        DEBUG_Assert (node->prev);
+        queue->tail = node->prev;
+    }
+
+    legacyNodeDetach (node);
+    -- queue->elements;
+
+    return true;
+}
+
+
+static uint32_t nextRandom (void)
+{
+    g_Rng ^= g_Rng << 13;
+    g_Rng ^= g_Rng >> 17;
+    g_Rng ^= g_Rng << 5;
+    return g_Rng;
+}
+
+
+// Half of the runs end in a yield, the rest in a sleep of 1 to 16 ticks.
+// Called the same number of times in the same order by both schedulers.
+static bool taskSleeps (struct Task *task, uint32_t now)
+{
+    const uint32_t R = nextRandom ();
+
+    if (R & 1)
+    {
+        return false;
+    }
+
+    task->wake = now + 1 + ((R >> 1) & 15);
+    return true;
+}
+
+
+static struct Task * schedule (struct Task *current, uint32_t now)
+{
+    for (uint32_t i = 0; i < QUEUEBENCH_Priorities; ++ i)
+    {
+        struct QUEUE *queue = &g_Waiting[i];
+        struct QUEUE_Node *node;
+        struct QUEUE_Node *next;
+
+        for (node = QUEUE_Head (queue); node; node = next)
+        {
+            next = QUEUE_Next (queue, node);
+
+            if ((int32_t) (now - ((struct Task *) node)->wake) >= 0)
+            {
+                QUEUE_DetachNode    (queue, node);
+                QUEUE_PushNode      (&g_Ready[i], node);
+            }
+        }
+    }
+
+    if (current)
+    {
+        QUEUE_PushNode (taskSleeps (current, now)?
+                            &g_Waiting[current->priority]
+                            : &g_Ready[current->priority], &current->node);
+    }
+
+    for (uint32_t i = 0; i < QUEUEBENCH_Priorities; ++ i)
+    {
+        struct QUEUE_Node *node = QUEUE_PopNode (&g_Ready[i]);
+        if (node)
+        {
+            return (struct Task *) node;
+        }
+    }
+
+    return NULL;
+}
+
+
+static struct Task * legacySchedule (struct Task *current, uint32_t now)
+{
+    for (uint32_t i = 0; i < QUEUEBENCH_Priorities; ++ i)
+    {
+        struct LEGACY_QUEUE *queue = &g_LegacyWaiting[i];
+        struct QUEUE_Node *node;
+        struct QUEUE_Node *next;
+
+        for (node = queue->head; node; node = next)
+        {
+            next = node->next;
+
+            if ((int32_t) (now - ((struct Task *) node)->wake) >= 0)
+            {
+                LEGACY_DetachNode   (queue, node);
+                LEGACY_PushNode     (&g_LegacyReady[i], node);
+            }
+        }
+    }
+
+    if (current)
+    {
+        LEGACY_PushNode (taskSleeps (current, now)?
+                            &g_LegacyWaiting[current->priority]
+                            : &g_LegacyReady[current->priority],
+                         &current->node);
+    }
+
+    for (uint32_t i = 0; i < QUEUEBENCH_Priorities; ++ i)
+    {
+        struct QUEUE_Node *node = g_LegacyReady[i].head;
+        if (node)
+        {
+            LEGACY_DetachNode (&g_LegacyReady[i], node);
+            return (struct Task *) node;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void setup (uint32_t tasks, uint32_t seed, bool legacy)
+{
+    g_Rng = seed? seed : 1;
+
+    for (uint32_t i = 0; i < QUEUEBENCH_Priorities; ++ i)
+    {
+        QUEUE_Init (&g_Ready[i]);
+        QUEUE_Init (&g_Waiting[i]);
+        g_LegacyReady[i]    = (struct LEGACY_QUEUE) { 0 };
+        g_LegacyWaiting[i]  = (struct LEGACY_QUEUE) { 0 };
+    }
+
+    for (uint32_t i = 0; i < tasks; ++ i)
+    {
+        struct Task *task = &g_Tasks[i];
+
+        *task = (struct Task) { .priority = 4 + i % 3 };
+
+        if (legacy)
+        {
+            LEGACY_PushNode (&g_LegacyReady[task->priority], &task->node);
+        }
+        else
+        {
+            QUEUE_PushNode (&g_Ready[task->priority], &task->node);
+        }
+    }
+}
+
+
+static uint64_t now_ns (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+// ns per scheduler call. "trace" gets a checksum of the task picked on
+// every call.
+static double run (uint32_t tasks, uint32_t calls, uint32_t seed,
+                   bool legacy, uint32_t *trace)
+{
+    setup (tasks, seed, legacy);
+
+    struct Task *current = NULL;
+    uint32_t sum = 0;
+    const uint64_t Start = now_ns ();
+
+    for (uint32_t now = 0; now < calls; ++ now)
+    {
+        current = legacy? legacySchedule (current, now)
+                        : schedule (current, now);
+        sum = sum * 31 + (current? (uint32_t) (current - g_Tasks) + 1 : 0);
+    }
+
+    *trace = sum;
+    return (double) (now_ns () - Start) / calls;
+}
+
+
+int main (int argc, char *argv[])
+{
+    uint32_t tasks  = 8;
+    uint32_t calls  = 2000000;
+    uint32_t seed   = 1;
+
+    int opt;
+    while ((opt = getopt (argc, argv, "t:n:x:")) != -1)
+    {
+        const uint32_t V = (uint32_t) strtoul (optarg? optarg : "0", NULL, 0);
+        switch (opt)
+        {
+            case 't': tasks = V; break;
+            case 'n': calls = V; break;
+            case 'x': seed  = V; break;
+            default:
+                fprintf (stderr, "usage: %s [-t tasks] [-n calls] [-x seed]\n",
+                         argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!tasks || tasks > QUEUEBENCH_MaxTasks || !calls)
+    {
+        fprintf (stderr, "invalid parameters\n");
+        return EXIT_FAILURE;
+    }
+
+    uint32_t trace;
+    uint32_t legacyTrace;
+    double sentinel = 0;
+    double legacy   = 0;
+    double minRatio = 0;
+    double maxRatio = 0;
+
+    // Alternated, so frequency changes on the host hit both alike; the
+    // fastest run of each counts.
+    for (uint32_t r = 0; r < QUEUEBENCH_Runs; ++ r)
+    {
+        const double S = run (tasks, calls, seed, false, &trace);
+        const double L = run (tasks, calls, seed, true, &legacyTrace);
+        const double R = S? L / S : 0.0;
+
+        sentinel    = (!r || S < sentinel)? S : sentinel;
+        legacy      = (!r || L < legacy)? L : legacy;
+        minRatio    = (!r || R < minRatio)? R : minRatio;
+        maxRatio    = (!r || R > maxRatio)? R : maxRatio;
+    }
+
+    printf ("%u tasks, %u scheduler calls, best of %u\n", tasks, calls,
+            QUEUEBENCH_Runs);
+    printf ("  head/tail QUEUE  %7.2f ns per call\n", legacy);
+    printf ("  sentinel QUEUE   %7.2f ns per call (%.2fx)\n", sentinel,
+            sentinel? legacy / sentinel : 0.0);
+    printf ("  pair ratios      %.2fx to %.2fx\n", minRatio, maxRatio);
+
+    // Both must have picked the same task on every call.
+    if (trace != legacyTrace || g_AssertFailed)
+    {
+        printf ("  schedules differ or assertions failed\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -69,6 +69,8 @@ bool MEMPOOL_Init (struct MEMPOOL *m, uint32_t baseAddr, uint32_t size)
     m->size         = size;
     m->used         = 0;
 
+    QUEUE_Init (&m->blocks);
+
     return true;
 }
 
@@ -114,6 +116,50 @@ void * MEMPOOL_Block (struct MEMPOOL *m, uint32_t blockSize,
 }
 
 
+// Same as MEMPOOL_Block() but the returned address is aligned on a power of
+// two boundary, ie. STORAGE_BufferAlign for buffers handed to DMA. Memory
+// skipped to reach the boundary is not reusable.
+void * MEMPOOL_BlockAligned (struct MEMPOOL *m, uint32_t blockSize,
+                             uint32_t alignment, const char *description)
+{
+    if (!m || !blockSize || !alignment || (alignment & (alignment - 1)))
+    {
+        return NULL;
+    }
+
+    if (alignment < 8)
+    {
+        alignment = 8;
+    }
+
+    // The hidden MEMPOOL_Block goes right before the aligned address.
+    const uint32_t NextBlockAddr    = m->baseAddr + m->used;
+    const uint32_t AlignedAddr      = (NextBlockAddr
+                                        + sizeof(struct MEMPOOL_Block)
+                                        + alignment - 1) & ~(alignment - 1);
+    const uint32_t Padding          = AlignedAddr
+                                        - sizeof(struct MEMPOOL_Block)
+                                        - NextBlockAddr;
+
+    if (Padding > (m->size - m->used))
+    {
+        return NULL;
+    }
+
+    m->used += Padding;
+
+    void *block = MEMPOOL_Block (m, blockSize, description);
+    if (!block)
+    {
+        m->used -= Padding;
+    }
+
+    DEBUG_Assert (!block || !((uint32_t)block & (alignment - 1)));
+
+    return block;
+}
+
+
 uint32_t MEMPOOL_BlockSize (void *b)
 {
     if (!b)
@@ -54,5 +54,8 @@ bool        MEMPOOL_Init            (struct MEMPOOL *m, uint32_t baseAddr,
                                      uint32_t size);
 void *      MEMPOOL_Block           (struct MEMPOOL *m, uint32_t blockSize,
                                      const char *description);
+void *      MEMPOOL_BlockAligned    (struct MEMPOOL *m, uint32_t blockSize,
+                                     uint32_t alignment,
+                                     const char *description);
 uint32_t    MEMPOOL_BlockSize       (void *b);
 uint32_t    MEMPOOL_Available       (struct MEMPOOL *m);
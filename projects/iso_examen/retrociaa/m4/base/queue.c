@@ -33,41 +33,9 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "queue.h"
-#include "debug.h"
 #include <string.h>
 
 
-static void nodePush (struct QUEUE_Node *lastNode,
-                      struct QUEUE_Node *newNode)
-{
-    if (!lastNode)
-    {
-        return;
-    }
-
-    lastNode->next = newNode;
-    newNode->prev  = lastNode;
-}
-
-
-static void nodeDetach (struct QUEUE_Node *node)
-{
-    // Detaching node from the chain
-    if (node->prev)
-    {
-        node->prev->next = node->next;
-    }
-
-    if (node->next)
-    {
-        node->next->prev = node->prev;
-    }
-
-    node->prev = NULL;
-    node->next = NULL;
-}
-
-
 bool QUEUE_Init (struct QUEUE *queue)
 {
     if (!queue)
@@ -77,72 +45,26 @@ bool QUEUE_Init (struct QUEUE *queue)
 
     memset (queue, 0, sizeof(struct QUEUE));
 
-    return true;
-}
-
-
-bool QUEUE_PushNode (struct QUEUE *queue, struct QUEUE_Node *node)
-{
-    if (!queue || !node)
-    {
-        return false;
-    }
-
-    if (!queue->head)
-    {
-        DEBUG_Assert (!queue->tail);
-        queue->head = node;
-    }
-    else
-    {
-        DEBUG_Assert (queue->tail);
-        nodePush (queue->tail, node);
-    }
-
-    queue->tail = node;
-    ++ queue->elements;
+    queue->sentinel.prev = &queue->sentinel;
+    queue->sentinel.next = &queue->sentinel;
 
     return true;
 }
 
 
-bool QUEUE_DetachNode (struct QUEUE *queue, struct QUEUE_Node *node)
+// Walks from the tail so nodes that compare equal keep their insertion order
+// and, in the common case of increasing keys (ie timeouts), the walk ends on
+// the first comparison.
+ATTR_RamFunc
+void QUEUE_InsertSorted (struct QUEUE *queue, struct QUEUE_Node *node,
+                         QUEUE_NodeBefore before)
 {
-    if (!queue || !node)
-    {
-        return false;
-    }
-
-    DEBUG_Assert ((queue->head && queue->tail)
-                    || (!queue->head && !queue->tail));
-
-    DEBUG_Assert (queue->elements);
+    struct QUEUE_Node *at = queue->sentinel.prev;
 
-    const bool NodeIsHead = (queue->head == node);
-    const bool NodeIsTail = (queue->tail == node);
-
-    // Removing the only node in the queue.
-    if (NodeIsHead && NodeIsTail)
-    {
-        DEBUG_Assert (!node->prev && !node->next);
-        queue->head = NULL;
-        queue->tail = NULL;
-    }
-    // Removing the first node.
-    else if (NodeIsHead)
-    {
-        DEBUG_Assert (node->next);
-        queue->head = node->next;
-    }
-    // Removing the last node.
-    else if (NodeIsTail)
+    while (at != &queue->sentinel && before (node, at))
     {
-        DEBUG_Assert (node->prev);
-        queue->tail = node->prev;
+        at = at->prev;
     }
 
-    nodeDetach (node);
-    -- queue->elements;
-
-    return true;
+    QUEUE_InsertAfter (queue, at, node);
 }
@@ -34,8 +34,11 @@
 */
 #pragma once
 
+#include "attr.h"
+
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 
 struct QUEUE_Node
@@ -45,14 +48,164 @@ struct QUEUE_Node
 };
 
 
+// Circular doubly linked list with a sentinel node: sentinel.next is the
+// first node (head), sentinel.prev the last one (tail). An empty queue has its
+// sentinel pointing to itself, so pushing and detaching never have to test for
+// empty, head-only or tail-only states.
+//
+// NOTE: A QUEUE cannot be copied or moved in memory once initialized since its
+//       nodes point back to the sentinel address.
 struct QUEUE
 {
-    struct QUEUE_Node   *head;
-    struct QUEUE_Node   *tail;
+    struct QUEUE_Node   sentinel;
     uint32_t            elements;
 };
 
 
+// Returns true when "a" must be placed before "b".
+typedef bool (*QUEUE_NodeBefore) (const struct QUEUE_Node *a,
+                                  const struct QUEUE_Node *b);
+
+
 bool    QUEUE_Init          (struct QUEUE *queue);
-bool    QUEUE_PushNode      (struct QUEUE *queue, struct QUEUE_Node *node);
-bool    QUEUE_DetachNode    (struct QUEUE *queue, struct QUEUE_Node *node);
+void    QUEUE_InsertSorted  (struct QUEUE *queue, struct QUEUE_Node *node,
+                             QUEUE_NodeBefore before);
+
+
+ATTR_AlwaysInline
+inline static void queueLink (struct QUEUE_Node *prev,
+                              struct QUEUE_Node *next,
+                              struct QUEUE_Node *node)
+{
+    node->prev = prev;
+    node->next = next;
+    prev->next = node;
+    next->prev = node;
+}
+
+
+ATTR_AlwaysInline
+inline static bool QUEUE_Empty (const struct QUEUE *queue)
+{
+    return (queue->sentinel.next == &queue->sentinel);
+}
+
+
+// Returns NULL on an empty queue.
+ATTR_AlwaysInline
+inline static struct QUEUE_Node * QUEUE_Head (struct QUEUE *queue)
+{
+    struct QUEUE_Node *head = queue->sentinel.next;
+    return (head == &queue->sentinel)? NULL : head;
+}
+
+
+// Returns NULL on an empty queue.
+ATTR_AlwaysInline
+inline static struct QUEUE_Node * QUEUE_Tail (struct QUEUE *queue)
+{
+    struct QUEUE_Node *tail = queue->sentinel.prev;
+    return (tail == &queue->sentinel)? NULL : tail;
+}
+
+
+// Returns NULL when "node" is the last node in the queue.
+ATTR_AlwaysInline
+inline static struct QUEUE_Node * QUEUE_Next (struct QUEUE *queue,
+                                              struct QUEUE_Node *node)
+{
+    struct QUEUE_Node *next = node->next;
+    return (next == &queue->sentinel)? NULL : next;
+}
+
+
+// Returns NULL when "node" is the first node in the queue.
+ATTR_AlwaysInline
+inline static struct QUEUE_Node * QUEUE_Prev (struct QUEUE *queue,
+                                              struct QUEUE_Node *node)
+{
+    struct QUEUE_Node *prev = node->prev;
+    return (prev == &queue->sentinel)? NULL : prev;
+}
+
+
+// Appends "node" at the tail.
+ATTR_AlwaysInline
+inline static void QUEUE_PushNode (struct QUEUE *queue,
+                                   struct QUEUE_Node *node)
+{
+    queueLink (queue->sentinel.prev, &queue->sentinel, node);
+    ++ queue->elements;
+}
+
+
+// Prepends "node" at the head.
+ATTR_AlwaysInline
+inline static void QUEUE_PushFront (struct QUEUE *queue,
+                                    struct QUEUE_Node *node)
+{
+    queueLink (&queue->sentinel, queue->sentinel.next, node);
+    ++ queue->elements;
+}
+
+
+// Inserts "node" right after "at", which must already be in the queue.
+ATTR_AlwaysInline
+inline static void QUEUE_InsertAfter (struct QUEUE *queue,
+                                      struct QUEUE_Node *at,
+                                      struct QUEUE_Node *node)
+{
+    queueLink (at, at->next, node);
+    ++ queue->elements;
+}
+
+
+// "node" must be in "queue". Detached node links are set to NULL.
+ATTR_AlwaysInline
+inline static void QUEUE_DetachNode (struct QUEUE *queue,
+                                     struct QUEUE_Node *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+    -- queue->elements;
+}
+
+
+// Detaches and returns the head node, NULL on an empty queue.
+ATTR_AlwaysInline
+inline static struct QUEUE_Node * QUEUE_PopNode (struct QUEUE *queue)
+{
+    struct QUEUE_Node *head = QUEUE_Head (queue);
+    if (head)
+    {
+        QUEUE_DetachNode (queue, head);
+    }
+    return head;
+}
+
+
+// Moves every node in "src" to the tail of "dst". "src" ends up empty.
+ATTR_AlwaysInline
+inline static void QUEUE_Splice (struct QUEUE *dst, struct QUEUE *src)
+{
+    if (QUEUE_Empty (src))
+    {
+        return;
+    }
+
+    struct QUEUE_Node *first = src->sentinel.next;
+    struct QUEUE_Node *last  = src->sentinel.prev;
+
+    first->prev              = dst->sentinel.prev;
+    dst->sentinel.prev->next = first;
+    last->next               = &dst->sentinel;
+    dst->sentinel.prev       = last;
+
+    dst->elements += src->elements;
+
+    src->sentinel.prev = &src->sentinel;
+    src->sentinel.next = &src->sentinel;
+    src->elements      = 0;
+}
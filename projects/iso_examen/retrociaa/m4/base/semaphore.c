@@ -57,51 +57,74 @@ bool SEMAPHORE_Init (struct SEMAPHORE *s, uint32_t resources,
 
 bool SEMAPHORE_Acquire (struct SEMAPHORE *s)
 {
-    if (!s)
-    {
-        return false;
-    }
+    return SEMAPHORE_AcquireN (s, 1);
+}
 
-    uint32_t value = __LDREXW (&s->available);
 
-    if (value == 0)
+// All or nothing: either "count" resources are taken or none at all. A failed
+// store-exclusive means another context (ie an ISR) changed "available" in
+// between; the operation is retried with the updated value instead of
+// reporting a spurious unavailable resource.
+bool SEMAPHORE_AcquireN (struct SEMAPHORE *s, uint32_t count)
+{
+    if (!s || !count)
     {
         return false;
     }
 
-    -- value;
-
-    if (__STREXW (value, &s->available))
+    while (1)
     {
-        return false;
-    }
+        const uint32_t Value = __LDREXW (&s->available);
 
-    return true;
+        if (Value < count)
+        {
+            __CLREX ();
+            ++ s->rejections;
+            return false;
+        }
+
+        if (!__STREXW (Value - count, &s->available))
+        {
+            return true;
+        }
+
+        ++ s->contentions;
+    }
 }
 
 
 bool SEMAPHORE_Release (struct SEMAPHORE *s)
 {
-    if (!s)
-    {
-        return false;
-    }
+    return SEMAPHORE_ReleaseN (s, 1);
+}
 
-    uint32_t value = __LDREXW (&s->available);
 
-    if (value + 1 > s->resources)
+// All or nothing, see SEMAPHORE_AcquireN().
+bool SEMAPHORE_ReleaseN (struct SEMAPHORE *s, uint32_t count)
+{
+    if (!s || !count)
     {
         return false;
     }
 
-    ++ value;
-
-    if (__STREXW (value, &s->available))
+    while (1)
     {
-        return false;
-    }
+        const uint32_t Value = __LDREXW (&s->available);
 
-    return true;
+        if (count > s->resources - Value)
+        {
+            __CLREX ();
+            ++ s->rejections;
+            return false;
+        }
+
+        if (!__STREXW (Value + count, &s->available))
+        {
+            return true;
+        }
+
+        ++ s->contentions;
+    }
 }
 
 
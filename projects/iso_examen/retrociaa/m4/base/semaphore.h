@@ -45,11 +45,18 @@ struct SEMAPHORE
 {
     uint32_t            resources;
     volatile uint32_t   available;
+    // FYI only, not part of the algorithm
+    // Store-exclusive failures (another context modified "available").
+    uint32_t            contentions;
+    // Acquire/Release calls that found not enough resources/room.
+    uint32_t            rejections;
 };
 
 
 bool        SEMAPHORE_Init          (struct SEMAPHORE *s, uint32_t resources,
                                      uint32_t available);
 bool        SEMAPHORE_Acquire       (struct SEMAPHORE *s);
+bool        SEMAPHORE_AcquireN      (struct SEMAPHORE *s, uint32_t count);
 bool        SEMAPHORE_Release       (struct SEMAPHORE *s);
+bool        SEMAPHORE_ReleaseN      (struct SEMAPHORE *s, uint32_t count);
 uint32_t    SEMAPHORE_Available     (struct SEMAPHORE *s);
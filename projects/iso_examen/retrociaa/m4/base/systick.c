@@ -33,6 +33,7 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "systick.h"
+#include "attr.h"
 #include "chip.h"   // CMSIS
 
 
@@ -72,6 +73,7 @@ inline SYSTICK_Ticks SYSTICK_GetPeriod_us ()
 }
 
 
+ATTR_RamFunc
 inline SYSTICK_Ticks SYSTICK_Now ()
 {
     return g_ticks;
@@ -87,7 +87,13 @@ bool UART_PutBinary (struct UART *u, const uint8_t *data,
         return false;
     }
 
-    return CYCLIC_InFromBuffer (&u->send, data, size);
+    if (!CYCLIC_InFromBuffer (&u->send, data, size))
+    {
+        return false;
+    }
+
+    UART_TxStart (u);
+    return true;
 }
 
 
@@ -97,6 +103,8 @@ bool UART_PutMessage (struct UART *u, const char *msg)
 }
 
 
+// Bytes are sent from the send buffer by the UART interrupt; this only starts
+// transmission when idle. Returns the number of bytes still pending.
 uint32_t UART_Send (struct UART *u)
 {
     if (!u)
@@ -104,11 +112,14 @@ uint32_t UART_Send (struct UART *u)
         return 0;
     }
 
-    return CYCLIC_OutToStream (&u->send, UART_PutByte, u->handler,
-                               UART_HW_FIFO_SIZE);
+    UART_TxStart (u);
+    return CYCLIC_Pending (&u->send);
 }
 
 
+// Bytes are received by the UART interrupt once the hardware FIFO trigger
+// level or character timeout is reached; this moves any received bytes left
+// in the FIFO right away.
 uint32_t UART_Recv (struct UART *u)
 {
     if (!u)
@@ -116,8 +127,11 @@ uint32_t UART_Recv (struct UART *u)
         return 0;
     }
 
-    return CYCLIC_InFromStream (&u->recv, UART_GetByte, u->handler,
-                                UART_EOF);
+    UART_RxEnable (u, false);
+    const uint32_t Count = CYCLIC_InFromStream (&u->recv, UART_GetByte,
+                                                u->handler, UART_EOF);
+    UART_RxEnable (u, true);
+    return Count;
 }
 
 
@@ -128,7 +142,10 @@ bool UART_RecvInjectByte (struct UART *u, uint8_t byte)
         return false;
     }
 
-    return CYCLIC_In (&u->recv, byte);
+    UART_RxEnable (u, false);
+    const bool Result = CYCLIC_In (&u->recv, byte);
+    UART_RxEnable (u, true);
+    return Result;
 }
 
 
@@ -52,12 +52,28 @@
 #endif
 
 
+enum UART_Event
+{
+    // Data moved to the recv buffer
+    UART_Event_Recv,
+    // Send buffer got at least half empty
+    UART_Event_SendRoom
+};
+
+
+// Called from the UART interrupt; must return quickly.
+typedef void (*UART_EventFunc) (void *param, enum UART_Event event);
+
+
 struct UART
 {
     struct CYCLIC   recv;
     struct CYCLIC   send;
     // Platform dependant UART handler
     void            *handler;
+    // Optional, set after UART_Init()
+    UART_EventFunc  event;
+    void            *eventParam;
 };
 
 
@@ -39,7 +39,13 @@
 #define UART_EOF    0xFFFFFFFF
 
 
+// Transmission and reception are interrupt driven: the platform moves data
+// between the hardware FIFOs and the UART send/recv buffers.
 bool        UART_Config     (struct UART *ctx, uint32_t baudRate);
-// Get and Put conform to STREAM_ByteIn/Out prototypes
+// Starts transmitting send buffer contents if the transmitter is idle.
+void        UART_TxStart    (struct UART *ctx);
+// Disables reception interrupts while the caller accesses the recv buffer
+// as a producer.
+void        UART_RxEnable   (struct UART *ctx, bool enable);
+// Get conforms to STREAM_ByteIn prototype
 uint32_t    UART_GetByte    (void *handler);
-bool        UART_PutByte    (void *handler, uint8_t byte);
@@ -34,6 +34,127 @@
 */
 #include "uart_io.h"
 #include "chip.h"
+#include <stddef.h>
+
+
+// Below OS ticks and syscalls, above the scheduler. The handler does not
+// call the OS by itself; an event function (see struct UART) may wake tasks.
+#ifndef UART_IRQ_PRIORITY
+    #define UART_IRQ_PRIORITY       2
+#endif
+
+// Interrupt once the RX FIFO holds 8 bytes; fewer bytes are received after
+// the character timeout (CTI) interrupt.
+#define UART_RX_TRIGGER_LEVEL       UART_FCR_TRG_LEV2
+
+
+// One UART struct per peripheral: USART0, UART1, USART2, USART3.
+static struct UART *g_uarts[4];
+
+
+static int uartIndex (LPC_USART_T *usart)
+{
+    if (usart == LPC_USART0)
+    {
+        return 0;
+    }
+    if (usart == LPC_UART1)
+    {
+        return 1;
+    }
+    if (usart == LPC_USART2)
+    {
+        return 2;
+    }
+    if (usart == LPC_USART3)
+    {
+        return 3;
+    }
+    return -1;
+}
+
+
+// Fills an empty TX FIFO from send buffer contiguous spans.
+static void txFill (struct UART *u, LPC_USART_T *usart)
+{
+    uint32_t        room = UART_HW_FIFO_SIZE;
+    const uint8_t   *data;
+    uint32_t        span;
+
+    while (room && (span = CYCLIC_OutSpan (&u->send, &data)))
+    {
+        if (span > room)
+        {
+            span = room;
+        }
+
+        for (uint32_t i = 0; i < span; ++i)
+        {
+            Chip_UART_SendByte (usart, data[i]);
+        }
+
+        CYCLIC_OutAdvance (&u->send, span);
+        room -= span;
+    }
+}
+
+
+static void rxDrain (struct UART *u, LPC_USART_T *usart)
+{
+    // Reading LSR also clears receive line errors (RLS interrupt)
+    while (Chip_UART_ReadLineStatus (usart) & UART_LSR_RDR)
+    {
+        CYCLIC_In (&u->recv, Chip_UART_ReadByte (usart));
+    }
+}
+
+
+static void irqHandler (int index)
+{
+    struct UART *u = g_uarts[index];
+    if (!u)
+    {
+        return;
+    }
+
+    LPC_USART_T *usart = (LPC_USART_T *)u->handler;
+    uint32_t    iir;
+
+    while (!((iir = Chip_UART_ReadIntIDReg (usart)) & UART_IIR_INTSTAT_PEND))
+    {
+        switch (iir & UART_IIR_INTID_MASK)
+        {
+            case UART_IIR_INTID_RLS:
+            case UART_IIR_INTID_RDA:
+            case UART_IIR_INTID_CTI:
+                rxDrain (u, usart);
+                if (u->event)
+                {
+                    u->event (u->eventParam, UART_Event_Recv);
+                }
+                break;
+
+            case UART_IIR_INTID_THRE:
+            {
+                txFill (u, usart);
+
+                const uint32_t Pending = CYCLIC_Pending (&u->send);
+                if (!Pending)
+                {
+                    Chip_UART_IntDisable (usart, UART_IER_THREINT);
+                }
+                if (u->event && Pending <= (u->send.capacity >> 1))
+                {
+                    u->event (u->eventParam, UART_Event_SendRoom);
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
 
 
 bool UART_Config (struct UART *u, uint32_t baudRate)
@@ -45,17 +166,81 @@ bool UART_Config (struct UART *u, uint32_t baudRate)
 
     LPC_USART_T *usart = (LPC_USART_T *)u->handler;
 
+    const int Index = uartIndex (usart);
+    if (Index < 0)
+    {
+        return false;
+    }
+
+    const IRQn_Type Irq = (IRQn_Type)(USART0_IRQn + Index);
+
+    NVIC_DisableIRQ         (Irq);
+    g_uarts[Index] = u;
+
     // Periferico (MUX) ya configuado en board de LCPOpen
     // Aca solo se setean parametros
     Chip_UART_Init          (usart);
     Chip_UART_SetBaudFDR    (usart, baudRate);
     Chip_UART_ConfigData    (usart, UART_LCR_WLEN8 | UART_LCR_PARITY_DIS |
                              UART_LCR_SBS_1BIT);
+    Chip_UART_SetupFIFOS    (usart, UART_FCR_FIFO_EN | UART_FCR_RX_RS |
+                             UART_FCR_TX_RS | UART_RX_TRIGGER_LEVEL);
     Chip_UART_TXEnable      (usart);
+
+    // THRE interrupt gets enabled only while there is data to send
+    Chip_UART_IntEnable     (usart, UART_IER_RBRINT | UART_IER_RLSINT);
+
+    NVIC_ClearPendingIRQ    (Irq);
+    NVIC_SetPriority        (Irq, UART_IRQ_PRIORITY);
+    NVIC_EnableIRQ          (Irq);
     return true;
 }
 
 
+void UART_TxStart (struct UART *u)
+{
+    if (!u || !u->handler)
+    {
+        return;
+    }
+
+    LPC_USART_T *usart = (LPC_USART_T *)u->handler;
+
+    // The interrupt handler is the only other send buffer consumer
+    Chip_UART_IntDisable (usart, UART_IER_THREINT);
+
+    if (Chip_UART_ReadLineStatus (usart) & UART_LSR_THRE)
+    {
+        txFill (u, usart);
+    }
+
+    if (CYCLIC_Pending (&u->send))
+    {
+        Chip_UART_IntEnable (usart, UART_IER_THREINT);
+    }
+}
+
+
+void UART_RxEnable (struct UART *u, bool enable)
+{
+    if (!u || !u->handler)
+    {
+        return;
+    }
+
+    LPC_USART_T *usart = (LPC_USART_T *)u->handler;
+
+    if (enable)
+    {
+        Chip_UART_IntEnable (usart, UART_IER_RBRINT | UART_IER_RLSINT);
+    }
+    else
+    {
+        Chip_UART_IntDisable (usart, UART_IER_RBRINT | UART_IER_RLSINT);
+    }
+}
+
+
 uint32_t UART_GetByte (void *handler)
 {
     if (!handler)
@@ -72,17 +257,25 @@ uint32_t UART_GetByte (void *handler)
 }
 
 
-bool UART_PutByte (void *handler, uint8_t byte)
+void UART0_IRQHandler (void)
 {
-    if (!handler)
-    {
-        return false;
-    }
+    irqHandler (0);
+}
 
-    LPC_USART_T *usart = (LPC_USART_T *)handler;
-    while ((Chip_UART_ReadLineStatus(usart) & UART_LSR_THRE) == 0)
-    {
-    }
-    Chip_UART_SendByte (usart, byte);
-    return true;
+
+void UART1_IRQHandler (void)
+{
+    irqHandler (1);
+}
+
+
+void UART2_IRQHandler (void)
+{
+    irqHandler (2);
+}
+
+
+void UART3_IRQHandler (void)
+{
+    irqHandler (3);
 }
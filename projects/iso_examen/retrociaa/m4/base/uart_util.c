@@ -33,7 +33,9 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "uart_util.h"
+#include "format.h"
 #include "text.h"
+#include <stddef.h>
 
 
 /*
@@ -43,8 +45,45 @@
         i18n de strings).
     2)  Datos pasados como variants, no posiciones de memoria a interpretar.
     3)  Puede sustituir el mismo dato dos o mas veces.
+    4)  Sin snprintf ni buffers intermedios: cada argumento se formatea
+        directamente en el buffer de envio (ver format.h).
+
+    Comodines:
+
+    %1 .. %9            Argumento con el formato por defecto de su tipo.
+    %{N:spec}           Argumento N con formato explicito, donde spec es
+                        [0|-][ancho][.precision][tipo[bits]] y tipo es u, d,
+                        x, X, p, f, s o q (punto fijo con "bits" bits
+                        fraccionarios). Ej: %{2:08X}, %{3:.2f}, %{1:.3q15}.
+    %%                  Un unico caracter '%'.
 */
 
+// Parses "{N:spec}" or "{N}" right after a '%'. Returns the first character
+// after the closing brace or NULL if invalid.
+static const char * parseArgSpec (const char *s, uint32_t *arg,
+                                  struct FORMAT_Spec *spec)
+{
+    if (*s != '{' || s[1] < '1' || s[1] > '9')
+    {
+        return NULL;
+    }
+
+    *arg = (uint32_t)(s[1] - '1');
+    s += 2;
+
+    if (*s == ':')
+    {
+        s = FORMAT_ParseSpec (s + 1, spec);
+    }
+    else
+    {
+        FORMAT_SpecInit (spec);
+    }
+
+    return (s && *s == '}')? s + 1 : NULL;
+}
+
+
 bool UART_PutMessageArgs (struct UART *u, const char *msg,
                           struct VARIANT argValues[], uint32_t argCount)
 {
@@ -57,27 +96,33 @@ bool UART_PutMessageArgs (struct UART *u, const char *msg,
 
     while (msg[i])
     {
+        if (msg[i] != '%')
+        {
+            ++ i;
+            continue;
+        }
+
         const char Next = msg[i + 1];
         if (!Next)
         {
-            UART_PutBinary (u, (uint8_t *)msg, i + 1);
+            // Trailing '%' is sent as is.
+            ++ i;
             break;
         }
 
-        if (msg[i] != '%')
+        if (i)
         {
-            ++ i;
-            continue;
+            UART_PutBinary (u, (uint8_t *)msg, i);  // {.. ..}%[Next]
         }
 
-        // msg[i] == '%' && Next
-        UART_PutBinary (u, (uint8_t *)msg, i);  // {.. ..}%[Next]
-        if (Next >= '1' && Next <= '9')         // %([1-9]{1})
+        const char *rest = &msg[i + 2];             // %.[0]
+
+        if (Next >= '1' && Next <= '9')             // %([1-9]{1})
         {
-            const uint32_t arg = Next - 49;
-            if (arg < argCount)
+            const uint32_t Arg = Next - '1';
+            if (Arg < argCount)
             {
-                UART_PutMessage (u, VARIANT_ToString(&argValues[arg]));
+                FORMAT_ToCyclic (&u->send, &argValues[Arg], NULL);
             }
         }
         else if (Next == '%')
@@ -85,14 +130,41 @@ bool UART_PutMessageArgs (struct UART *u, const char *msg,
             // "%%" = escape sequence for a single '%'
             UART_PutBinary (u, (uint8_t *)&Next, 1);
         }
-        else {
+        else if (Next == '{')                       // %{N:spec}
+        {
+            struct FORMAT_Spec  spec;
+            uint32_t            arg;
+            const char          *end = parseArgSpec (&msg[i + 1], &arg, &spec);
+
+            if (end)
+            {
+                if (arg < argCount)
+                {
+                    FORMAT_ToCyclic (&u->send, &argValues[arg], &spec);
+                }
+                rest = end;
+            }
+            else
+            {
+                UART_PutMessage (u, TEXT_REPLACEMENTCHAR);
+            }
+        }
+        else
+        {
             // Invalid char following '%'
             UART_PutMessage (u, TEXT_REPLACEMENTCHAR);
         }
-        msg = &msg[i + 2];                      // %.[0]
-        i = 0;
+
+        msg = rest;
+        i   = 0;
     }
 
+    if (i)
+    {
+        UART_PutBinary (u, (uint8_t *)msg, i);
+    }
+
+    // Arguments are formatted straight into the send buffer
+    UART_Send (u);
     return true;
 }
-
@@ -33,7 +33,7 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "variant.h"
-#include <stdio.h>
+#include "format.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -179,33 +179,13 @@ const char* VARIANT_ToString (struct VARIANT *v)
         return NULL;
     }
 
-    v->conv[0] = 'N';
-    v->conv[1] = '/';
-    v->conv[2] = 'A';
-    v->conv[3] = '\0';
-
-    switch (v->type)
+    if (v->type == VARIANT_TypeString)
     {
-        case VARIANT_TypeUint32:
-            snprintf (v->conv, sizeof(v->conv), "%lu", v->u);
-            break;
-
-        case VARIANT_TypeInt32:
-            snprintf (v->conv, sizeof(v->conv), "%li", v->i);
-            break;
-
-        case VARIANT_TypeFloat:
-            snprintf (v->conv, sizeof(v->conv), "%f", (double)v->f);
-            break;
-
-        case VARIANT_TypePointer:
-            snprintf (v->conv, sizeof(v->conv), "%p", v->p);
-            break;
-
-        case VARIANT_TypeString:
-            return v->s;
+        return v->s;
     }
 
+    FORMAT_ToBuffer (v->conv, sizeof(v->conv), v, NULL);
+
     return v->conv;
 }
 
@@ -41,6 +41,7 @@
 #include "private/runtime.h"
 #include "private/usage.h"
 #include "private/driver/storage.h"
+#include "private/driver/com.h"
 #include "../base/queue.h"
 #include "../base/semaphore.h"
 #include "../base/debug.h"
@@ -67,6 +68,7 @@ uint32_t OS_TaskMinBufferSize (enum OS_TaskType type, void *initParams)
             break;
 
         case OS_TaskType_DriverUART:
+            minBufferSize += OS_DRIVER_ComBufferSize (initParams);
             break;
 
         case OS_TaskType_Generic:
@@ -395,35 +397,370 @@ enum OS_Result OS_TaskWakeUp (void *taskBuffer)
 }
 
 
+// Blocking storage access: the caller sleeps until the job completes.
 enum OS_Result OS_TaskDriverStorage (const char* description,
                                      enum OS_TaskDriverOp op,
                                      uint8_t *buf, uint32_t sector,
                                      uint32_t count)
+{
+    struct OS_StorageHandle handle;
+    enum STORAGE_Result     result;
+    enum OS_Result          r;
+
+    if ((r = OS_StorageSubmit (description, op, buf, sector, count,
+                               OS_StoragePriority_Normal, OS_WaitForever,
+                               NULL, NULL, &handle)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    if ((r = OS_StorageWaitAny (&handle, 1, OS_WaitForever, NULL,
+                                &result)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    switch (result)
+    {
+        case STORAGE_Result_Ok:
+            return OS_Result_OK;
+
+        case STORAGE_Result_Timeout:
+            return OS_Result_Timeout;
+
+        default:
+            break;
+    }
+
+    return OS_Result_Error;
+}
+
+
+// Queues a storage job and returns immediately. The job descriptor is copied
+// by the driver, only the data buffer must remain valid until completion.
+// Completion is notified through callback (if any, the handle cannot be
+// polled then) or retrieved with OS_StoragePoll() / OS_StorageWaitAny().
+// Deadline is relative to now, OS_WaitForever for none.
+enum OS_Result OS_StorageSubmit (const char *description,
+                                 enum OS_TaskDriverOp op,
+                                 uint8_t *buf, uint32_t sector, uint32_t count,
+                                 enum OS_StoragePriority priority,
+                                 OS_Ticks deadline,
+                                 OS_StorageCallback callback,
+                                 void *callbackParam,
+                                 struct OS_StorageHandle *handle)
 {
     if (!OS_RuntimeTask ())
     {
         return OS_Result_InvalidCaller;
     }
 
-    struct OS_TaskDriverStorageAccess sa;
-    sa.description  = description;
-    sa.op           = op;
-    sa.buf          = buf;
-    sa.sector       = sector;
-    sa.count        = count;
+    if (!handle)
+    {
+        return OS_Result_InvalidParams;
+    }
 
-    enum OS_Result r = OS_Syscall (OS_Syscall_TaskDriverStorageAccess, &sa);
-    if (r != OS_Result_Waiting)
+    struct OS_TaskDriverStorageSubmit ss;
+    memset (&ss, 0, sizeof(ss));
+
+    ss.access.description   = description;
+    ss.access.op            = op;
+    ss.access.buf           = buf;
+    ss.access.sector        = sector;
+    ss.access.count         = count;
+    ss.access.priority      = priority;
+    ss.access.timeout       = deadline;
+    ss.access.callback      = callback;
+    ss.access.callbackParam = callbackParam;
+
+    const enum OS_Result r = OS_Syscall (OS_Syscall_TaskDriverStorageSubmit,
+                                         &ss);
+
+    *handle = ss.handle;
+    return r;
+}
+
+
+// Returns OS_Result_OK and the job result once done (the handle is cleared),
+// OS_Result_Waiting if still in progress or OS_Result_InvalidParams if the
+// handle is unknown or was already retrieved.
+enum OS_Result OS_StoragePoll (struct OS_StorageHandle *handle,
+                               enum STORAGE_Result *result)
+{
+    if (!OS_RuntimeTask ())
+    {
+        return OS_Result_InvalidCaller;
+    }
+
+    if (!handle || !handle->sequence)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskDriverStoragePoll sp;
+    sp.handle = *handle;
+    sp.result = STORAGE_Result_NotReady;
+
+    const enum OS_Result r = OS_Syscall (OS_Syscall_TaskDriverStoragePoll,
+                                         &sp);
+    if (r == OS_Result_OK)
+    {
+        if (result)
+        {
+            *result = sp.result;
+        }
+
+        memset (handle, 0, sizeof(struct OS_StorageHandle));
+    }
+
+    return r;
+}
+
+
+// Polls the i-th job of a handle array, see waitAny().
+typedef enum OS_Result (* WaitAnyPollFunc) (void *ctx, uint32_t i);
+
+
+// Common wait loop for storage and com jobs. poll returns OS_Result_OK when
+// job i completed (and was retrieved), OS_Result_Waiting while in progress.
+static enum OS_Result waitAny (WaitAnyPollFunc poll, void *ctx, uint32_t count,
+                               OS_Ticks timeout, uint32_t *index)
+{
+    if (!OS_RuntimeTask ())
+    {
+        return OS_Result_InvalidCaller;
+    }
+
+    if (!count)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskControl   *self   = (struct OS_TaskControl *) OS_TaskSelf ();
+    const OS_Ticks          Start   = OS_GetTicks ();
+
+    while (1)
+    {
+        // The driver releases the complete semaphore on each job completion.
+        // Taken before polling so a completion in between is not missed.
+        SEMAPHORE_Acquire (&self->complete);
+
+        bool inProgress = false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const enum OS_Result R = poll (ctx, i);
+            if (R == OS_Result_OK)
+            {
+                SEMAPHORE_Release (&self->complete);
+                if (index)
+                {
+                    *index = i;
+                }
+                return OS_Result_OK;
+            }
+
+            inProgress |= (R == OS_Result_Waiting);
+        }
+
+        if (!inProgress)
+        {
+            SEMAPHORE_Release (&self->complete);
+            return OS_Result_InvalidParams;
+        }
+
+        OS_Ticks wait = OS_WaitForever;
+        if (timeout != OS_WaitForever)
+        {
+            const OS_Ticks Elapsed = OS_GetTicks () - Start;
+            if (Elapsed >= timeout)
+            {
+                SEMAPHORE_Release (&self->complete);
+                return OS_Result_Timeout;
+            }
+
+            wait = timeout - Elapsed;
+        }
+
+        const enum OS_Result R = OS_TaskWaitForSignal (
+                                        OS_TaskSignalType_SemaphoreAcquire,
+                                        &self->complete, wait);
+        SEMAPHORE_Release (&self->complete);
+
+        if (R != OS_Result_OK && R != OS_Result_Timeout)
+        {
+            return R;
+        }
+    }
+}
+
+
+struct StorageWaitAny
+{
+    struct OS_StorageHandle     *handles;
+    enum STORAGE_Result         *result;
+};
+
+
+static enum OS_Result storagePollAt (void *ctx, uint32_t i)
+{
+    struct StorageWaitAny *wa = (struct StorageWaitAny *) ctx;
+    return OS_StoragePoll (&wa->handles[i], wa->result);
+}
+
+
+// Waits until any of the given jobs completes. *index is set to the completed
+// handle position. Handles already retrieved are skipped.
+enum OS_Result OS_StorageWaitAny (struct OS_StorageHandle handles[],
+                                  uint32_t count, OS_Ticks timeout,
+                                  uint32_t *index, enum STORAGE_Result *result)
+{
+    if (!handles)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct StorageWaitAny wa = { .handles = handles, .result = result };
+    return waitAny (storagePollAt, &wa, count, timeout, index);
+}
+
+
+// Blocking com access: the caller sleeps until the job completes or the
+// timeout expires. *processed gets the byte count sent or received either way.
+enum OS_Result OS_TaskDriverCom (const char *description,
+                                 enum OS_TaskDriverOp op,
+                                 enum OS_ComRecvMode mode,
+                                 uint8_t *buf, uint32_t count,
+                                 OS_Ticks timeout, uint32_t *processed)
+{
+    struct OS_ComHandle handle;
+    enum OS_Result      result;
+    enum OS_Result      r;
+
+    if ((r = OS_ComSubmit (description, op, mode, buf, count, timeout,
+                           &handle)) != OS_Result_OK)
     {
-        // Inmediate result
         return r;
     }
 
-    // Deferred result
-    return sa.result;
+    // The driver completes the job once its deadline expires
+    if ((r = OS_ComWaitAny (&handle, 1, OS_WaitForever, NULL, processed,
+                            &result)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    return result;
 }
 
 
+// Queues a com job and returns immediately. The job descriptor is copied by
+// the driver, only the data buffer must remain valid until completion, as
+// retrieved with OS_ComPoll() / OS_ComWaitAny(). Deadline is relative to now,
+// OS_WaitForever for none. Mode applies to receptions only.
+enum OS_Result OS_ComSubmit (const char *description, enum OS_TaskDriverOp op,
+                             enum OS_ComRecvMode mode,
+                             uint8_t *buf, uint32_t count,
+                             OS_Ticks deadline, struct OS_ComHandle *handle)
+{
+    if (!OS_RuntimeTask ())
+    {
+        return OS_Result_InvalidCaller;
+    }
+
+    if (!handle)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskDriverComSubmit cs;
+    memset (&cs, 0, sizeof(cs));
+
+    cs.access.description   = description;
+    cs.access.op            = op;
+    cs.access.mode          = mode;
+    cs.access.buf           = buf;
+    cs.access.count         = count;
+    cs.access.timeout       = deadline;
+
+    const enum OS_Result r = OS_Syscall (OS_Syscall_TaskDriverComSubmit, &cs);
+
+    *handle = cs.handle;
+    return r;
+}
+
+
+// Returns OS_Result_OK once done (the handle is cleared) along with the job
+// result (OS_Result_OK or OS_Result_Timeout) and the byte count processed.
+// OS_Result_Waiting if still in progress or OS_Result_InvalidParams if the
+// handle is unknown or was already retrieved.
+enum OS_Result OS_ComPoll (struct OS_ComHandle *handle, uint32_t *processed,
+                           enum OS_Result *result)
+{
+    if (!OS_RuntimeTask ())
+    {
+        return OS_Result_InvalidCaller;
+    }
+
+    if (!handle || !handle->sequence)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskDriverComPoll cp;
+    cp.handle       = *handle;
+    cp.processed    = 0;
+    cp.result       = OS_Result_Waiting;
+
+    const enum OS_Result r = OS_Syscall (OS_Syscall_TaskDriverComPoll, &cp);
+    if (r == OS_Result_OK)
+    {
+        if (processed)
+        {
+            *processed = cp.processed;
+        }
+
+        if (result)
+        {
+            *result = cp.result;
+        }
+
+        memset (handle, 0, sizeof(struct OS_ComHandle));
+    }
+
+    return r;
+}
+
+
+struct ComWaitAny
+{
+    struct OS_ComHandle         *handles;
+    uint32_t                    *processed;
+    enum OS_Result              *result;
+};
+
+
+static enum OS_Result comPollAt (void *ctx, uint32_t i)
+{
+    struct ComWaitAny *wa = (struct ComWaitAny *) ctx;
+    return OS_ComPoll (&wa->handles[i], wa->processed, wa->result);
+}
+
+
+// Waits until any of the given jobs completes, see OS_StorageWaitAny().
+enum OS_Result OS_ComWaitAny (struct OS_ComHandle handles[], uint32_t count,
+                              OS_Ticks timeout, uint32_t *index,
+                              uint32_t *processed, enum OS_Result *result)
+{
+    if (!handles)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct ComWaitAny wa = { .handles = handles, .processed = processed,
+                             .result = result };
+    return waitAny (comPollAt, &wa, count, timeout, index);
+}
+
 enum OS_Result OS_TaskReturnValue (void *taskBuffer, uint32_t *retValue)
 {
     if (!taskBuffer || !retValue)
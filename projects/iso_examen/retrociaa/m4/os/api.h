@@ -37,6 +37,7 @@
 
 #include "port/ticks.h"
 #include "../base/attr.h"
+#include "../storage/misc.h"
 
 #include "chip.h"   // CMSIS
 #include <stdint.h>
@@ -130,6 +131,69 @@ enum OS_TaskSignalType
 };
 
 
+enum OS_TaskDriverOp
+{
+    OS_TaskDriverOp_Read,
+    OS_TaskDriverOp_Write,
+    // Storage only: write back any cached data and CTRL_SYNC the device.
+    OS_TaskDriverOp_Sync,
+    OS_TaskDriverOP__COUNT,
+    OS_TaskDriverOp_Recv    = OS_TaskDriverOp_Read,
+    OS_TaskDriverOp_Send    = OS_TaskDriverOp_Write
+};
+
+
+// Storage requests are served by priority; requests of the same priority are
+// sorted by sector. A request whose deadline expired is served first.
+enum OS_StoragePriority
+{
+    OS_StoragePriority_High         = 0,
+    OS_StoragePriority_Normal,
+    OS_StoragePriority_Low,
+    OS_StoragePriority__COUNT
+};
+
+
+// Identifies a storage request submitted by OS_StorageSubmit(). Contents are
+// private to the OS.
+struct OS_StorageHandle
+{
+    void                    *driver;
+    void                    *job;
+    uint32_t                sequence;
+};
+
+
+// Called from the storage driver task when a request completes. Must return
+// quickly and must not block.
+typedef void                (*OS_StorageCallback) (void *param,
+                                                   enum STORAGE_Result result);
+
+
+// Com sends complete once all data is in the driver send buffer. Receptions
+// complete once count bytes are received or, depending on the mode, earlier.
+// An expired deadline completes either one with the data processed so far.
+enum OS_ComRecvMode
+{
+    OS_ComRecvMode_Count            = 0,
+    // Up to and including the driver line end byte.
+    OS_ComRecvMode_Line,
+    // As soon as any data is available.
+    OS_ComRecvMode_Any,
+    OS_ComRecvMode__COUNT
+};
+
+
+// Identifies a com request submitted by OS_ComSubmit(). Contents are private
+// to the OS.
+struct OS_ComHandle
+{
+    void                    *driver;
+    void                    *job;
+    uint32_t                sequence;
+};
+
+
 uint32_t        OS_InitBufferSize       ();
 uint32_t        OS_TaskMinBufferSize    (enum OS_TaskType type,
                                          void *initParams);
@@ -164,3 +228,43 @@ enum OS_Result  OS_TaskWaitForSignal    (enum OS_TaskSignalType sigType,
 enum OS_Result  OS_TaskSleep            (void *taskBuffer);
 enum OS_Result  OS_TaskWakeup           (void *taskBuffer);
 enum OS_Result  OS_TaskReturnValue      (void *taskBuffer, uint32_t *retValue);
+
+enum OS_Result  OS_TaskDriverStorage    (const char* description,
+                                         enum OS_TaskDriverOp op,
+                                         uint8_t *buf, uint32_t sector,
+                                         uint32_t count);
+enum OS_Result  OS_StorageSubmit        (const char *description,
+                                         enum OS_TaskDriverOp op,
+                                         uint8_t *buf, uint32_t sector,
+                                         uint32_t count,
+                                         enum OS_StoragePriority priority,
+                                         OS_Ticks deadline,
+                                         OS_StorageCallback callback,
+                                         void *callbackParam,
+                                         struct OS_StorageHandle *handle);
+enum OS_Result  OS_StoragePoll          (struct OS_StorageHandle *handle,
+                                         enum STORAGE_Result *result);
+enum OS_Result  OS_StorageWaitAny       (struct OS_StorageHandle handles[],
+                                         uint32_t count, OS_Ticks timeout,
+                                         uint32_t *index,
+                                         enum STORAGE_Result *result);
+
+enum OS_Result  OS_TaskDriverCom        (const char *description,
+                                         enum OS_TaskDriverOp op,
+                                         enum OS_ComRecvMode mode,
+                                         uint8_t *buf, uint32_t count,
+                                         OS_Ticks timeout,
+                                         uint32_t *processed);
+enum OS_Result  OS_ComSubmit            (const char *description,
+                                         enum OS_TaskDriverOp op,
+                                         enum OS_ComRecvMode mode,
+                                         uint8_t *buf, uint32_t count,
+                                         OS_Ticks deadline,
+                                         struct OS_ComHandle *handle);
+enum OS_Result  OS_ComPoll              (struct OS_ComHandle *handle,
+                                         uint32_t *processed,
+                                         enum OS_Result *result);
+enum OS_Result  OS_ComWaitAny           (struct OS_ComHandle handles[],
+                                         uint32_t count, OS_Ticks timeout,
+                                         uint32_t *index, uint32_t *processed,
+                                         enum OS_Result *result);
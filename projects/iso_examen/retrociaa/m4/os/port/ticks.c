@@ -34,12 +34,14 @@
     POSSIBILITY OF SUCH DAMAGE.
 */
 #include "ticks.h"
+#include "../../base/attr.h"
 #ifndef RETROS_CUSTOM_SYSTICK
 #include "../../base/systick.h"
 #endif
 
 
 #ifndef RETROS_CUSTOM_SYSTICK
+ATTR_RamFunc
 inline OS_Ticks OS_GetTicks ()
 {
     return SYSTICK_Now ();
@@ -0,0 +1,497 @@
+#include "com.h"
+#include "common.h"
+#include "../opaque.h"
+#include "../../scheduler.h"
+#include "../../../base/debug.h"
+#include <stddef.h>
+#include <string.h>
+
+
+inline static struct OS_DRIVER_ComData * getComData (
+                                                struct OS_TaskControl *task)
+{
+    return (struct OS_DRIVER_ComData *) &((uint8_t *) task)
+                            [task->size - sizeof(struct OS_DRIVER_ComData)];
+}
+
+
+inline static struct OS_DRIVER_ComJob * getJobs (struct OS_TaskControl *task)
+{
+    return (struct OS_DRIVER_ComJob *) &((uint8_t *) task)[task->stackTop];
+}
+
+
+// Called from the UART interrupt. Wakes the driver only if there are jobs
+// waiting for the event.
+static void uartEvent (void *param, enum UART_Event event)
+{
+    struct OS_TaskControl       *task   = (struct OS_TaskControl *) param;
+    struct OS_DRIVER_ComData    *data   = getComData (task);
+    struct QUEUE                *queue  = (event == UART_Event_Recv)
+                                                ? &data->recvQueue
+                                                : &data->sendQueue;
+
+    if (!QUEUE_Empty (queue) && SEMAPHORE_Release (&task->sleep))
+    {
+        OS_SchedulerCallPending ();
+    }
+}
+
+
+inline static uint32_t uartBufferSize (struct OS_DRIVER_ComUARTParams
+                                       *uartParams)
+{
+    // Cyclic buffers must be 2^n. Sizes below 4 would break data alignment.
+    if (!DEBUG_Assert (uartParams
+                && uartParams->recvSize >= 4
+                && uartParams->sendSize >= 4
+                && !(uartParams->recvSize & (uartParams->recvSize - 1))
+                && !(uartParams->sendSize & (uartParams->sendSize - 1))))
+    {
+        return 0;
+    }
+
+    return uartParams->recvSize + uartParams->sendSize;
+}
+
+
+inline static enum OS_Result uartInit (struct OS_TaskControl *task,
+                                       struct OS_DRIVER_ComUARTParams
+                                       *uartParams, uint8_t *bStart)
+{
+    struct OS_DRIVER_ComData *data = getComData (task);
+
+    uint8_t *recvBuffer = &bStart[0];
+    uint8_t *sendBuffer = &bStart[uartParams->recvSize];
+
+    if (!UART_Init (&data->uart, uartParams->handler, uartParams->baud,
+                    recvBuffer, uartParams->recvSize,
+                    sendBuffer, uartParams->sendSize))
+    {
+        return OS_Result_Error;
+    }
+
+    // Interrupts were just enabled; the event function is set last.
+    data->uart.eventParam   = task;
+    data->uart.event        = uartEvent;
+    return OS_Result_OK;
+}
+
+
+uint32_t OS_DRIVER_ComBufferSize (struct OS_DRIVER_ComInitParams
+                                  *initParams)
+{
+    if (!DEBUG_Assert (initParams && initParams->jobs && initParams->params))
+    {
+        return 0;
+    }
+
+    uint32_t deviceSize = 0;
+
+    switch (initParams->type)
+    {
+        case OS_DRIVER_ComType_UART:
+            deviceSize = uartBufferSize ((struct OS_DRIVER_ComUARTParams *)
+                                                        initParams->params);
+            break;
+
+        default:
+            break;
+    }
+
+    if (!DEBUG_Assert (deviceSize))
+    {
+        return 0;
+    }
+
+    return sizeof(struct OS_DRIVER_ComJob) * initParams->jobs
+            + deviceSize
+            + sizeof(struct OS_DRIVER_ComData);
+}
+
+
+enum OS_Result OS_DRIVER_ComInit (struct OS_TaskControl *task,
+                                  struct OS_DRIVER_ComInitParams *initParams)
+{
+    if (!task || !initParams || !initParams->jobs || !initParams->params)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    const uint32_t  BufferSize  = OS_DRIVER_ComBufferSize (initParams);
+    uint8_t         *buffer     = (uint8_t *) task;
+
+    if (!DEBUG_Assert (BufferSize && !(BufferSize & 0b11)))
+    {
+        return OS_Result_InvalidBufferSize;
+    }
+
+    task->stackTop = task->size - BufferSize;
+
+    if ((uint32_t)&buffer[task->stackTop] & 0b11)
+    {
+        return OS_Result_InvalidBufferAlignment;
+    }
+
+    memset (&buffer[task->stackTop], 0, BufferSize);
+
+    struct OS_DRIVER_ComData *data = getComData (task);
+
+    QUEUE_Init (&data->sendQueue);
+    QUEUE_Init (&data->recvQueue);
+    QUEUE_Init (&data->free);
+
+    data->maxJobs   = initParams->jobs;
+    data->type      = initParams->type;
+    data->lineEnd   = initParams->lineEnd;
+
+    struct OS_DRIVER_ComJob *jobs = getJobs (task);
+    for (uint32_t i = 0; i < data->maxJobs; ++i)
+    {
+        QUEUE_PushNode (&data->free, &jobs[i].node);
+    }
+
+    enum OS_Result r;
+    if ((r = OS_MUTEX_Init (&data->mutex)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    uint8_t *bStart = (uint8_t *) &jobs[data->maxJobs];
+
+    switch (initParams->type)
+    {
+        case OS_DRIVER_ComType_UART:
+            task->priority = OS_TaskPriority_DriverComUART;
+            return uartInit (task, (struct OS_DRIVER_ComUARTParams *)
+                             initParams->params, bStart);
+
+        default:
+            break;
+    }
+
+    return OS_Result_Error;
+}
+
+
+// Called from the syscall handler. *ca contents are copied to a free job slot,
+// only the data buffer (ca->buf) must remain valid until the job completes.
+enum OS_Result OS_DRIVER_ComJobAdd (struct OS_TaskControl *task,
+                                    struct OS_TaskControl *owner,
+                                    struct OS_TaskDriverComAccess *ca,
+                                    struct OS_ComHandle *handle)
+{
+    if (!task || !owner || !ca || !handle)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_DRIVER_ComData *data = getComData (task);
+
+    struct OS_DRIVER_ComJob *job = (struct OS_DRIVER_ComJob *)
+                                                QUEUE_PopNode (&data->free);
+    if (!job)
+    {
+        return OS_Result_BufferFull;
+    }
+
+    if (!DEBUG_Assert (job->state == OS_DRIVER_ComJobState_Free))
+    {
+        return OS_Result_AssertionFailed;
+    }
+
+    // Sequence zero is never used so a zeroed handle is always invalid.
+    if (!++ data->sequence)
+    {
+        ++ data->sequence;
+    }
+
+    job->access             = *ca;
+    job->access.processed   = 0;
+    job->access.result      = OS_Result_Waiting;
+    job->owner              = owner;
+    job->deadline           = (ca->timeout == OS_WaitForever)
+                                    ? OS_WaitForever
+                                    : OS_GetTicks () + ca->timeout;
+    job->sequence           = data->sequence;
+    job->state              = OS_DRIVER_ComJobState_Queued;
+
+    handle->driver      = task;
+    handle->job         = job;
+    handle->sequence    = job->sequence;
+
+    QUEUE_PushNode ((ca->op == OS_TaskDriverOp_Send)? &data->sendQueue
+                                                    : &data->recvQueue,
+                    &job->node);
+    return OS_Result_OK;
+}
+
+
+// Called from the syscall handler. Returns OS_Result_Waiting while the job is
+// queued. Once done, the job result and processed byte count are returned and
+// the job slot released; the handle is no longer valid.
+enum OS_Result OS_DRIVER_ComJobResult (struct OS_ComHandle *handle,
+                                       uint32_t *processed,
+                                       enum OS_Result *result)
+{
+    if (!handle || !handle->driver || !handle->job || !handle->sequence)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskControl       *task   = handle->driver;
+    struct OS_DRIVER_ComData    *data   = getComData (task);
+    struct OS_DRIVER_ComJob     *jobs   = getJobs (task);
+    struct OS_DRIVER_ComJob     *job    = handle->job;
+
+    if (task->type != OS_TaskType_DriverUART
+            || job < jobs || job >= &jobs[data->maxJobs]
+            || job->sequence != handle->sequence
+            || job->state == OS_DRIVER_ComJobState_Free)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    if (job->state != OS_DRIVER_ComJobState_Done)
+    {
+        return OS_Result_Waiting;
+    }
+
+    if (processed)
+    {
+        *processed = job->access.processed;
+    }
+
+    if (result)
+    {
+        *result = job->access.result;
+    }
+
+    job->state = OS_DRIVER_ComJobState_Free;
+    QUEUE_PushNode (&data->free, &job->node);
+
+    return OS_Result_OK;
+}
+
+
+// Must be called with the driver lock taken. The job slot may be released by
+// the owner as soon as it is marked as done.
+static void jobDone (struct OS_DRIVER_ComData *data, struct QUEUE *queue,
+                     struct OS_DRIVER_ComJob *job, enum OS_Result result)
+{
+    struct OS_TaskControl *owner = job->owner;
+
+    QUEUE_DetachNode (queue, &job->node);
+
+    job->access.result = result;
+    ++ data->jobsDone;
+
+    __DMB ();
+    job->state = OS_DRIVER_ComJobState_Done;
+
+    // Wake the owner if waiting for completion (see OS_ComWaitAny).
+    if (SEMAPHORE_Release (&owner->complete))
+    {
+        OS_SchedulerCallPending ();
+    }
+}
+
+
+inline static struct OS_DRIVER_ComJob * jobHead (struct QUEUE *queue)
+{
+    const uint32_t Lock = OS_DRIVER_Lock ();
+    struct OS_DRIVER_ComJob *job = (struct OS_DRIVER_ComJob *)
+                                                        QUEUE_Head (queue);
+    OS_DRIVER_Unlock (Lock);
+    return job;
+}
+
+
+inline static void jobHeadDone (struct OS_DRIVER_ComData *data,
+                                struct QUEUE *queue,
+                                struct OS_DRIVER_ComJob *job)
+{
+    const uint32_t Lock = OS_DRIVER_Lock ();
+    jobDone (data, queue, job, OS_Result_OK);
+    OS_DRIVER_Unlock (Lock);
+}
+
+
+// Fills the send buffer from queued send jobs. The UART interrupt keeps
+// transmitting and signals back once the buffer gets half empty.
+static void sendJobs (struct OS_DRIVER_ComData *data)
+{
+    struct CYCLIC           *send = &data->uart.send;
+    struct OS_DRIVER_ComJob *job;
+
+    while ((job = jobHead (&data->sendQueue)))
+    {
+        struct OS_TaskDriverComAccess *ca = &job->access;
+
+        // A cyclic buffer holds at most capacity - 1 bytes
+        const uint32_t Room = send->capacity - 1 - CYCLIC_Pending (send);
+
+        uint32_t count = ca->count - ca->processed;
+        if (count > Room)
+        {
+            count = Room;
+        }
+
+        if (count)
+        {
+            CYCLIC_InFromBuffer (send, &ca->buf[ca->processed], count);
+            UART_Send (&data->uart);
+
+            ca->processed   += count;
+            data->bytesSent += count;
+        }
+
+        if (ca->processed < ca->count)
+        {
+            return;
+        }
+
+        jobHeadDone (data, &data->sendQueue, job);
+    }
+}
+
+
+// Moves received data to queued recv jobs. A line job takes data up to the
+// line end byte only, leaving the rest for the next job.
+static void recvJobs (struct OS_DRIVER_ComData *data)
+{
+    struct CYCLIC           *recv = &data->uart.recv;
+    struct OS_DRIVER_ComJob *job;
+
+    while ((job = jobHead (&data->recvQueue)))
+    {
+        struct OS_TaskDriverComAccess *ca = &job->access;
+
+        const uint32_t Pending = CYCLIC_Pending (recv);
+
+        uint32_t count = ca->count - ca->processed;
+        if (count > Pending)
+        {
+            count = Pending;
+        }
+
+        bool lineEnd = false;
+        if (ca->mode == OS_ComRecvMode_Line)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (CYCLIC_Peek (recv, i) == data->lineEnd)
+                {
+                    count   = i + 1;
+                    lineEnd = true;
+                    break;
+                }
+            }
+        }
+
+        if (count)
+        {
+            CYCLIC_OutToBuffer (recv, &ca->buf[ca->processed], count);
+
+            ca->processed       += count;
+            data->bytesReceived += count;
+        }
+
+        if (lineEnd)
+        {
+            ++ data->linesReceived;
+        }
+        else if (ca->processed < ca->count
+                    && !(ca->mode == OS_ComRecvMode_Any && ca->processed))
+        {
+            return;
+        }
+
+        jobHeadDone (data, &data->recvQueue, job);
+    }
+}
+
+
+// Completes expired jobs with OS_Result_Timeout. Returns the ticks left to
+// the nearest deadline, OS_WaitForever if none.
+static OS_Ticks jobsExpire (struct OS_DRIVER_ComData *data,
+                            struct QUEUE *queue)
+{
+    const OS_Ticks  Now     = OS_GetTicks ();
+    OS_Ticks        wait    = OS_WaitForever;
+
+    const uint32_t Lock = OS_DRIVER_Lock ();
+
+    struct QUEUE_Node *node = QUEUE_Head (queue);
+    while (node)
+    {
+        struct OS_DRIVER_ComJob *job = (struct OS_DRIVER_ComJob *) node;
+        node = QUEUE_Next (queue, node);
+
+        if (job->deadline == OS_WaitForever)
+        {
+            continue;
+        }
+
+        if (job->deadline <= Now)
+        {
+            ++ data->jobsExpired;
+            jobDone (data, queue, job, OS_Result_Timeout);
+            continue;
+        }
+
+        if (job->deadline - Now < wait)
+        {
+            wait = job->deadline - Now;
+        }
+    }
+
+    OS_DRIVER_Unlock (Lock);
+    return wait;
+}
+
+
+enum OS_Result OS_DRIVER_ComLock (struct OS_TaskControl *task)
+{
+    if (!task)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    return OS_MUTEX_Lock (&getComData(task)->mutex);
+}
+
+
+enum OS_Result OS_DRIVER_ComUnlock (struct OS_TaskControl *task)
+{
+    if (!task)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    return OS_MUTEX_Unlock (&getComData(task)->mutex);
+}
+
+
+// Sleeps until the next job timeout, a UART event or a new job.
+static OS_Ticks serve (struct OS_TaskControl *task)
+{
+    struct OS_DRIVER_ComData *data = getComData (task);
+
+    recvJobs (data);
+    sendJobs (data);
+
+    const OS_Ticks RecvWait = jobsExpire (data, &data->recvQueue);
+    const OS_Ticks SendWait = jobsExpire (data, &data->sendQueue);
+
+    return (RecvWait < SendWait)? RecvWait : SendWait;
+}
+
+
+OS_TaskRetVal OS_DRIVER_ComTask (OS_TaskParam arg)
+{
+    (void) arg;
+
+    OS_DRIVER_TaskLoop (OS_TaskSelf (), serve);
+    return 0;
+}
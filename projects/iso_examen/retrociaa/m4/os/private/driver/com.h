@@ -20,6 +20,9 @@ enum OS_DRIVER_ComType
 struct OS_DRIVER_ComInitParams
 {
     enum OS_DRIVER_ComType  type;
+    uint32_t                jobs;
+    // Byte ending a frame on OS_ComRecvMode_Line receptions.
+    uint32_t                lineEnd;
     void                    *params;
 };
 
@@ -34,19 +37,66 @@ struct OS_DRIVER_ComUARTParams
 };
 
 
-struct OS_DRIVER_ComUART
+enum OS_DRIVER_ComJobState
 {
-    struct UART             uart;
-    struct OS_MUTEX         mutex;
+    OS_DRIVER_ComJobState_Free = 0,
+    OS_DRIVER_ComJobState_Queued,
+    OS_DRIVER_ComJobState_Done
 };
 
 
+struct OS_DRIVER_ComJob
+{
+    struct QUEUE_Node               node;
+    struct OS_TaskDriverComAccess   access;
+    struct OS_TaskControl           *owner;
+    OS_Ticks                        deadline;
+    uint32_t                        sequence;
+    enum OS_DRIVER_ComJobState      state;
+}
+ATTR_DataAlign4;
+
+
+struct OS_DRIVER_ComData
+{
+    // Send and recv jobs are served in submission order, each queue on its
+    // own.
+    struct QUEUE                    sendQueue;
+    struct QUEUE                    recvQueue;
+    struct QUEUE                    free;
+    uint32_t                        maxJobs;
+    uint32_t                        sequence;
+    enum OS_DRIVER_ComType          type;
+    uint32_t                        lineEnd;
+    struct UART                     uart;
+    struct OS_MUTEX                 mutex;
+    uint32_t                        jobsDone;
+    uint32_t                        jobsExpired;
+    uint32_t                        bytesSent;
+    uint32_t                        bytesReceived;
+    uint32_t                        linesReceived;
+}
+ATTR_DataAlign4;
+
+
 uint32_t        OS_DRIVER_ComBufferSize     (struct OS_DRIVER_ComInitParams
                                              *initParams);
 enum OS_Result  OS_DRIVER_ComInit           (struct OS_TaskControl *task,
                                              struct OS_DRIVER_ComInitParams
                                              *initParams);
+enum OS_Result  OS_DRIVER_ComJobAdd         (struct OS_TaskControl *task,
+                                             struct OS_TaskControl *owner,
+                                             struct OS_TaskDriverComAccess *ca,
+                                             struct OS_ComHandle *handle);
+enum OS_Result  OS_DRIVER_ComJobResult      (struct OS_ComHandle *handle,
+                                             uint32_t *processed,
+                                             enum OS_Result *result);
+// Clients that need a sequence of jobs not to be interleaved with jobs from
+// other clients hold this lock around it. Returns OS_Result_Retry while it is
+// held by another task.
 enum OS_Result  OS_DRIVER_ComLock           (struct OS_TaskControl *task);
 enum OS_Result  OS_DRIVER_ComUnlock         (struct OS_TaskControl *task);
-enum OS_Result  OS_DRIVER_ComAccess         (struct OS_TaskControl *task,
-                                             struct OS_TaskDriverComAccess *ca);
+// Com driver task function: moves data between queued jobs and the device
+// given in OS_DRIVER_ComInitParams, sleeping until a job is submitted, the
+// device interrupt signals new data or room to send, or a deadline expires.
+OS_TaskRetVal   OS_DRIVER_ComTask           (OS_TaskParam arg);
@@ -0,0 +1,19 @@
+#include "common.h"
+
+
+// Driver task main loop. Never returns.
+void OS_DRIVER_TaskLoop (struct OS_TaskControl *task, OS_DRIVER_ServeFunc serve)
+{
+    while (1)
+    {
+        // Taken before serving so a wakeup in between (job submission, see
+        // taskWakeup, or a device event) is not missed.
+        SEMAPHORE_Acquire (&task->sleep);
+
+        const OS_Ticks Wait = serve (task);
+
+        OS_TaskWaitForSignal (OS_TaskSignalType_SemaphoreAcquire,
+                              &task->sleep, Wait);
+        SEMAPHORE_Release (&task->sleep);
+    }
+}
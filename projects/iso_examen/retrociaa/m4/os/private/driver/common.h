@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../../api.h"
+#include "../../private/opaque.h"
+#include "chip.h"       // CMSIS
+
+
+// Job queues are shared between the syscall handler (job submission and
+// result retrieval) and the driver tasks running in privileged thread mode.
+// Driver side changes are done with SVCall (and lower priorities, like the
+// UART interrupt) masked.
+inline static uint32_t OS_DRIVER_Lock ()
+{
+    const uint32_t BasePri = __get_BASEPRI ();
+    __set_BASEPRI (OS_IntPrioritySyscall << (8 - __NVIC_PRIO_BITS));
+    __ISB ();
+    return BasePri;
+}
+
+
+inline static void OS_DRIVER_Unlock (const uint32_t BasePri)
+{
+    __set_BASEPRI (BasePri);
+    __ISB ();
+}
+
+
+// Serves pending work and returns how long the driver task may sleep.
+typedef OS_Ticks (* OS_DRIVER_ServeFunc) (struct OS_TaskControl *task);
+
+
+void    OS_DRIVER_TaskLoop      (struct OS_TaskControl *task,
+                                 OS_DRIVER_ServeFunc serve);
@@ -1,11 +1,12 @@
 #include "storage.h"
+#include "common.h"
 #include "../opaque.h"
 #include "../../scheduler.h"
 #include "../../../base/debug.h"
+#include <stddef.h>
 #include <string.h>
 
 
-
 inline static struct OS_DRIVER_StorageData * getStorageData (
                                                 struct OS_TaskControl *task)
 {
@@ -16,6 +17,15 @@ inline static struct OS_DRIVER_StorageData * getStorageData (
 }
 
 
+inline static struct OS_DRIVER_StorageJob * getJob (
+                                        struct OS_TaskDriverStorageAccess *sa)
+{
+    return (struct OS_DRIVER_StorageJob *)
+                    &((uint8_t *) sa)[-offsetof(struct OS_DRIVER_StorageJob,
+                                                access)];
+}
+
+
 uint32_t OS_DRIVER_StorageBufferSize (struct OS_DRIVER_StorageInitParams
                                       *initParams)
 {
@@ -24,8 +34,21 @@ uint32_t OS_DRIVER_StorageBufferSize (struct OS_DRIVER_StorageInitParams
         return 0;
     }
 
+    // Cache sets must be 2^n and have at least one way.
+    if (!DEBUG_Assert (!(initParams->cacheSets & (initParams->cacheSets - 1))
+                       && (!initParams->cacheSets || initParams->cacheWays)))
+    {
+        return 0;
+    }
+
+    const uint32_t CacheLines = initParams->cacheSets * initParams->cacheWays;
+
     return sizeof(struct OS_DRIVER_StorageJob) * initParams->jobs
-                                    + sizeof(struct OS_DRIVER_StorageData);
+            + (sizeof(struct OS_DRIVER_StorageCacheLine) + STORAGE_SectorSize)
+                                                                * CacheLines
+            + STORAGE_SectorSize * initParams->readAhead
+            + STORAGE_SectorSize * initParams->mergeSectors
+            + sizeof(struct OS_DRIVER_StorageData);
 }
 
 
@@ -59,60 +82,252 @@ enum OS_Result OS_DRIVER_StorageInit (struct OS_TaskControl *task,
 
     struct OS_DRIVER_StorageData *data = getStorageData (task);
 
-    data->maxJobs     = initParams->jobs;
-    data->nextFreeJob = (struct OS_DRIVER_StorageJob *)
+    QUEUE_Init (&data->queue);
+    QUEUE_Init (&data->free);
+
+    data->maxJobs       = initParams->jobs;
+    data->device        = initParams->device;
+    data->cacheSets     = initParams->cacheSets;
+    data->cacheWays     = initParams->cacheSets? initParams->cacheWays : 0;
+    data->readAhead     = initParams->readAhead;
+    data->mergeSectors  = initParams->mergeSectors;
+
+    struct OS_DRIVER_StorageJob *jobs = (struct OS_DRIVER_StorageJob *)
                                                     &buffer[task->stackTop];
+    for (uint32_t i = 0; i < data->maxJobs; ++i)
+    {
+        QUEUE_PushNode (&data->free, &jobs[i].node);
+    }
+
+    const uint32_t CacheLines = data->cacheSets * data->cacheWays;
+
+    data->cacheLines        = (struct OS_DRIVER_StorageCacheLine *)
+                                                    &jobs[data->maxJobs];
+    data->cacheData         = (uint8_t *) &data->cacheLines[CacheLines];
+    data->readAheadBuffer   = &data->cacheData[CacheLines
+                                                    * STORAGE_SectorSize];
+    data->mergeBuffer       = &data->readAheadBuffer[data->readAhead
+                                                    * STORAGE_SectorSize];
     return OS_Result_OK;
 }
 
 
-// WARNING: Whoever call this function must assure the integrity of *sa contents
-//          in memory across all operations involving that data. This means to
-//          avoid destruction of the local struct after exiting the OS API call
-//          that produced the syscall. This is currently managed by putting the
-//          caller task to sleep until the storage operation completes, but can
-//          be made asynchronic by performing a deep copy of the data.
+// Called from the syscall handler. *sa contents are copied to a free job slot,
+// so the caller does not need to keep them alive. Only the data buffer
+// (sa->buf) must remain valid until the job completes.
 enum OS_Result OS_DRIVER_StorageJobAdd (struct OS_TaskControl *task,
-                                        struct OS_TaskDriverStorageAccess *sa)
+                                        struct OS_TaskControl *owner,
+                                        struct OS_TaskDriverStorageAccess *sa,
+                                        struct OS_StorageHandle *handle)
 {
-    if (!task || !sa)
+    if (!task || !owner || !sa || !handle)
     {
         return OS_Result_InvalidParams;
     }
 
     struct OS_DRIVER_StorageData *data = getStorageData (task);
 
-    if (data->queue.elements >= data->maxJobs)
+    struct OS_DRIVER_StorageJob *job = (struct OS_DRIVER_StorageJob *)
+                                                QUEUE_PopNode (&data->free);
+    if (!job)
     {
         return OS_Result_BufferFull;
     }
 
-    struct OS_DRIVER_StorageJob *job = data->nextFreeJob;
-    // This should never happen given the number of elements in the queue is
-    // less than data->maxJobs.
-    if (!DEBUG_Assert (!job->access))
+    // This should never happen given the job was taken from the free list.
+    if (!DEBUG_Assert (job->state == OS_DRIVER_StorageJobState_Free))
     {
         return OS_Result_AssertionFailed;
     }
 
-    // Next free job. This works because jobs are consumed in a FIFO scheme.
-    if ((void *)(++ data->nextFreeJob) == (void *)data)
+    // Sequence zero is never used so a zeroed handle is always invalid.
+    if (!++ data->sequence)
+    {
+        ++ data->sequence;
+    }
+
+    job->access             = *sa;
+    job->access.processed   = 0;
+    job->access.result      = STORAGE_Result_NotReady;
+    job->owner              = owner;
+    job->deadline           = (sa->timeout == OS_WaitForever)
+                                    ? OS_WaitForever
+                                    : OS_GetTicks () + sa->timeout;
+    job->sequence           = data->sequence;
+    job->state              = OS_DRIVER_StorageJobState_Queued;
+
+    handle->driver      = task;
+    handle->job         = job;
+    handle->sequence    = job->sequence;
+
+    QUEUE_PushNode (&data->queue, &job->node);
+
+    return OS_Result_OK;
+}
+
+
+// Called from the syscall handler. Returns OS_Result_Waiting while the job is
+// queued or being processed. Once done, the result is returned and the job
+// slot released; the handle is no longer valid.
+enum OS_Result OS_DRIVER_StorageJobResult (struct OS_StorageHandle *handle,
+                                           enum STORAGE_Result *result)
+{
+    if (!handle || !handle->driver || !handle->job || !handle->sequence)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskControl           *task   = handle->driver;
+    struct OS_DRIVER_StorageData    *data   = getStorageData (task);
+    struct OS_DRIVER_StorageJob     *jobs   = (struct OS_DRIVER_StorageJob *)
+                                        &((uint8_t *) task)[task->stackTop];
+    struct OS_DRIVER_StorageJob     *job    = handle->job;
+
+    if (task->type != OS_TaskType_DriverStorage
+            || job < jobs || job >= &jobs[data->maxJobs]
+            || job->sequence != handle->sequence
+            || job->state == OS_DRIVER_StorageJobState_Free)
     {
-        data->nextFreeJob = (struct OS_DRIVER_StorageJob *)
-                                            &((uint8_t *)task)[task->stackTop];
+        // Unknown, already retrieved or completed through a callback.
+        return OS_Result_InvalidParams;
     }
 
-    job->access = sa;
+    if (job->state != OS_DRIVER_StorageJobState_Done)
+    {
+        return OS_Result_Waiting;
+    }
 
-    if (!QUEUE_PushNode (&data->queue, (struct QUEUE_Node *) job))
+    if (result)
     {
-        return OS_Result_Error;
+        *result = job->access.result;
     }
 
+    job->state = OS_DRIVER_StorageJobState_Free;
+    QUEUE_PushNode (&data->free, &job->node);
+
     return OS_Result_OK;
 }
 
 
+inline static bool jobOverlaps (const struct OS_TaskDriverStorageAccess *a,
+                                const struct OS_TaskDriverStorageAccess *b)
+{
+    return a->sector < b->sector + b->count && b->sector < a->sector + a->count;
+}
+
+
+// Jobs are queued in submission order. A job can be served ahead of earlier
+// ones unless it depends on them: syncs act as barriers and accesses to
+// overlapping sectors keep their order if any of them is a write. Only called
+// on jobs inside the schedule window, so at most
+// OS_DRIVER_StorageScheduleWindow - 1 earlier jobs are checked.
+static bool jobEligible (struct OS_DRIVER_StorageData *data,
+                         struct OS_DRIVER_StorageJob *job)
+{
+    const struct OS_TaskDriverStorageAccess *sa = &job->access;
+
+    for (struct QUEUE_Node *node = QUEUE_Head (&data->queue);
+         node && node != &job->node;
+         node = QUEUE_Next (&data->queue, node))
+    {
+        const struct OS_TaskDriverStorageAccess *prev =
+                                &((struct OS_DRIVER_StorageJob *) node)->access;
+
+        if (sa->op == OS_TaskDriverOp_Sync || prev->op == OS_TaskDriverOp_Sync)
+        {
+            return false;
+        }
+
+        if ((sa->op == OS_TaskDriverOp_Write
+                    || prev->op == OS_TaskDriverOp_Write)
+                && jobOverlaps (sa, prev))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Chooses the next job to serve: the earliest expired deadline if any,
+// otherwise the highest priority job following the head position (C-SCAN
+// elevator), wrapping around to the lowest sector. The queue head is always
+// eligible, so the oldest job can't starve.
+static struct OS_DRIVER_StorageJob * jobSchedule (
+                                            struct OS_DRIVER_StorageData *data)
+{
+    const OS_Ticks Now = OS_GetTicks ();
+
+    struct OS_DRIVER_StorageJob *expired    = NULL;
+    struct OS_DRIVER_StorageJob *ahead      = NULL;
+    struct OS_DRIVER_StorageJob *lowest     = NULL;
+
+    uint32_t scanned = 0;
+    for (struct QUEUE_Node *node = QUEUE_Head (&data->queue);
+         node && scanned < OS_DRIVER_StorageScheduleWindow;
+         node = QUEUE_Next (&data->queue, node), ++ scanned)
+    {
+        struct OS_DRIVER_StorageJob *job = (struct OS_DRIVER_StorageJob *) node;
+
+        if (!jobEligible (data, job))
+        {
+            continue;
+        }
+
+        if (job->deadline != OS_WaitForever && job->deadline <= Now)
+        {
+            if (!expired || job->deadline < expired->deadline)
+            {
+                expired = job;
+            }
+            continue;
+        }
+
+        if (lowest && job->access.priority > lowest->access.priority)
+        {
+            continue;
+        }
+
+        if (lowest && job->access.priority < lowest->access.priority)
+        {
+            // Higher priority class found, restart the sector search.
+            lowest  = NULL;
+            ahead   = NULL;
+        }
+
+        if (!lowest || job->access.sector < lowest->access.sector)
+        {
+            lowest = job;
+        }
+
+        if (job->access.sector >= data->headSector
+                && (!ahead || job->access.sector < ahead->access.sector))
+        {
+            ahead = job;
+        }
+    }
+
+    if (expired)
+    {
+        ++ data->jobsExpired;
+        return expired;
+    }
+
+    return ahead? ahead : lowest;
+}
+
+
+inline static void jobTaken (struct OS_DRIVER_StorageData *data,
+                             struct OS_DRIVER_StorageJob *job)
+{
+    QUEUE_DetachNode (&data->queue, &job->node);
+
+    job->state          = OS_DRIVER_StorageJobState_Pending;
+    data->headSector    = job->access.sector + job->access.count;
+}
+
+
 enum OS_Result OS_DRIVER_StorageJobTake (struct OS_TaskControl *task,
                                          struct OS_TaskDriverStorageAccess **sa)
 {
@@ -123,25 +338,73 @@ enum OS_Result OS_DRIVER_StorageJobTake (struct OS_TaskControl *task,
 
     struct OS_DRIVER_StorageData *data = getStorageData (task);
 
-    if (!data->queue.head)
+    const uint32_t Lock = OS_DRIVER_Lock ();
+
+    struct OS_DRIVER_StorageJob *job = jobSchedule (data);
+    if (job)
+    {
+        jobTaken (data, job);
+    }
+
+    OS_DRIVER_Unlock (Lock);
+
+    if (!job)
     {
-        DEBUG_Assert (!data->queue.elements);
         return OS_Result_Empty;
     }
 
-    struct OS_DRIVER_StorageJob *job = (struct OS_DRIVER_StorageJob *)
-                                                        data->queue.head;
+    data->pending   = &job->access;
+    *sa             = &job->access;
 
-    if (!QUEUE_DetachNode (&data->queue, data->queue.head))
+    return OS_Result_OK;
+}
+
+
+// Takes a queued read or write job starting at the given sector and no longer
+// than maxCount, to be merged with the job ending there in a single command.
+enum OS_Result OS_DRIVER_StorageJobTakeNext (struct OS_TaskControl *task,
+                                             enum OS_TaskDriverOp op,
+                                             uint32_t sector,
+                                             uint32_t maxCount,
+                                             struct OS_TaskDriverStorageAccess
+                                             **sa)
+{
+    if (!task || !sa || op == OS_TaskDriverOp_Sync)
     {
-        return OS_Result_Error;
+        return OS_Result_InvalidParams;
     }
 
-    data->pending = job->access;
-    *sa             = job->access;
+    struct OS_DRIVER_StorageData    *data   = getStorageData (task);
+    struct OS_DRIVER_StorageJob     *job    = NULL;
 
-    // Job slot is marked as free.
-    job->access = NULL;
+    const uint32_t Lock = OS_DRIVER_Lock ();
+
+    uint32_t scanned = 0;
+    for (struct QUEUE_Node *node = QUEUE_Head (&data->queue);
+         node && scanned < OS_DRIVER_StorageScheduleWindow;
+         node = QUEUE_Next (&data->queue, node), ++ scanned)
+    {
+        struct OS_DRIVER_StorageJob *next = (struct OS_DRIVER_StorageJob *)
+                                                                        node;
+        if (next->access.op == op && next->access.sector == sector
+                && next->access.count <= maxCount
+                && jobEligible (data, next))
+        {
+            job = next;
+            jobTaken (data, job);
+            break;
+        }
+    }
+
+    OS_DRIVER_Unlock (Lock);
+
+    if (!job)
+    {
+        return OS_Result_Empty;
+    }
+
+    ++ data->jobsMerged;
+    *sa = &job->access;
 
     return OS_Result_OK;
 }
@@ -149,18 +412,24 @@ enum OS_Result OS_DRIVER_StorageJobTake (struct OS_TaskControl *task,
 
 enum OS_Result OS_DRIVER_StorageJobDone (struct OS_TaskControl *task,
                                          struct OS_TaskDriverStorageAccess *sa,
-                                         enum OS_Result result)
+                                         enum STORAGE_Result result)
 {
     if (!task || !sa)
     {
         return OS_Result_InvalidParams;
     }
 
-    sa->result = result;
+    struct OS_DRIVER_StorageData    *data   = getStorageData (task);
+    struct OS_DRIVER_StorageJob     *job    = getJob (sa);
 
-    struct OS_DRIVER_StorageData *data = getStorageData (task);
+    if (!DEBUG_Assert (job->state == OS_DRIVER_StorageJobState_Pending))
+    {
+        return OS_Result_AssertionFailed;
+    }
 
-    if (result == OS_Result_OK)
+    sa->result = result;
+
+    if (result == STORAGE_Result_Ok)
     {
         ++ data->jobsSucceeded;
     }
@@ -173,19 +442,472 @@ enum OS_Result OS_DRIVER_StorageJobDone (struct OS_TaskControl *task,
     {
         data->sectorsRead += sa->count;
     }
-    else
+    else if (sa->op == OS_TaskDriverOp_Write)
     {
         data->sectorsWritten += sa->count;
     }
 
-    // Release associate caller semaphore and set scheduler interrupt to pending
-    // to resume caller execution.
-    if (!DEBUG_Assert (SEMAPHORE_Release (sa->sem)))
+    if (data->pending == sa)
     {
-        return OS_Result_Error;
+        data->pending = NULL;
     }
 
-    OS_SchedulerCallPending ();
+    if (sa->callback)
+    {
+        // Completion is notified through the callback, the job slot is
+        // released right after.
+        sa->callback (sa->callbackParam, result);
+
+        const uint32_t Lock = OS_DRIVER_Lock ();
+        job->state = OS_DRIVER_StorageJobState_Free;
+        QUEUE_PushNode (&data->free, &job->node);
+        OS_DRIVER_Unlock (Lock);
+        return OS_Result_OK;
+    }
+
+    // The job slot may be released by the owner as soon as it is marked as
+    // done; nothing in it can be accessed afterwards.
+    struct OS_TaskControl *owner = job->owner;
+
+    __DMB ();
+    job->state = OS_DRIVER_StorageJobState_Done;
+
+    // Wake the owner if waiting for completion (see OS_StorageWaitAny). A
+    // failed release means it was not waiting; the result stays in the job
+    // slot until retrieved with OS_StoragePoll().
+    if (SEMAPHORE_Release (&owner->complete))
+    {
+        OS_SchedulerCallPending ();
+    }
 
     return OS_Result_OK;
 }
+
+
+inline static uint8_t * cacheLineData (struct OS_DRIVER_StorageData *data,
+                                       struct OS_DRIVER_StorageCacheLine *line)
+{
+    return &data->cacheData[(line - data->cacheLines) * STORAGE_SectorSize];
+}
+
+
+static struct OS_DRIVER_StorageCacheLine * cacheFind (
+                                            struct OS_DRIVER_StorageData *data,
+                                            uint32_t sector)
+{
+    if (!data->cacheWays)
+    {
+        return NULL;
+    }
+
+    struct OS_DRIVER_StorageCacheLine *line = &data->cacheLines[
+                        (sector & (data->cacheSets - 1)) * data->cacheWays];
+
+    for (uint32_t i = 0; i < data->cacheWays; ++i, ++line)
+    {
+        if ((line->flags & OS_DRIVER_StorageCacheLine_Valid)
+                && line->sector == sector)
+        {
+            line->lastUse = ++ data->cacheUses;
+            return line;
+        }
+    }
+
+    return NULL;
+}
+
+
+static enum STORAGE_Result cacheWriteBack (struct OS_DRIVER_StorageData *data,
+                                       struct OS_DRIVER_StorageCacheLine *line)
+{
+    if (!(line->flags & OS_DRIVER_StorageCacheLine_Dirty))
+    {
+        return STORAGE_Result_Ok;
+    }
+
+    const enum STORAGE_Result Result = data->device.write (
+                                                data->device.handler,
+                                                cacheLineData (data, line),
+                                                line->sector, 1);
+    if (Result == STORAGE_Result_Ok)
+    {
+        line->flags &= ~OS_DRIVER_StorageCacheLine_Dirty;
+        ++ data->cacheWriteBacks;
+    }
+
+    return Result;
+}
+
+
+// Takes an invalid or the least recently used line of the sector set, writing
+// it back first if dirty. Returns NULL if the victim could not be written.
+static struct OS_DRIVER_StorageCacheLine * cacheAlloc (
+                                            struct OS_DRIVER_StorageData *data,
+                                            uint32_t sector)
+{
+    if (!data->cacheWays)
+    {
+        return NULL;
+    }
+
+    struct OS_DRIVER_StorageCacheLine *line = &data->cacheLines[
+                        (sector & (data->cacheSets - 1)) * data->cacheWays];
+    struct OS_DRIVER_StorageCacheLine *victim = line;
+
+    for (uint32_t i = 0; i < data->cacheWays; ++i, ++line)
+    {
+        if (!(line->flags & OS_DRIVER_StorageCacheLine_Valid))
+        {
+            victim = line;
+            break;
+        }
+
+        // Unsigned difference keeps LRU order across cacheUses wrap around.
+        if (data->cacheUses - line->lastUse > data->cacheUses - victim->lastUse)
+        {
+            victim = line;
+        }
+    }
+
+    if (cacheWriteBack (data, victim) != STORAGE_Result_Ok)
+    {
+        return NULL;
+    }
+
+    victim->sector  = sector;
+    victim->flags   = OS_DRIVER_StorageCacheLine_Valid;
+    victim->lastUse = ++ data->cacheUses;
+    return victim;
+}
+
+
+static void cacheFill (struct OS_DRIVER_StorageData *data, const uint8_t *buf,
+                       uint32_t sector, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        struct OS_DRIVER_StorageCacheLine *line = cacheAlloc (data,
+                                                              sector + i);
+        if (line)
+        {
+            memcpy (cacheLineData (data, line), &buf[i * STORAGE_SectorSize],
+                    STORAGE_SectorSize);
+        }
+    }
+}
+
+
+// Prefetches the uncached sectors following a sequential read.
+static void cacheReadAhead (struct OS_DRIVER_StorageData *data,
+                            uint32_t sector)
+{
+    uint32_t count = 0;
+    while (count < data->readAhead && !cacheFind (data, sector + count))
+    {
+        ++ count;
+    }
+
+    if (!count || data->device.read (data->device.handler,
+                                     data->readAheadBuffer, sector, count)
+                                                        != STORAGE_Result_Ok)
+    {
+        return;
+    }
+
+    cacheFill (data, data->readAheadBuffer, sector, count);
+    data->sectorsReadAhead += count;
+}
+
+
+// Device transfers on the caller buffer, not on the merge buffer, are
+// zero-copy.
+static void countDirect (struct OS_DRIVER_StorageData *data,
+                         struct OS_TaskDriverStorageAccess *sa,
+                         uint32_t count)
+{
+    if (sa->buf != data->mergeBuffer)
+    {
+        data->sectorsDirect += count;
+    }
+}
+
+
+static enum STORAGE_Result jobRead (struct OS_DRIVER_StorageData *data,
+                                    struct OS_TaskDriverStorageAccess *sa)
+{
+    const bool Sequential = (sa->sector == data->nextSequential);
+
+    while (sa->processed < sa->count)
+    {
+        const uint32_t  Sector  = sa->sector + sa->processed;
+        uint8_t         *buf    = &sa->buf[sa->processed * STORAGE_SectorSize];
+
+        struct OS_DRIVER_StorageCacheLine *line = cacheFind (data, Sector);
+        if (line)
+        {
+            memcpy (buf, cacheLineData (data, line), STORAGE_SectorSize);
+            ++ data->cacheHits;
+            ++ data->sectorsCopied;
+            ++ sa->processed;
+            continue;
+        }
+
+        // Consecutive misses are read in a single (multiple block) command
+        uint32_t run = 1;
+        while (sa->processed + run < sa->count
+                && !cacheFind (data, Sector + run))
+        {
+            ++ run;
+        }
+
+        const enum STORAGE_Result Result = data->device.read (
+                                                data->device.handler,
+                                                buf, Sector, run);
+        if (Result != STORAGE_Result_Ok)
+        {
+            return Result;
+        }
+
+        countDirect (data, sa, run);
+
+        // Large runs are streaming reads, not worth evicting cached
+        // (FAT/directory) sectors for.
+        if (run <= data->cacheWays)
+        {
+            cacheFill (data, buf, Sector, run);
+        }
+
+        data->cacheMisses   += run;
+        sa->processed       += run;
+    }
+
+    data->nextSequential = sa->sector + sa->count;
+
+    if (Sequential && data->readAhead && data->cacheWays)
+    {
+        cacheReadAhead (data, data->nextSequential);
+    }
+
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result jobWrite (struct OS_DRIVER_StorageData *data,
+                                     struct OS_TaskDriverStorageAccess *sa)
+{
+    // Write-through for large writes, keeping cached copies up to date.
+    if (sa->count > data->cacheWays)
+    {
+        const enum STORAGE_Result Result = data->device.write (
+                                                data->device.handler,
+                                                sa->buf, sa->sector,
+                                                sa->count);
+        if (Result != STORAGE_Result_Ok)
+        {
+            return Result;
+        }
+
+        countDirect (data, sa, sa->count);
+
+        for (uint32_t i = 0; i < sa->count; ++i)
+        {
+            struct OS_DRIVER_StorageCacheLine *line = cacheFind (data,
+                                                            sa->sector + i);
+            if (line)
+            {
+                memcpy (cacheLineData (data, line),
+                        &sa->buf[i * STORAGE_SectorSize], STORAGE_SectorSize);
+                line->flags &= ~OS_DRIVER_StorageCacheLine_Dirty;
+            }
+        }
+
+        sa->processed = sa->count;
+        return STORAGE_Result_Ok;
+    }
+
+    // Write-back: sectors stay dirty in the cache until evicted or synced.
+    while (sa->processed < sa->count)
+    {
+        const uint32_t Sector = sa->sector + sa->processed;
+
+        struct OS_DRIVER_StorageCacheLine *line = cacheFind (data, Sector);
+        if (!line && !(line = cacheAlloc (data, Sector)))
+        {
+            return STORAGE_Result_ReadWriteError;
+        }
+
+        memcpy (cacheLineData (data, line),
+                &sa->buf[sa->processed * STORAGE_SectorSize],
+                STORAGE_SectorSize);
+
+        line->flags |= OS_DRIVER_StorageCacheLine_Dirty;
+        ++ data->sectorsCopied;
+        ++ sa->processed;
+    }
+
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result jobSync (struct OS_DRIVER_StorageData *data)
+{
+    const uint32_t CacheLines = data->cacheSets * data->cacheWays;
+
+    for (uint32_t i = 0; i < CacheLines; ++i)
+    {
+        const enum STORAGE_Result Result = cacheWriteBack (data,
+                                                    &data->cacheLines[i]);
+        if (Result != STORAGE_Result_Ok)
+        {
+            return Result;
+        }
+    }
+
+    if (!data->device.ioctl)
+    {
+        return STORAGE_Result_Ok;
+    }
+
+    return data->device.ioctl (data->device.handler, CTRL_SYNC, NULL);
+}
+
+
+// Called from the driver task with a job taken by OS_DRIVER_StorageJobTake().
+enum STORAGE_Result OS_DRIVER_StorageJobRun (struct OS_TaskControl *task,
+                                        struct OS_TaskDriverStorageAccess *sa)
+{
+    if (!task || !sa)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    struct OS_DRIVER_StorageData *data = getStorageData (task);
+
+    if (!data->device.read || !data->device.write)
+    {
+        return STORAGE_Result_NotReady;
+    }
+
+    switch (sa->op)
+    {
+        case OS_TaskDriverOp_Read:
+            return jobRead (data, sa);
+
+        case OS_TaskDriverOp_Write:
+            return jobWrite (data, sa);
+
+        case OS_TaskDriverOp_Sync:
+            return jobSync (data);
+
+        default:
+            break;
+    }
+
+    return STORAGE_Result_InvalidParameter;
+}
+
+
+// Runs a job merged with any queued jobs contiguous to it as a single device
+// command. Goes through the merge buffer unless job buffers also follow each
+// other in memory (ie. a large request split by the caller).
+static void jobRunMerged (struct OS_TaskControl *task,
+                          struct OS_TaskDriverStorageAccess *first)
+{
+    struct OS_DRIVER_StorageData        *data = getStorageData (task);
+    struct OS_TaskDriverStorageAccess   *jobs[OS_DRIVER_StorageMergeMaxJobs];
+    struct OS_TaskDriverStorageAccess   *next;
+    uint32_t                            merged  = 0;
+    uint32_t                            count   = first->count;
+
+    jobs[merged ++] = first;
+
+    if (first->op != OS_TaskDriverOp_Sync && count < data->mergeSectors)
+    {
+        while (merged < OS_DRIVER_StorageMergeMaxJobs
+                && OS_DRIVER_StorageJobTakeNext (task, first->op,
+                                                 first->sector + count,
+                                                 data->mergeSectors - count,
+                                                 &next) == OS_Result_OK)
+        {
+            jobs[merged ++] = next;
+            count += next->count;
+        }
+    }
+
+    if (merged == 1)
+    {
+        OS_DRIVER_StorageJobDone (task, first,
+                                  OS_DRIVER_StorageJobRun (task, first));
+        return;
+    }
+
+    bool contiguous = true;
+    for (uint32_t i = 1; i < merged && contiguous; ++i)
+    {
+        contiguous = (jobs[i]->buf == jobs[i - 1]->buf
+                                + jobs[i - 1]->count * STORAGE_SectorSize);
+    }
+
+    struct OS_TaskDriverStorageAccess batch;
+    memset (&batch, 0, sizeof(batch));
+
+    batch.op        = first->op;
+    batch.buf       = contiguous? first->buf : data->mergeBuffer;
+    batch.sector    = first->sector;
+    batch.count     = count;
+
+    if (!contiguous)
+    {
+        data->sectorsCopied += count;
+    }
+
+    uint8_t *buf = data->mergeBuffer;
+    if (!contiguous && batch.op == OS_TaskDriverOp_Write)
+    {
+        for (uint32_t i = 0; i < merged; ++i)
+        {
+            memcpy (buf, jobs[i]->buf, jobs[i]->count * STORAGE_SectorSize);
+            buf += jobs[i]->count * STORAGE_SectorSize;
+        }
+    }
+
+    const enum STORAGE_Result Result = OS_DRIVER_StorageJobRun (task, &batch);
+
+    buf = data->mergeBuffer;
+    for (uint32_t i = 0; i < merged; ++i)
+    {
+        if (Result == STORAGE_Result_Ok)
+        {
+            if (!contiguous && batch.op == OS_TaskDriverOp_Read)
+            {
+                memcpy (jobs[i]->buf, buf, jobs[i]->count * STORAGE_SectorSize);
+            }
+            jobs[i]->processed = jobs[i]->count;
+        }
+
+        buf += jobs[i]->count * STORAGE_SectorSize;
+        OS_DRIVER_StorageJobDone (task, jobs[i], Result);
+    }
+}
+
+
+static OS_Ticks serve (struct OS_TaskControl *task)
+{
+    struct OS_TaskDriverStorageAccess *sa;
+
+    while (OS_DRIVER_StorageJobTake (task, &sa) == OS_Result_OK)
+    {
+        jobRunMerged (task, sa);
+    }
+
+    return OS_WaitForever;
+}
+
+
+OS_TaskRetVal OS_DRIVER_StorageTask (OS_TaskParam arg)
+{
+    (void) arg;
+
+    OS_DRIVER_TaskLoop (OS_TaskSelf (), serve);
+    return 0;
+}
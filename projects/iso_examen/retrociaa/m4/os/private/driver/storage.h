@@ -10,13 +10,57 @@
 struct OS_DRIVER_StorageInitParams
 {
     uint32_t                            jobs;
+    struct STORAGE_Device               device;
+    // Sector cache: cacheSets (2^n) * cacheWays sectors. Zero sets disables
+    // the cache.
+    uint32_t                            cacheSets;
+    uint32_t                            cacheWays;
+    // Sectors prefetched when sequential reads are detected. Zero disables
+    // read-ahead.
+    uint32_t                            readAhead;
+    // Maximum sectors per merged (multiple block) command. Zero disables
+    // request merging.
+    uint32_t                            mergeSectors;
+};
+
+
+// Maximum number of jobs served by a single merged command.
+#define OS_DRIVER_StorageMergeMaxJobs       8
+// Oldest queued jobs considered when choosing or merging the next one. The
+// dependency check between them runs with SVCall masked and is quadratic, so
+// this bounds it to 8 * 7 / 2 job comparisons whatever the queue length.
+// Newer jobs wait until earlier ones leave the window.
+#define OS_DRIVER_StorageScheduleWindow     8
+
+#define OS_DRIVER_StorageCacheLine_Valid    0x01
+#define OS_DRIVER_StorageCacheLine_Dirty    0x02
+
+
+struct OS_DRIVER_StorageCacheLine
+{
+    uint32_t                            sector;
+    uint32_t                            lastUse;
+    uint32_t                            flags;
+};
+
+
+enum OS_DRIVER_StorageJobState
+{
+    OS_DRIVER_StorageJobState_Free = 0,
+    OS_DRIVER_StorageJobState_Queued,
+    OS_DRIVER_StorageJobState_Pending,
+    OS_DRIVER_StorageJobState_Done
 };
 
 
 struct OS_DRIVER_StorageJob
 {
     struct QUEUE_Node                   node;
-    struct OS_TaskDriverStorageAccess   *access;
+    struct OS_TaskDriverStorageAccess   access;
+    struct OS_TaskControl               *owner;
+    OS_Ticks                            deadline;
+    uint32_t                            sequence;
+    enum OS_DRIVER_StorageJobState      state;
 }
 ATTR_DataAlign4;
 
@@ -24,13 +68,37 @@ ATTR_DataAlign4;
 struct OS_DRIVER_StorageData
 {
     struct QUEUE                        queue;
+    struct QUEUE                        free;
     uint32_t                            maxJobs;
-    struct OS_DRIVER_StorageJob         *nextFreeJob;
+    uint32_t                            sequence;
     struct OS_TaskDriverStorageAccess   *pending;
+    struct STORAGE_Device               device;
+    struct OS_DRIVER_StorageCacheLine   *cacheLines;
+    uint8_t                             *cacheData;
+    uint8_t                             *readAheadBuffer;
+    uint8_t                             *mergeBuffer;
+    uint32_t                            cacheSets;
+    uint32_t                            cacheWays;
+    uint32_t                            cacheUses;
+    uint32_t                            readAhead;
+    uint32_t                            nextSequential;
+    uint32_t                            mergeSectors;
+    // Elevator (C-SCAN) position: sector following the last job taken.
+    uint32_t                            headSector;
     uint32_t                            jobsSucceeded;
     uint32_t                            jobsFailed;
     uint32_t                            sectorsRead;
     uint32_t                            sectorsWritten;
+    uint32_t                            cacheHits;
+    uint32_t                            cacheMisses;
+    uint32_t                            cacheWriteBacks;
+    uint32_t                            sectorsReadAhead;
+    uint32_t                            jobsMerged;
+    uint32_t                            jobsExpired;
+    // Sectors moved by the device straight from/to the caller buffer and
+    // sectors copied through the cache or the merge buffer.
+    uint32_t                            sectorsDirect;
+    uint32_t                            sectorsCopied;
 }
 ATTR_DataAlign4;
 
@@ -41,11 +109,30 @@ enum OS_Result  OS_DRIVER_StorageInit       (struct OS_TaskControl *task,
                                              struct OS_DRIVER_StorageInitParams
                                              *initParams);
 enum OS_Result  OS_DRIVER_StorageJobAdd     (struct OS_TaskControl *task,
+                                             struct OS_TaskControl *owner,
                                              struct OS_TaskDriverStorageAccess
-                                             *sa);
+                                             *sa,
+                                             struct OS_StorageHandle *handle);
+enum OS_Result  OS_DRIVER_StorageJobResult  (struct OS_StorageHandle *handle,
+                                             enum STORAGE_Result *result);
 enum OS_Result  OS_DRIVER_StorageJobTake    (struct OS_TaskControl *task,
                                              struct OS_TaskDriverStorageAccess
                                              **sa);
+enum OS_Result  OS_DRIVER_StorageJobTakeNext
+                                            (struct OS_TaskControl *task,
+                                             enum OS_TaskDriverOp op,
+                                             uint32_t sector,
+                                             uint32_t maxCount,
+                                             struct OS_TaskDriverStorageAccess
+                                             **sa);
 enum OS_Result  OS_DRIVER_StorageJobDone    (struct OS_TaskControl *task,
                                              struct OS_TaskDriverStorageAccess
-                                             *sa, enum OS_Result result);
+                                             *sa,
+                                             enum STORAGE_Result result);
+enum STORAGE_Result
+                OS_DRIVER_StorageJobRun     (struct OS_TaskControl *task,
+                                             struct OS_TaskDriverStorageAccess
+                                             *sa);
+// Storage driver task function: runs queued jobs on the device given in
+// OS_DRIVER_StorageInitParams, sleeping while there are none.
+OS_TaskRetVal   OS_DRIVER_StorageTask       (OS_TaskParam arg);
@@ -37,9 +37,12 @@
 #include <string.h>
 
 
-struct OS           *g_OS                       = NULL;
-volatile uint32_t   g_OS_SchedulerCallPending   = 0;
-volatile uint32_t   g_OS_SchedulerTickBarrier   = 0;
-volatile uint32_t   g_OS_SchedulerTicksMissed   = 0;
+// Read or written on every context switch.
+struct OS           *g_OS                       ATTR_FastData = NULL;
+volatile uint32_t   g_OS_SchedulerCallPending   ATTR_FastData = 0;
+volatile uint32_t   g_OS_SchedulerTickBarrier   ATTR_FastData = 0;
+volatile uint32_t   g_OS_SchedulerTicksMissed   ATTR_FastData = 0;
+volatile uint32_t   g_OS_SchedulerCycles        ATTR_FastData = 0;
+volatile uint32_t   g_OS_SchedulerCyclesMax     ATTR_FastData = 0;
 const char          *TaskBootDescription        = "BOOT";
 const char          *TaskIdleDescription        = "IDLE";
@@ -63,6 +63,11 @@ extern struct OS            *g_OS;
 extern volatile uint32_t    g_OS_SchedulerCallPending;
 extern volatile uint32_t    g_OS_SchedulerTickBarrier;
 extern volatile uint32_t    g_OS_SchedulerTicksMissed;
+// Cycles from PendSV entry to the end of the last scheduler run, and the
+// highest such count. Switch latency as seen by a task, save and restore of
+// its context aside.
+extern volatile uint32_t    g_OS_SchedulerCycles;
+extern volatile uint32_t    g_OS_SchedulerCyclesMax;
 extern const char           *TaskBootDescription;
 extern const char           *TaskIdleDescription;
 
@@ -91,6 +96,10 @@ struct OS_TaskControl
     void                    *sigWaitObject;
     enum OS_Result          sigWaitResult;
     struct SEMAPHORE        sleep;
+    // Released by drivers when a job of this task completes, see
+    // OS_StorageWaitAny(). Apart from sleep so OS_TaskSleep()/OS_TaskWakeup()
+    // and job completions never consume each other's release.
+    struct SEMAPHORE        complete;
     enum OS_TaskType        type;
     enum OS_TaskPriority    priority;
     enum OS_TaskState       state;
@@ -37,6 +37,7 @@
 #include "opaque.h"
 #include "runtime.h"
 #include "driver/storage.h"
+#include "driver/com.h"
 #include "../scheduler.h"
 #include "../mutex.h"
 #include "../../base/queue.h"
@@ -131,6 +132,9 @@ static enum OS_Result taskDriverInit (struct OS_TaskControl *task,
         case OS_TaskType_DriverStorage:
             return OS_DRIVER_StorageInit (task, ts->initParams);
 
+        case OS_TaskType_DriverUART:
+            return OS_DRIVER_ComInit (task, ts->initParams);
+
         default:
             break;
     }
@@ -178,6 +182,7 @@ static enum OS_Result taskStart (struct OS_TaskStart *ts)
     task->stackBarrier  = OS_StackBarrierValue;
 
     SEMAPHORE_Init          (&task->sleep, 1, 1);
+    SEMAPHORE_Init          (&task->complete, 1, 1);
     OS_USAGE_CpuReset       (&task->usageCpu);
     OS_USAGE_MemoryReset    (&task->usageMemory);
 
@@ -376,8 +381,8 @@ struct OS_TaskControl * taskFind (enum OS_TaskPriority priority,
     struct QUEUE            *queue;
 
     queue = &g_OS->tasksWaiting[priority];
-    for (task = (struct OS_TaskControl *) queue->head; task;
-         task = (struct OS_TaskControl *) queue->head->next)
+    for (task = (struct OS_TaskControl *) QUEUE_Head (queue); task;
+         task = (struct OS_TaskControl *) QUEUE_Next (queue, &task->node))
     {
         if (task->description == description)
         {
@@ -386,8 +391,8 @@ struct OS_TaskControl * taskFind (enum OS_TaskPriority priority,
     }
 
     queue = &g_OS->tasksReady[priority];
-    for (task = (struct OS_TaskControl *) queue->head; task;
-         task = (struct OS_TaskControl *) queue->head->next)
+    for (task = (struct OS_TaskControl *) QUEUE_Head (queue); task;
+         task = (struct OS_TaskControl *) QUEUE_Next (queue, &task->node))
     {
         if (task->description == description)
         {
@@ -468,58 +473,113 @@ enum OS_Result taskWakeup (struct OS_TaskControl *task)
 }
 
 
-enum OS_Result taskDriverStorageAccess (struct OS_TaskDriverStorageAccess *sa)
+enum OS_Result taskDriverStorageSubmit (struct OS_TaskDriverStorageSubmit *ss)
 {
     if (!g_OS->currentTask)
     {
         return OS_Result_NoCurrentTask;
     }
 
-    if (!sa)
+    if (!ss)
     {
         return OS_Result_InvalidParams;
     }
 
-    if (!sa->description || !sa->buf || !sa->count)
+    struct OS_TaskDriverStorageAccess *sa = &ss->access;
+
+    if (!sa->description || sa->op >= OS_TaskDriverOP__COUNT
+            || sa->priority >= OS_StoragePriority__COUNT
+            || (sa->op != OS_TaskDriverOp_Sync && (!sa->buf || !sa->count)))
     {
         return OS_Result_InvalidParams;
     }
 
     struct OS_TaskControl *task = taskFind (OS_TaskPriority_DriverStorage,
                                             sa->description);
-    if (!task)
+    if (!task || task->type != OS_TaskType_DriverStorage)
     {
         // Requested driver does not exist.
         return OS_Result_NotInitialized;
     }
 
-    sa->result  = OS_Result_NotInitialized;
-    sa->sem     = &g_OS->currentTask->sleep;
-
     enum OS_Result r;
 
-    // Put the caller to sleep on the next scheduler execution.
-    // The caller will be waken up by the storage driver when the job is
-    // finished -or- the operation timeout has been reached.
-    if ((r = taskSleep(g_OS->currentTask)) != OS_Result_OK)
+    // Add a copy of the new job to the driver. The caller keeps running; its
+    // complete semaphore will be released by the driver when the job is done.
+    if ((r = OS_DRIVER_StorageJobAdd(task, g_OS->currentTask, sa,
+                                     &ss->handle)) != OS_Result_OK)
     {
         return r;
     }
 
-    // Add the new job to the driver.
-    if ((r = OS_DRIVER_StorageJobAdd(task, sa)) != OS_Result_OK)
+    // If not already awake, wake up the driver to start a new job.
+    return taskWakeup (task);
+}
+
+
+enum OS_Result taskDriverStoragePoll (struct OS_TaskDriverStoragePoll *sp)
+{
+    if (!sp)
     {
-        return r;
+        return OS_Result_InvalidParams;
     }
 
-    // If not already awake, wake up the driver to start a new job.
-    if ((r = taskWakeup(task)) != OS_Result_OK)
+    return OS_DRIVER_StorageJobResult (&sp->handle, &sp->result);
+}
+
+
+enum OS_Result taskDriverComSubmit (struct OS_TaskDriverComSubmit *cs)
+{
+    if (!g_OS->currentTask)
+    {
+        return OS_Result_NoCurrentTask;
+    }
+
+    if (!cs)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskDriverComAccess *ca = &cs->access;
+
+    if (!ca->description || !ca->buf || !ca->count
+            || (ca->op != OS_TaskDriverOp_Send
+                && ca->op != OS_TaskDriverOp_Recv)
+            || ca->mode >= OS_ComRecvMode__COUNT)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    struct OS_TaskControl *task = taskFind (OS_TaskPriority_DriverComUART,
+                                            ca->description);
+    if (!task || task->type != OS_TaskType_DriverUART)
+    {
+        // Requested driver does not exist.
+        return OS_Result_NotInitialized;
+    }
+
+    enum OS_Result r;
+
+    // Same as storage jobs: the caller keeps running and gets its complete
+    // semaphore released by the driver when the job is done.
+    if ((r = OS_DRIVER_ComJobAdd (task, g_OS->currentTask, ca,
+                                  &cs->handle)) != OS_Result_OK)
     {
         return r;
     }
 
-    // Waiting for the new job to be picked up by the driver and be done.
-    return OS_Result_Waiting;
+    return taskWakeup (task);
+}
+
+
+enum OS_Result taskDriverComPoll (struct OS_TaskDriverComPoll *cp)
+{
+    if (!cp)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    return OS_DRIVER_ComJobResult (&cp->handle, &cp->processed, &cp->result);
 }
 
 
@@ -643,9 +703,20 @@ enum OS_Result OS_SyscallHandler (enum OS_Syscall call, void *params)
         case OS_Syscall_TaskPeriodicDelay:
             return taskPeriodicDelay ((OS_Ticks *) params);
 
-        case OS_Syscall_TaskDriverStorageAccess:
-            return taskDriverStorageAccess (
-                                (struct OS_TaskDriverStorageAccess *) params);
+        case OS_Syscall_TaskDriverStorageSubmit:
+            return taskDriverStorageSubmit (
+                                (struct OS_TaskDriverStorageSubmit *) params);
+
+        case OS_Syscall_TaskDriverStoragePoll:
+            return taskDriverStoragePoll (
+                                (struct OS_TaskDriverStoragePoll *) params);
+
+        case OS_Syscall_TaskDriverComSubmit:
+            return taskDriverComSubmit (
+                                (struct OS_TaskDriverComSubmit *) params);
+
+        case OS_Syscall_TaskDriverComPoll:
+            return taskDriverComPoll ((struct OS_TaskDriverComPoll *) params);
 
         case OS_Syscall_TaskTerminate:
             return taskTerminate ((struct OS_TaskTerminate *) params);
@@ -49,7 +49,10 @@ enum OS_Syscall
     OS_Syscall_TaskWaitForSignal,
     OS_Syscall_TaskDelayFrom,
     OS_Syscall_TaskPeriodicDelay,
-    OS_Syscall_TaskDriverStorageAccess,
+    OS_Syscall_TaskDriverStorageSubmit,
+    OS_Syscall_TaskDriverStoragePoll,
+    OS_Syscall_TaskDriverComSubmit,
+    OS_Syscall_TaskDriverComPoll,
     OS_Syscall_TaskTerminate,
     OS_Syscall_Terminate
 };
@@ -86,16 +89,7 @@ struct OS_TaskDelayFrom
 };
 
 
-enum OS_TaskDriverOp
-{
-    OS_TaskDriverOp_Read,
-    OS_TaskDriverOp_Write,
-    OS_TaskDriverOP__COUNT,
-    OS_TaskDriverOp_Recv    = OS_TaskDriverOp_Read,
-    OS_TaskDriverOp_Send    = OS_TaskDriverOp_Write
-};
-
-
+// Deep copied to the driver job ring on submission.
 struct OS_TaskDriverStorageAccess
 {
     const char              *description;
@@ -104,25 +98,59 @@ struct OS_TaskDriverStorageAccess
     uint32_t                sector;
     uint32_t                count;
     uint32_t                processed;
+    enum OS_StoragePriority priority;
+    // Deadline relative to submission
     OS_Ticks                timeout;
-    struct SEMAPHORE        *sem;
+    OS_StorageCallback      callback;
+    void                    *callbackParam;
     enum STORAGE_Result     result;
 };
 
 
+struct OS_TaskDriverStorageSubmit
+{
+    struct OS_TaskDriverStorageAccess   access;
+    struct OS_StorageHandle             handle;
+};
+
+
+struct OS_TaskDriverStoragePoll
+{
+    struct OS_StorageHandle             handle;
+    enum STORAGE_Result                 result;
+};
+
+
+// Deep copied to the driver job ring on submission.
 struct OS_TaskDriverComAccess
 {
     const char              *description;
     enum OS_TaskDriverOp    op;
+    enum OS_ComRecvMode     mode;
     uint8_t                 *buf;
     uint32_t                count;
     uint32_t                processed;
+    // Deadline relative to submission
     OS_Ticks                timeout;
-    struct SEMAPHORE        *sem;
     enum OS_Result          result;
 };
 
 
+struct OS_TaskDriverComSubmit
+{
+    struct OS_TaskDriverComAccess       access;
+    struct OS_ComHandle                 handle;
+};
+
+
+struct OS_TaskDriverComPoll
+{
+    struct OS_ComHandle                 handle;
+    uint32_t                            processed;
+    enum OS_Result                      result;
+};
+
+
 struct OS_TaskTerminate
 {
     struct OS_TaskControl   *task;
@@ -41,6 +41,7 @@
 #include <string.h>
 
 
+ATTR_RamFunc
 inline static void updateCurrentCpu (struct OS_USAGE_Cpu *uc,
                                      const OS_Cycles Cycles)
 {
@@ -49,6 +50,7 @@ inline static void updateCurrentCpu (struct OS_USAGE_Cpu *uc,
 }
 
 
+ATTR_RamFunc
 inline static void updateCurrentMemory (struct OS_USAGE_Memory *um,
                                         const int32_t CurMem)
 {
@@ -68,6 +70,7 @@ inline static void updateCurrentMemory (struct OS_USAGE_Memory *um,
 }
 
 
+ATTR_RamFunc
 inline static void updateLastCpu (struct OS_USAGE *u, struct OS_USAGE_Cpu *cu)
 {
     cu->lastUsage       = cu->curCycles * u->cyclesPerTargetTicks;
@@ -78,6 +81,7 @@ inline static void updateLastCpu (struct OS_USAGE *u, struct OS_USAGE_Cpu *cu)
 }
 
 
+ATTR_RamFunc
 inline static void updateLastMemory (struct OS_USAGE *u,
                                      struct OS_USAGE_Memory *um,
                                      const int32_t CurMem,
@@ -149,6 +153,7 @@ enum OS_Result OS_USAGE_Init (struct OS_USAGE *u)
 }
 
 
+ATTR_RamFunc
 bool OS_USAGE_UpdatingLastMeasures (struct OS_USAGE *u)
 {
     if (!u)
@@ -162,6 +167,7 @@ bool OS_USAGE_UpdatingLastMeasures (struct OS_USAGE *u)
 
 // Returns memory used by a task, including static amount reserved for its
 // control structure.
+ATTR_RamFunc
 int32_t OS_USAGE_GetUsedTaskMemory (void *taskBuffer)
 {
     if (!taskBuffer)
@@ -193,6 +199,7 @@ enum OS_Result OS_USAGE_SetTargetTicks (struct OS_USAGE *u, OS_Ticks ticks)
 }
 
 
+ATTR_RamFunc
 enum OS_Result OS_USAGE_UpdateTarget (struct OS_USAGE *u, const OS_Ticks Now)
 {
     if (!u)
@@ -233,6 +240,7 @@ enum OS_Result OS_USAGE_UpdateTarget (struct OS_USAGE *u, const OS_Ticks Now)
 
 // This should only be used with the running task (the one running when the
 // scheduler took over)
+ATTR_RamFunc
 enum OS_Result OS_USAGE_UpdateCurrentMeasures (struct OS_USAGE *u,
                                                struct OS_USAGE_Cpu *uc,
                                                struct OS_USAGE_Memory *um,
@@ -257,6 +265,7 @@ enum OS_Result OS_USAGE_UpdateCurrentMeasures (struct OS_USAGE *u,
 }
 
 
+ATTR_RamFunc
 enum OS_Result OS_USAGE_UpdateLastMeasures (struct OS_USAGE *u,
                                             struct OS_USAGE_Cpu *uc,
                                             struct OS_USAGE_Memory *um,
@@ -41,6 +41,7 @@
 #include "chip.h"       // CMSYS
 
 
+ATTR_RamFunc
 inline static void taskSigWaitEnd (struct OS_TaskControl *tc,
                                    enum OS_Result result)
 {
@@ -50,6 +51,7 @@ inline static void taskSigWaitEnd (struct OS_TaskControl *tc,
 }
 
 
+ATTR_RamFunc
 static void taskUpdateState (struct OS_TaskControl *tc, const OS_Ticks Now)
 {
     // Not waiting for anything
@@ -114,15 +116,21 @@ static void taskUpdateState (struct OS_TaskControl *tc, const OS_Ticks Now)
 }
 
 
+ATTR_RamFunc
 inline static void schedulerUpdateWaitingTasks (const OS_Ticks Now)
 {
     for (int i = OS_TaskPriority__BEGIN; i < OS_TaskPriority__COUNT; ++i)
     {
-        struct OS_TaskControl *task;
+        struct QUEUE            *queue = &g_OS->tasksWaiting[i];
+        struct OS_TaskControl   *task;
+        struct OS_TaskControl   *next;
 
-        for (task = (struct OS_TaskControl *) g_OS->tasksWaiting[i].head; task;
-             task = (struct OS_TaskControl *) task->node.next)
+        // Next node is taken before the current one gets detached.
+        for (task = (struct OS_TaskControl *) QUEUE_Head (queue); task;
+             task = next)
         {
+            next = (struct OS_TaskControl *) QUEUE_Next (queue, &task->node);
+
             DEBUG_Assert (task->stackBarrier == OS_StackBarrierValue);
 
             taskUpdateState (task, Now);
@@ -131,8 +139,7 @@ inline static void schedulerUpdateWaitingTasks (const OS_Ticks Now)
             {
                 // Timeout reached. This now ready task will be moved to its
                 // corresponding task list.
-                QUEUE_DetachNode (&g_OS->tasksWaiting[i],
-                                                (struct QUEUE_Node *) task);
+                QUEUE_DetachNode (queue, (struct QUEUE_Node *) task);
                 QUEUE_PushNode   (&g_OS->tasksReady[i],
                                                 (struct QUEUE_Node *) task);
             }
@@ -143,6 +150,7 @@ inline static void schedulerUpdateWaitingTasks (const OS_Ticks Now)
 }
 
 
+ATTR_RamFunc
 inline static void schedulerUpdateLastTaskMeasures ()
 {
     // First iteration of a new performance measurement period?
@@ -166,8 +174,9 @@ inline static void schedulerUpdateLastTaskMeasures ()
 
     for (int i = OS_TaskPriority__BEGIN; i < OS_TaskPriority__COUNT; ++i)
     {
-        for (task = (struct OS_TaskControl *) g_OS->tasksWaiting[i].head; task;
-             task = (struct OS_TaskControl *) task->node.next)
+        struct QUEUE *queue = &g_OS->tasksWaiting[i];
+        for (task = (struct OS_TaskControl *) QUEUE_Head (queue); task;
+             task = (struct OS_TaskControl *) QUEUE_Next (queue, &task->node))
         {
             const int32_t TaskMemory = OS_USAGE_GetUsedTaskMemory (task);
             OS_USAGE_UpdateLastMeasures (&g_OS->usage, &task->usageCpu,
@@ -175,8 +184,9 @@ inline static void schedulerUpdateLastTaskMeasures ()
                                             task->size);
         }
 
-        for (task = (struct OS_TaskControl *) g_OS->tasksReady[i].head; task;
-             task = (struct OS_TaskControl *) task->node.next)
+        queue = &g_OS->tasksReady[i];
+        for (task = (struct OS_TaskControl *) QUEUE_Head (queue); task;
+             task = (struct OS_TaskControl *) QUEUE_Next (queue, &task->node))
         {
             const int32_t TaskMemory = OS_USAGE_GetUsedTaskMemory (task);
             OS_USAGE_UpdateLastMeasures (&g_OS->usage, &task->usageCpu,
@@ -187,6 +197,7 @@ inline static void schedulerUpdateLastTaskMeasures ()
 }
 
 
+ATTR_RamFunc
 inline static void schedulerUpdateOwnMeasures ()
 {
     // -Approximate- number of cycles used for task scheduling. It depends on
@@ -194,8 +205,16 @@ inline static void schedulerUpdateOwnMeasures ()
     // 2) Code not taken into account after measurements took place
     //    (ie DWT->CYCCNT).
     // (*) Note that tasks can be preempted too.
+    const uint32_t Cycles = DWT->CYCCNT;
+
     OS_USAGE_UpdateCurrentMeasures (&g_OS->usage, &g_OS->usageCpu, NULL,
-                                   DWT->CYCCNT, 0);
+                                   Cycles, 0);
+
+    g_OS_SchedulerCycles = Cycles;
+    if (Cycles > g_OS_SchedulerCyclesMax)
+    {
+        g_OS_SchedulerCyclesMax = Cycles;
+    }
 
     if (OS_USAGE_UpdatingLastMeasures (&g_OS->usage))
     {
@@ -204,6 +223,7 @@ inline static void schedulerUpdateOwnMeasures ()
 }
 
 
+ATTR_RamFunc
 inline static void schedulerLastTaskUpdate (const uint32_t CurrentSp,
                                             const uint32_t TaskCycles,
                                             const uint32_t Now)
@@ -258,6 +278,7 @@ inline static void schedulerLastTaskUpdate (const uint32_t CurrentSp,
 }
 
 
+ATTR_RamFunc
 inline static void schedulerFindNextTask ()
 {
     // There must be no task selected at this point
@@ -267,17 +288,17 @@ inline static void schedulerFindNextTask ()
     // tasks with the same priority.
     for (int i = OS_TaskPriority__BEGIN; i < OS_TaskPriority__COUNT; ++i)
     {
-        struct QUEUE *queue = &g_OS->tasksReady[i];
-        if (queue->head)
+        struct QUEUE_Node *node = QUEUE_PopNode (&g_OS->tasksReady[i]);
+        if (node)
         {
-            g_OS->currentTask = (struct OS_TaskControl *) queue->head;
-            QUEUE_DetachNode (queue, queue->head);
+            g_OS->currentTask = (struct OS_TaskControl *) node;
             break;
         }
     }
 }
 
 
+ATTR_RamFunc
 inline static void schedulerSetCurrentTaskReadyToRun (const uint32_t Now)
 {
     // At least one task must have been selected.
@@ -315,6 +336,7 @@ inline static void schedulerSetCurrentTaskReadyToRun (const uint32_t Now)
 }
 
 
+ATTR_RamFunc
 uint32_t OS_Scheduler (const uint32_t CurrentSp, const uint32_t TaskCycles)
 {
     DEBUG_Assert (g_OS);
@@ -0,0 +1,53 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host build stand-in for the LPCOpen chip.h.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+// os/api.h includes chip.h for CMSIS. Storage code built on the host needs
+// nothing from it, so host builds put this directory on the include path
+// (-I.) to satisfy the include.
+
+#include <stdint.h>
+
+
+// IAP calls made by KVSTORE, implemented by kvtest.c.
+#define IAP_CMD_SUCCESS     0
+
+uint8_t Chip_IAP_Init                   (void);
+uint8_t Chip_IAP_PreSectorForReadWrite  (uint32_t strSector,
+                                         uint32_t endSector, uint8_t bankNum);
+uint8_t Chip_IAP_CopyRamToFlash         (uint32_t dstAdd, uint32_t *srcAdd,
+                                         uint32_t byteswrt);
+uint8_t Chip_IAP_EraseSector            (uint32_t strSector,
+                                         uint32_t endSector, uint8_t bankNum);
@@ -0,0 +1,148 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host FatFs disk interface over a STORAGE_Device.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "simdisk.h"
+#include "diskio.h"     // FatFs
+#include <time.h>
+
+
+static struct STORAGE_Device *g_Device;
+
+
+static DRESULT result (enum STORAGE_Result r)
+{
+    return (r <= STORAGE_Result_InvalidParameter)? (DRESULT) r : RES_ERROR;
+}
+
+
+void STORAGE_SIMDISK_Attach (struct STORAGE_Device *device)
+{
+    g_Device = device;
+}
+
+
+DSTATUS disk_status (BYTE drv)
+{
+    if (drv || !g_Device)
+    {
+        return STA_NOINIT | STA_NODISK;
+    }
+
+    uint8_t power[2] = { CTRL_POWER_STATUS, 0 };
+    if (g_Device->ioctl (g_Device->handler, CTRL_POWER, power)
+                                                    != STORAGE_Result_Ok)
+    {
+        return STA_NOINIT;
+    }
+
+    return power[1]? 0 : STA_NOINIT;
+}
+
+
+DSTATUS disk_initialize (BYTE drv)
+{
+    if (drv || !g_Device)
+    {
+        return STA_NOINIT | STA_NODISK;
+    }
+
+    uint8_t power[1] = { CTRL_POWER_ON };
+    g_Device->ioctl (g_Device->handler, CTRL_POWER, power);
+
+    return disk_status (drv);
+}
+
+
+DRESULT disk_read (BYTE drv, BYTE *buff, DWORD sector, BYTE count)
+{
+    if (drv || !g_Device || !count)
+    {
+        return RES_PARERR;
+    }
+
+    return result (g_Device->read (g_Device->handler, buff,
+                                   (uint32_t) sector, count));
+}
+
+
+DRESULT disk_write (BYTE drv, const BYTE *buff, DWORD sector, BYTE count)
+{
+    if (drv || !g_Device || !count)
+    {
+        return RES_PARERR;
+    }
+
+    return result (g_Device->write (g_Device->handler, buff,
+                                    (uint32_t) sector, count));
+}
+
+
+DRESULT disk_ioctl (BYTE drv, BYTE ctrl, void *buff)
+{
+    if (drv || !g_Device)
+    {
+        return RES_PARERR;
+    }
+
+    // DWORD is wider than the uint32_t the device stores on 64 bit hosts.
+    if (buff && (ctrl == GET_SECTOR_COUNT || ctrl == GET_BLOCK_SIZE))
+    {
+        uint32_t value = 0;
+        const DRESULT R = result (g_Device->ioctl (g_Device->handler, ctrl,
+                                                   &value));
+        if (R == RES_OK)
+        {
+            *(DWORD *) buff = value;
+        }
+        return R;
+    }
+
+    return result (g_Device->ioctl (g_Device->handler, ctrl, buff));
+}
+
+
+// Local time packed as FatFs expects it, the target gets it from the RTC.
+DWORD get_fattime (void)
+{
+    const time_t Now = time (NULL);
+    const struct tm *const T = localtime (&Now);
+
+    return ((DWORD) (T->tm_year - 80) << 25)
+            | ((DWORD) (T->tm_mon + 1) << 21)
+            | ((DWORD) T->tm_mday << 16)
+            | ((DWORD) T->tm_hour << 11)
+            | ((DWORD) T->tm_min << 5)
+            | ((DWORD) T->tm_sec >> 1);
+}
@@ -0,0 +1,348 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host FatFs throughput bench over the storage simulator.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Formats a STORAGE_SIMFILE image as FAT16 and times f_write and f_read of a
+// test file through FatFs (ff.c of the lpc4337_m4 module) and diskio.c, for
+// a range of request sizes. Every read is checked against what was written.
+// With _USE_STATS the share of bytes FatFs moved straight between the
+// device and the caller buffer is printed too; the rest went through the
+// one sector buffer of the file.
+//
+// The module ffconf.h leaves f_mkfs out (_USE_MKFS 0), so the volume is laid
+// out here. The driver task cache and I/O scheduler are not in the path:
+// they need the kernel, this is FatFs over the bare device.
+//
+// Build and run on the host:
+//
+//   F=../../../../../../modules/lpc4337_m4/fatfs
+//   S="fatbench.c diskio.c simfile.c $F/src/ff.c"
+//   gcc -O2 -std=gnu99 -D_USE_STATS=1 -I$F/inc -o fatbench $S
+//   ./fatbench [-i image] [-s sectors] [-c clusterSectors] [-n fileKiB]
+//              [-e errorPpm] [-t timeoutPpm] [-r read_us] [-w write_us]
+//              [-p sector_us] [-x seed]
+
+#include "simfile.h"
+#include "simdisk.h"
+#include "ff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define FATBENCH_RootEntries    512
+#define FATBENCH_MinClusters    4086    // FAT16 range, as ff.c tells them
+#define FATBENCH_MaxClusters    65525
+#define FATBENCH_FileName       "BENCH.BIN"
+
+
+// Bytes per f_write/f_read call; the odd ones keep the file offset off
+// sector boundaries.
+static const uint32_t ChunkSizes[] =
+{
+    64, 512, 1000, 4096, 4100, 32768
+};
+
+
+static uint64_t now_us (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+static void put16 (uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+
+static void put32 (uint8_t *p, uint32_t v)
+{
+    put16 (p, v);
+    put16 (p + 2, v >> 16);
+}
+
+
+// Boot sector, two FATs and an empty root directory, directly on the image.
+static bool format (struct STORAGE_SIMFILE *sim, uint32_t clusterSectors)
+{
+    const uint32_t RootSectors  = FATBENCH_RootEntries * 32
+                                    / STORAGE_SectorSize;
+    const uint32_t FatSectors   = ((sim->sectors / clusterSectors + 2) * 2
+                                    + STORAGE_SectorSize - 1)
+                                    / STORAGE_SectorSize;
+    const uint32_t SysSectors   = 1 + 2 * FatSectors + RootSectors;
+
+    if (sim->sectors <= SysSectors)
+    {
+        return false;
+    }
+
+    const uint32_t Clusters = (sim->sectors - SysSectors) / clusterSectors;
+    if (Clusters < FATBENCH_MinClusters || Clusters >= FATBENCH_MaxClusters)
+    {
+        return false;
+    }
+
+    memset (sim->image, 0, (size_t) SysSectors * STORAGE_SectorSize);
+
+    uint8_t *const Bs = sim->image;
+    memcpy (&Bs[0], "\xEB\xFE\x90" "MSDOS5.0", 11);
+    put16 (&Bs[11], STORAGE_SectorSize);        // BPB_BytsPerSec
+    Bs[13] = (uint8_t) clusterSectors;          // BPB_SecPerClus
+    put16 (&Bs[14], 1);                         // BPB_RsvdSecCnt
+    Bs[16] = 2;                                 // BPB_NumFATs
+    put16 (&Bs[17], FATBENCH_RootEntries);      // BPB_RootEntCnt
+    Bs[21] = 0xF8;                              // BPB_Media
+    put16 (&Bs[22], FatSectors);                // BPB_FATSz16
+    put32 (&Bs[32], sim->sectors);              // BPB_TotSec32
+    Bs[38] = 0x29;                              // BS_BootSig
+    memcpy (&Bs[43], "NO NAME    FAT16   ", 19);
+    put16 (&Bs[510], 0xAA55);
+
+    for (uint32_t f = 0; f < 2; ++ f)
+    {
+        uint8_t *const Fat = &sim->image[(1 + f * FatSectors)
+                                            * STORAGE_SectorSize];
+        put16 (&Fat[0], 0xFFF8);
+        put16 (&Fat[2], 0xFFFF);
+    }
+
+    return true;
+}
+
+
+static void fill (uint8_t *buf, uint32_t size, uint32_t offset)
+{
+    for (uint32_t i = 0; i < size; ++ i)
+    {
+        const uint32_t O = offset + i;
+        buf[i] = (uint8_t) (O ^ (O >> 8) ^ (O >> 16));
+    }
+}
+
+
+int main (int argc, char *argv[])
+{
+    const char *path        = "fatbench.img";
+    uint32_t sectors        = 65536;
+    uint32_t clusterSectors = 8;
+    uint32_t fileKiB        = 4096;
+
+    struct STORAGE_SIMFILE_Config config =
+    {
+        .timeout_us = 1000,
+        .eraseBlock = 8,
+        .seed       = 1
+    };
+
+    int opt;
+    while ((opt = getopt (argc, argv, "i:s:c:n:e:t:r:w:p:x:")) != -1)
+    {
+        const uint32_t V = (uint32_t) strtoul (optarg? optarg : "0", NULL, 0);
+        switch (opt)
+        {
+            case 'i': path                      = optarg; break;
+            case 's': sectors                   = V; break;
+            case 'c': clusterSectors            = V; break;
+            case 'n': fileKiB                   = V; break;
+            case 'e': config.errorPpm           = V; break;
+            case 't': config.timeoutPpm         = V; break;
+            case 'r': config.readLatency_us     = V; break;
+            case 'w': config.writeLatency_us    = V; break;
+            case 'p': config.sectorLatency_us   = V; break;
+            case 'x': config.seed               = V; break;
+            default:
+                fprintf (stderr, "usage: %s [-i image] [-s sectors] "
+                         "[-c clusterSectors] [-n fileKiB] [-e errorPpm] "
+                         "[-t timeoutPpm] [-r read_us] [-w write_us] "
+                         "[-p sector_us] [-x seed]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!clusterSectors || clusterSectors > 128
+            || (clusterSectors & (clusterSectors - 1)) || !fileKiB
+            || (uint64_t) fileKiB * 2 >= sectors)
+    {
+        fprintf (stderr, "invalid sizes\n");
+        return EXIT_FAILURE;
+    }
+
+    struct STORAGE_SIMFILE  sim;
+    struct STORAGE_Device   device;
+
+    if (!STORAGE_SIMFILE_Init (&sim, path, sectors, &config, &device))
+    {
+        perror (path);
+        return EXIT_FAILURE;
+    }
+
+    if (!format (&sim, clusterSectors))
+    {
+        fprintf (stderr, "%u sectors of %u do not make a FAT16 volume\n",
+                 sectors, clusterSectors);
+        STORAGE_SIMFILE_Close (&sim);
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t FileSize = fileKiB * 1024;
+    const uint32_t MaxChunk = ChunkSizes[sizeof(ChunkSizes)
+                                            / sizeof(ChunkSizes[0]) - 1];
+    uint8_t *buf    = NULL;
+    uint8_t *expect = malloc (MaxChunk);
+
+    if (posix_memalign ((void **) &buf, STORAGE_BufferAlign, MaxChunk))
+    {
+        buf = NULL;
+    }
+
+    if (!buf || !expect)
+    {
+        fprintf (stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    static FATFS fs;
+    static FIL   file;
+
+    STORAGE_SIMDISK_Attach (&device);
+    f_mount (0, &fs);
+
+    uint32_t mismatches = 0;
+    uint32_t failures   = 0;
+
+    printf ("%u KiB file, %u sectors per cluster\n"
+            "chunk,write MiB/s,read MiB/s,busy write s,busy read s,"
+            "sectors written,direct %%\n", fileKiB, clusterSectors);
+
+    for (uint32_t c = 0; c < sizeof(ChunkSizes) / sizeof(ChunkSizes[0]); ++ c)
+    {
+        const uint32_t Chunk = ChunkSizes[c];
+        UINT done;
+        FRESULT r;
+
+        fs.n_direct = fs.n_copied = 0;
+
+        const uint32_t Written      = sim.sectorsWritten;
+        const uint64_t WriteBusy    = sim.busy_us;
+        const uint64_t WriteStart   = now_us ();
+
+        r = f_open (&file, FATBENCH_FileName, FA_CREATE_ALWAYS | FA_WRITE);
+        for (uint32_t o = 0; r == FR_OK && o < FileSize; o += done)
+        {
+            const uint32_t Size = (FileSize - o < Chunk)? FileSize - o : Chunk;
+            fill (buf, Size, o);
+            r = f_write (&file, buf, Size, &done);
+            if (r == FR_OK && done != Size)
+            {
+                r = FR_DENIED;      // volume full
+            }
+        }
+        if (r == FR_OK)
+        {
+            r = f_close (&file);
+        }
+
+        const uint64_t WriteTime    = now_us () - WriteStart;
+        const uint32_t WriteSectors = sim.sectorsWritten - Written;
+
+        if (r != FR_OK)
+        {
+            printf ("%u,write failed (FRESULT %u)\n", Chunk, r);
+            ++ failures;
+            continue;
+        }
+
+        const uint64_t ReadBusy     = sim.busy_us;
+        const uint64_t ReadStart    = now_us ();
+
+        r = f_open (&file, FATBENCH_FileName, FA_OPEN_EXISTING | FA_READ);
+        for (uint32_t o = 0; r == FR_OK && o < FileSize; o += done)
+        {
+            const uint32_t Size = (FileSize - o < Chunk)? FileSize - o : Chunk;
+            r = f_read (&file, buf, Size, &done);
+            if (r == FR_OK && done != Size)
+            {
+                r = FR_INT_ERR;     // short file
+            }
+            if (r == FR_OK)
+            {
+                fill (expect, Size, o);
+                mismatches += memcmp (buf, expect, Size) != 0;
+            }
+        }
+        if (r == FR_OK)
+        {
+            r = f_close (&file);
+        }
+
+        const uint64_t ReadTime = now_us () - ReadStart;
+
+        if (r != FR_OK)
+        {
+            printf ("%u,read failed (FRESULT %u)\n", Chunk, r);
+            ++ failures;
+            continue;
+        }
+
+        const double MiB    = FileSize / (1024.0 * 1024.0);
+        const double Moved  = (double) fs.n_direct + fs.n_copied;
+
+        printf ("%u,%.1f,%.1f,%.3f,%.3f,%u,%.1f\n", Chunk,
+                WriteTime? MiB / (WriteTime / 1e6) : 0.0,
+                ReadTime? MiB / (ReadTime / 1e6) : 0.0,
+                (ReadBusy - WriteBusy) / 1e6, (sim.busy_us - ReadBusy) / 1e6,
+                WriteSectors, Moved? 100.0 * fs.n_direct / Moved : 0.0);
+    }
+
+    printf ("  sectors read %u, written %u, injected errors %u, "
+            "timeouts %u\n", sim.sectorsRead, sim.sectorsWritten,
+            sim.injectedErrors, sim.injectedTimeouts);
+    printf ("  failed passes %u, verify mismatches %u\n", failures,
+            mismatches);
+
+    f_mount (0, NULL);
+    STORAGE_SIMDISK_Attach (NULL);
+    STORAGE_SIMFILE_Close (&sim);
+    free (expect);
+    free (buf);
+
+    return mismatches? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,563 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host key/value store test on a RAM flash bank.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Runs KVSTORE on a RAM image of flash bank B mapped at its LPC4337 address,
+// so entry addresses still fit the 32 bit index. kvstore.c is included to
+// run one pass of the writer task at a time from this thread; each
+// KVSTORE_Sync() wait runs one, as the task would. Random sets and deletes
+// over a few keys keep garbage collection busy, every value read back is
+// checked against a RAM model and the store is rebuilt from flash every few
+// hundred operations, like a reset. The IAP stand-ins fail the test if
+// called without the store lock held, or if a page is programmed twice
+// without an erase. Before the workload the test holds the lock as another
+// task would: a plain lock attempt must fail and a lookup must wait for it.
+//
+// Build and run on the host:
+//
+//   gcc -O2 -std=gnu11 -I. -o kvtest kvtest.c ../../base/crc.c
+//       ../../base/attr.c                                   (one line)
+//   ./kvtest [-s segments] [-n operations] [-k keys] [-z maxSize]
+//            [-y syncEvery] [-m remountEvery] [-x seed]
+//
+// kvstore.c casts between pointers and 32 bit addresses, which 64 bit hosts
+// warn about. The casts hold: the bank is mapped below 4 GiB.
+
+#include "../kvstore.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+#define KVTEST_BankSize         0x80000u
+#define KVTEST_NoSector         0xFFFFFFFFu
+
+
+static struct KVSTORE   g_Kv;
+static bool             g_Locked;
+// Set by the test while it holds the lock in place of another task.
+static bool             g_Contended;
+static uint32_t         g_LockWaits;
+static uint32_t         g_Prepared      = KVTEST_NoSector;
+static uint32_t         g_Violations;
+
+
+static void violation (const char *what)
+{
+    printf ("  %s\n", what);
+    ++ g_Violations;
+}
+
+
+// OS services used by KVSTORE, single threaded on the host.
+enum OS_Result OS_MUTEX_Init (struct OS_MUTEX *m)
+{
+    (void) m;
+    g_Locked = false;
+    return OS_Result_OK;
+}
+
+
+// Like os/mutex.c, a taken lock is not waited for.
+enum OS_Result OS_MUTEX_Lock (struct OS_MUTEX *m)
+{
+    (void) m;
+    if (g_Locked)
+    {
+        return OS_Result_Retry;
+    }
+    g_Locked = true;
+    return OS_Result_OK;
+}
+
+
+enum OS_Result OS_MUTEX_Unlock (struct OS_MUTEX *m)
+{
+    (void) m;
+    if (!g_Locked)
+    {
+        violation ("unlock without lock");
+    }
+    g_Locked = false;
+    return OS_Result_OK;
+}
+
+
+bool SEMAPHORE_Init (struct SEMAPHORE *s, uint32_t resources,
+                     uint32_t available)
+{
+    s->resources = resources;
+    s->available = available;
+    return true;
+}
+
+
+bool SEMAPHORE_Release (struct SEMAPHORE *s)
+{
+    if (s->available >= s->resources)
+    {
+        return false;
+    }
+    ++ s->available;
+    return true;
+}
+
+
+OS_Ticks OS_GetTickPeriod_us ()
+{
+    return 1000;
+}
+
+
+// The writer task semaphore is not waited for. A lock held by the test
+// stands for another task that releases it later; held by KVSTORE itself,
+// the firmware would wait forever.
+enum OS_Result OS_TaskWaitForSignal (enum OS_TaskSignalType sigType,
+                                     void *sigObject, OS_Ticks timeout)
+{
+    if (sigType != OS_TaskSignalType_MutexLock)
+    {
+        return OS_Result_OK;
+    }
+
+    if (OS_MUTEX_Lock (sigObject) == OS_Result_OK)
+    {
+        return OS_Result_OK;
+    }
+
+    if (!g_Contended || !timeout)
+    {
+        violation ("lock taken twice");
+        return OS_Result_Timeout;
+    }
+
+    ++ g_LockWaits;
+    g_Contended = false;
+    g_Locked    = false;
+
+    return OS_MUTEX_Lock (sigObject);
+}
+
+
+// KVSTORE_Sync() polls with a delay; the writer task runs meanwhile.
+enum OS_Result OS_TaskDelay (OS_Ticks ticks)
+{
+    (void) ticks;
+    taskWork (&g_Kv);
+    return OS_Result_OK;
+}
+
+
+// IAP on the RAM bank. Sectors 0-7 are 8 KiB, 8-14 64 KiB.
+static uint32_t sectorOffset (uint32_t sector)
+{
+    return (sector < KVSTORE_SmallSectors)
+                ? sector * KVSTORE_SmallSectorSize
+                : KVSTORE_SmallSectors * KVSTORE_SmallSectorSize
+                    + (sector - KVSTORE_SmallSectors)
+                                                * KVSTORE_LargeSectorSize;
+}
+
+
+uint8_t Chip_IAP_Init (void)
+{
+    return IAP_CMD_SUCCESS;
+}
+
+
+uint8_t Chip_IAP_PreSectorForReadWrite (uint32_t strSector,
+                                        uint32_t endSector, uint8_t bankNum)
+{
+    if (!g_Locked)
+    {
+        violation ("IAP prepare without the store lock");
+    }
+
+    if (bankNum != 1 || strSector != endSector
+            || strSector >= KVSTORE_Sectors)
+    {
+        violation ("IAP prepare out of range");
+        return 1;
+    }
+
+    g_Prepared = strSector;
+    return IAP_CMD_SUCCESS;
+}
+
+
+uint8_t Chip_IAP_CopyRamToFlash (uint32_t dstAdd, uint32_t *srcAdd,
+                                 uint32_t byteswrt)
+{
+    const uint32_t Offset   = dstAdd - KVSTORE_BankB;
+    const uint32_t Sector   = g_Prepared;
+    uint8_t *dst            = (uint8_t *) (uintptr_t) dstAdd;
+
+    g_Prepared = KVTEST_NoSector;
+
+    if (!g_Locked)
+    {
+        violation ("IAP program without the store lock");
+    }
+
+    if (Sector == KVTEST_NoSector || Offset < sectorOffset (Sector)
+            || Offset + byteswrt > sectorOffset (Sector + 1)
+            || byteswrt != KVSTORE_PageSize || Offset % KVSTORE_PageSize)
+    {
+        violation ("IAP program out of the prepared sector");
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < byteswrt; ++ i)
+    {
+        if (dst[i] != KVSTORE_Erased)
+        {
+            violation ("IAP program over a programmed page");
+            return 1;
+        }
+    }
+
+    memcpy (dst, srcAdd, byteswrt);
+    return IAP_CMD_SUCCESS;
+}
+
+
+uint8_t Chip_IAP_EraseSector (uint32_t strSector, uint32_t endSector,
+                              uint8_t bankNum)
+{
+    const uint32_t Sector = g_Prepared;
+
+    g_Prepared = KVTEST_NoSector;
+
+    if (!g_Locked)
+    {
+        violation ("IAP erase without the store lock");
+    }
+
+    if (bankNum != 1 || strSector != endSector || strSector != Sector)
+    {
+        violation ("IAP erase of an unprepared sector");
+        return 1;
+    }
+
+    memset ((uint8_t *) (uintptr_t) (KVSTORE_BankB + sectorOffset (Sector)),
+            KVSTORE_Erased, sectorOffset (Sector + 1) - sectorOffset (Sector));
+    return IAP_CMD_SUCCESS;
+}
+
+
+// Values follow from the key and version, so any value read back can be
+// checked without keeping a copy. Version 0: key not set.
+static uint32_t valueSize (uint32_t key, uint32_t version, uint32_t maxSize)
+{
+    return ((key * 0x9E3779B9u) ^ (version * 2654435761u)) % (maxSize + 1);
+}
+
+
+static void valueFill (uint32_t key, uint32_t version, uint8_t *data,
+                       uint32_t size)
+{
+    uint32_t x = key * 0x9E3779B9u + version + 1;
+
+    for (uint32_t i = 0; i < size; ++ i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t) x;
+    }
+}
+
+
+static uint32_t random32 (uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+
+// Checks one key against the model. Returns 1 on mismatch.
+static uint32_t check (uint32_t key, uint32_t version, uint32_t maxSize)
+{
+    uint8_t buf[KVSTORE_MaxValueSize];
+    uint8_t expected[KVSTORE_MaxValueSize];
+    char name[KVSTORE_MaxKeySize + 1];
+    uint32_t size = 0;
+
+    snprintf (name, sizeof(name), "key%u", key);
+
+    const enum OS_Result R = KVSTORE_Get (&g_Kv, name, buf, sizeof(buf),
+                                          &size);
+    if (!version)
+    {
+        if (R != OS_Result_Empty)
+        {
+            printf ("  %s: deleted but found, result %u\n", name, R);
+            return 1;
+        }
+        return 0;
+    }
+
+    const uint32_t Size = valueSize (key, version, maxSize);
+    valueFill (key, version, expected, Size);
+
+    if (R != OS_Result_OK || size != Size || memcmp (buf, expected, Size))
+    {
+        printf ("  %s: version %u damaged, result %u\n", name, version, R);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int main (int argc, char *argv[])
+{
+    uint32_t segments       = 4;
+    uint32_t operations     = 20000;
+    uint32_t keys           = 80;
+    uint32_t maxSize        = 120;
+    uint32_t syncEvery      = 50;
+    uint32_t remountEvery   = 500;
+    uint32_t seed           = 1;
+
+    int opt;
+    while ((opt = getopt (argc, argv, "s:n:k:z:y:m:x:")) != -1)
+    {
+        const uint32_t V = (uint32_t) strtoul (optarg? optarg : "0", NULL, 0);
+        switch (opt)
+        {
+            case 's': segments      = V; break;
+            case 'n': operations    = V; break;
+            case 'k': keys          = V; break;
+            case 'z': maxSize       = V; break;
+            case 'y': syncEvery     = V; break;
+            case 'm': remountEvery  = V; break;
+            case 'x': seed          = V; break;
+            default:
+                fprintf (stderr, "usage: %s [-s segments] [-n operations] "
+                         "[-k keys] [-z maxSize] [-y syncEvery] "
+                         "[-m remountEvery] [-x seed]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (segments < 2 || segments > KVSTORE_SmallSectors || !keys
+            || keys >= KVSTORE_INDEX_SLOTS * 3 / 4 || !syncEvery
+            || !remountEvery || maxSize > KVSTORE_MaxValueSize || !seed)
+    {
+        fprintf (stderr, "invalid parameters\n");
+        return EXIT_FAILURE;
+    }
+
+    // Entry addresses are stored as 32 bits: the bank goes at its real
+    // address.
+    void *bank = mmap ((void *) (uintptr_t) KVSTORE_BankB, KVTEST_BankSize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                       -1, 0);
+    if (bank != (void *) (uintptr_t) KVSTORE_BankB)
+    {
+        perror ("mmap");
+        return EXIT_FAILURE;
+    }
+
+    // Blank flash is not erased as far as KVSTORE can tell.
+    memset (bank, 0, KVTEST_BankSize);
+
+    const struct KVSTORE_InitParams Params =
+    {
+        .bank           = 1,
+        .firstSector    = 0,
+        .segments       = segments
+    };
+
+    uint32_t *version   = calloc (keys, sizeof(uint32_t));
+    uint8_t value[KVSTORE_MaxValueSize];
+    uint32_t errors     = 0;
+    uint32_t retries    = 0;
+    uint32_t remounts   = 0;
+    uint32_t next       = 0;
+    uint64_t payload    = 0;
+    uint32_t pages      = 0;
+    uint32_t erased     = 0;
+    uint32_t collected  = 0;
+    enum OS_Result r;
+
+    if (!version)
+    {
+        fprintf (stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    if ((r = KVSTORE_Init (&g_Kv, &Params)) != OS_Result_OK)
+    {
+        fprintf (stderr, "init failed, result %u\n", r);
+        return EXIT_FAILURE;
+    }
+
+    // Another task holding the lock, as the writer task does during IAP.
+    {
+        uint32_t size;
+
+        if ((r = KVSTORE_Set (&g_Kv, "locked", "v", 1)) != OS_Result_OK
+                || (r = KVSTORE_Sync (&g_Kv)) != OS_Result_OK)
+        {
+            fprintf (stderr, "lock test set failed, result %u\n", r);
+            return EXIT_FAILURE;
+        }
+
+        g_Locked    = true;
+        g_Contended = true;
+
+        if ((r = OS_MUTEX_Lock (&g_Kv.lock)) != OS_Result_Retry)
+        {
+            printf ("  lock taken while held, result %u\n", r);
+            ++ errors;
+        }
+
+        if ((r = KVSTORE_Get (&g_Kv, "locked", value, sizeof(value), &size))
+                                                        != OS_Result_OK
+                || g_LockWaits != 1 || g_Locked)
+        {
+            printf ("  lookup did not wait for the lock, result %u\n", r);
+            ++ errors;
+        }
+
+        g_Contended = false;
+
+        if ((r = KVSTORE_Delete (&g_Kv, "locked")) != OS_Result_OK)
+        {
+            fprintf (stderr, "lock test delete failed, result %u\n", r);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (uint32_t op = 1; op <= operations; ++ op)
+    {
+        const uint32_t Key = random32 (&seed) % keys;
+        char name[KVSTORE_MaxKeySize + 1];
+
+        snprintf (name, sizeof(name), "key%u", Key);
+
+        const bool Delete = version[Key] && !(random32 (&seed) % 8);
+        const uint32_t Version = Delete? 0 : ++ next;
+        const uint32_t Size = valueSize (Key, Version, maxSize);
+
+        valueFill (Key, Version, value, Size);
+
+        // Both pages queued: give the task a pass, as KVSTORE_Set() callers
+        // do by retrying later.
+        while ((r = Delete? KVSTORE_Delete (&g_Kv, name)
+                          : KVSTORE_Set (&g_Kv, name, value, Size))
+                                                        == OS_Result_Retry)
+        {
+            ++ retries;
+            taskWork (&g_Kv);
+        }
+
+        if (r != OS_Result_OK)
+        {
+            fprintf (stderr, "%s failed, result %u\n",
+                     Delete? "delete" : "set", r);
+            return EXIT_FAILURE;
+        }
+
+        version[Key]    = Version;
+        payload         += Size;
+
+        const uint32_t Check = random32 (&seed) % keys;
+        errors += check (Check, version[Check], maxSize);
+
+        if (op % syncEvery == 0 && (r = KVSTORE_Sync (&g_Kv)) != OS_Result_OK)
+        {
+            fprintf (stderr, "sync failed, result %u%s\n", r,
+                     (r == OS_Result_BufferFull)?
+                                ", live entries do not fit (-k, -z, -s)" : "");
+            return EXIT_FAILURE;
+        }
+
+        if (op % remountEvery == 0 || op == operations)
+        {
+            if ((r = KVSTORE_Sync (&g_Kv)) != OS_Result_OK)
+            {
+                fprintf (stderr, "sync failed, result %u\n", r);
+                return EXIT_FAILURE;
+            }
+
+            pages       += g_Kv.pagesProgrammed;
+            erased      += g_Kv.segmentsErased;
+            collected   += g_Kv.entriesCollected;
+            errors      += g_Kv.flashErrors + g_Kv.entriesCorrupted;
+
+            if ((r = KVSTORE_Init (&g_Kv, &Params)) != OS_Result_OK)
+            {
+                fprintf (stderr, "remount failed, result %u\n", r);
+                return EXIT_FAILURE;
+            }
+
+            ++ remounts;
+            errors += g_Kv.entriesCorrupted;
+
+            for (uint32_t k = 0; k < keys; ++ k)
+            {
+                errors += check (k, version[k], maxSize);
+            }
+        }
+    }
+
+    uint32_t minErase = UINT32_MAX;
+    uint32_t maxErase = 0;
+
+    for (uint32_t i = 0; i < segments; ++ i)
+    {
+        const uint32_t E = KVSTORE_EraseCount (&g_Kv, i);
+        minErase = (E < minErase)? E : minErase;
+        maxErase = (E > maxErase)? E : maxErase;
+    }
+
+    printf ("%u operations on %u keys, %u segments of %u bytes, "
+            "%u remounts\n", operations, keys, segments,
+            KVSTORE_SmallSectorSize, remounts);
+    printf ("  %u pages programmed, %u segments erased, %u entries "
+            "collected, %u retries\n", pages, erased, collected, retries);
+    printf ("  write amplification %.2f, erase count %u-%u\n",
+            payload? (double) pages * KVSTORE_PageSize / payload : 0.0,
+            minErase, maxErase);
+    printf ("  %u errors, %u violations\n", errors, g_Violations);
+
+    return (errors || g_Violations)? EXIT_FAILURE : EXIT_SUCCESS;
+}
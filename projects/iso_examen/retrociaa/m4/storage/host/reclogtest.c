@@ -0,0 +1,517 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host record log test on the storage simulator.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Runs RECLOG on a STORAGE_SIMFILE image. Records are appended and flushed
+// in groups, older ones released and compacted as RECLOG_CompactTask() would
+// do, and the log is remounted every few hundred records with the queued
+// ones dropped, like a reset. After each mount every record still live must
+// read back intact. Reports write amplification (media bytes written per
+// payload byte) and simulated device time per flush, compaction and mount.
+// Before the workload the test holds the log lock as another task would: a
+// plain lock attempt must fail and a flush must wait for it.
+//
+// Build and run on the host:
+//
+//   gcc -O2 -std=gnu11 -I. -o reclogtest reclogtest.c simfile.c
+//       ../reclog.c ../../base/crc.c ../../base/attr.c      (one line)
+//   ./reclogtest [-i image] [-s sectors] [-n records] [-z maxSize]
+//                [-f flushEvery] [-k keep] [-m remountEvery]
+//                [-r read_us] [-w write_us] [-p sector_us] [-x seed]
+
+#include "simfile.h"
+#include "../reclog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define RECLOGTEST_Driver       "simfile"
+
+
+static struct STORAGE_Device    g_Device;
+static bool                     g_Locked;
+// Set by the test while it holds the lock in place of another task.
+static bool                     g_Contended;
+static uint32_t                 g_LockWaits;
+static uint32_t                 g_Violations;
+
+
+// OS services used by RECLOG, single threaded on the host.
+enum OS_Result OS_TaskDriverStorage (const char* description,
+                                     enum OS_TaskDriverOp op, uint8_t *buf,
+                                     uint32_t sector, uint32_t count)
+{
+    enum STORAGE_Result r;
+
+    if (strcmp (description, RECLOGTEST_Driver))
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    switch (op)
+    {
+        case OS_TaskDriverOp_Read:
+            r = g_Device.read (g_Device.handler, buf, sector, count);
+            break;
+
+        case OS_TaskDriverOp_Write:
+            r = g_Device.write (g_Device.handler, buf, sector, count);
+            break;
+
+        case OS_TaskDriverOp_Sync:
+            r = g_Device.ioctl (g_Device.handler, CTRL_SYNC, NULL);
+            break;
+
+        default:
+            return OS_Result_InvalidOperation;
+    }
+
+    return (r == STORAGE_Result_Ok)? OS_Result_OK : OS_Result_Error;
+}
+
+
+enum OS_Result OS_MUTEX_Init (struct OS_MUTEX *m)
+{
+    (void) m;
+    g_Locked = false;
+    return OS_Result_OK;
+}
+
+
+// Like os/mutex.c, a taken lock is not waited for.
+enum OS_Result OS_MUTEX_Lock (struct OS_MUTEX *m)
+{
+    (void) m;
+    if (g_Locked)
+    {
+        return OS_Result_Retry;
+    }
+    g_Locked = true;
+    return OS_Result_OK;
+}
+
+
+enum OS_Result OS_MUTEX_Unlock (struct OS_MUTEX *m)
+{
+    (void) m;
+    if (!g_Locked)
+    {
+        printf ("  unlock without lock\n");
+        ++ g_Violations;
+    }
+    g_Locked = false;
+    return OS_Result_OK;
+}
+
+
+// A lock held by the test stands for another task that releases it later;
+// held by RECLOG itself, the firmware would wait forever.
+enum OS_Result OS_TaskWaitForSignal (enum OS_TaskSignalType sigType,
+                                     void *sigObject, OS_Ticks timeout)
+{
+    if (sigType != OS_TaskSignalType_MutexLock)
+    {
+        return OS_Result_OK;
+    }
+
+    if (OS_MUTEX_Lock (sigObject) == OS_Result_OK)
+    {
+        return OS_Result_OK;
+    }
+
+    if (!g_Contended || !timeout)
+    {
+        printf ("  lock taken twice\n");
+        ++ g_Violations;
+        return OS_Result_Timeout;
+    }
+
+    ++ g_LockWaits;
+    g_Contended = false;
+    g_Locked    = false;
+
+    return OS_MUTEX_Lock (sigObject);
+}
+
+
+OS_Ticks OS_GetTickPeriod_us ()
+{
+    return 1000;
+}
+
+
+enum OS_Result OS_TaskDelay (OS_Ticks ticks)
+{
+    usleep ((useconds_t) ticks * 1000);
+    return OS_Result_OK;
+}
+
+
+// Record contents follow from the id, so any record read back can be
+// checked without keeping a copy.
+static uint32_t recordSize (uint32_t id, uint32_t maxSize)
+{
+    return (id * 2654435761u >> 8) % (maxSize + 1);
+}
+
+
+static void recordFill (uint32_t id, uint8_t *data, uint32_t size)
+{
+    uint32_t x = id * 0x9E3779B9u + 1;
+
+    for (uint32_t i = 0; i < size; ++ i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (uint8_t) x;
+    }
+}
+
+
+static uint16_t recordType (uint32_t id)
+{
+    return (uint16_t) (id * 7);
+}
+
+
+struct Latency
+{
+    uint32_t    count;
+    uint64_t    total_us;
+    uint64_t    max_us;
+};
+
+
+static void latencyAdd (struct Latency *l, uint64_t us)
+{
+    ++ l->count;
+    l->total_us += us;
+    if (us > l->max_us)
+    {
+        l->max_us = us;
+    }
+}
+
+
+static void latencyPrint (const char *name, const struct Latency *l)
+{
+    printf ("  %-8s %8u calls, avg %8.1f us, max %8llu us\n", name, l->count,
+            l->count? (double) l->total_us / l->count : 0.0,
+            (unsigned long long) l->max_us);
+}
+
+
+// Reads the whole log back. Every live record up to flushed must be there,
+// nothing before first (the first id after the format) or past flushed may
+// be. seen is indexed from first. Returns the number of errors found.
+static uint32_t verify (struct RECLOG *log, uint32_t first,
+                        uint32_t released, uint32_t flushed,
+                        uint32_t maxSize, uint8_t *seen)
+{
+    static struct RECLOG_Cursor cursor;
+    uint8_t buf[RECLOG_MaxRecordSize];
+    uint8_t expected[RECLOG_MaxRecordSize];
+    uint32_t errors = 0;
+    uint16_t type;
+    uint32_t id;
+    uint32_t size;
+    enum OS_Result r;
+
+    memset (seen, 0, flushed - first);
+    RECLOG_CursorInit (log, &cursor);
+
+    while ((r = RECLOG_ReadNext (log, &cursor, &type, &id, buf, sizeof(buf),
+                                 &size)) == OS_Result_OK)
+    {
+        if (id < first || id >= flushed)
+        {
+            printf ("  record %u was never flushed\n", id);
+            ++ errors;
+            continue;
+        }
+
+        recordFill (id, expected, size);
+
+        if (size != recordSize (id, maxSize) || type != recordType (id)
+                || memcmp (buf, expected, size))
+        {
+            printf ("  record %u damaged\n", id);
+            ++ errors;
+        }
+
+        seen[id - first] = 1;
+    }
+
+    if (r != OS_Result_Empty)
+    {
+        printf ("  read failed, result %u\n", r);
+        ++ errors;
+    }
+
+    for (uint32_t i = released; i < flushed; ++ i)
+    {
+        if (!seen[i - first])
+        {
+            printf ("  record %u lost\n", i);
+            ++ errors;
+        }
+    }
+
+    return errors;
+}
+
+
+int main (int argc, char *argv[])
+{
+    const char *path        = "reclogtest.img";
+    uint32_t sectors        = 64;
+    uint32_t records        = 20000;
+    uint32_t maxSize        = 48;
+    uint32_t flushEvery     = 8;
+    uint32_t keep           = 400;
+    uint32_t remountEvery   = 500;
+
+    struct STORAGE_SIMFILE_Config config =
+    {
+        .readLatency_us     = 100,
+        .writeLatency_us    = 250,
+        .sectorLatency_us   = 20,
+        .eraseBlock         = 8,
+        .seed               = 1
+    };
+
+    int opt;
+    while ((opt = getopt (argc, argv, "i:s:n:z:f:k:m:r:w:p:x:")) != -1)
+    {
+        const uint32_t V = (uint32_t) strtoul (optarg? optarg : "0", NULL, 0);
+        switch (opt)
+        {
+            case 'i': path                      = optarg; break;
+            case 's': sectors                   = V; break;
+            case 'n': records                   = V; break;
+            case 'z': maxSize                   = V; break;
+            case 'f': flushEvery                = V; break;
+            case 'k': keep                      = V; break;
+            case 'm': remountEvery              = V; break;
+            case 'r': config.readLatency_us     = V; break;
+            case 'w': config.writeLatency_us    = V; break;
+            case 'p': config.sectorLatency_us   = V; break;
+            case 'x': config.seed               = V; break;
+            default:
+                fprintf (stderr, "usage: %s [-i image] [-s sectors] "
+                         "[-n records] [-z maxSize] [-f flushEvery] [-k keep] "
+                         "[-m remountEvery] [-r read_us] [-w write_us] "
+                         "[-p sector_us] [-x seed]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (sectors < RECLOG_MinSectors || !records || !flushEvery
+            || !remountEvery || maxSize > RECLOG_MaxRecordSize)
+    {
+        fprintf (stderr, "invalid parameters\n");
+        return EXIT_FAILURE;
+    }
+
+    struct STORAGE_SIMFILE sim;
+
+    if (!STORAGE_SIMFILE_Init (&sim, path, sectors, &config, &g_Device))
+    {
+        perror (path);
+        return EXIT_FAILURE;
+    }
+
+    static struct RECLOG log;
+    uint8_t *seen = malloc (records + 1);
+    uint8_t data[RECLOG_MaxRecordSize];
+
+    if (!seen)
+    {
+        fprintf (stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    enum OS_Result r = RECLOG_Format (&log, RECLOGTEST_Driver, 0, sectors);
+    if (r != OS_Result_OK)
+    {
+        fprintf (stderr, "format failed, result %u\n", r);
+        return EXIT_FAILURE;
+    }
+
+    // Another task holding the lock, as RECLOG_CompactTask() does.
+    g_Locked    = true;
+    g_Contended = true;
+
+    if ((r = OS_MUTEX_Lock (&log.lock)) != OS_Result_Retry)
+    {
+        printf ("  lock taken while held, result %u\n", r);
+        ++ g_Violations;
+    }
+
+    if ((r = RECLOG_Flush (&log)) != OS_Result_OK || g_LockWaits != 1
+            || g_Locked)
+    {
+        printf ("  flush did not wait for the lock, result %u\n", r);
+        ++ g_Violations;
+    }
+
+    g_Contended = false;
+
+    struct Latency flushes  = { 0 };
+    struct Latency compacts = { 0 };
+    struct Latency mounts   = { 0 };
+    uint64_t payload        = 0;
+    // Format carries ids on from a log already in the image.
+    const uint32_t First    = log.nextId;
+    uint32_t released       = First;
+    uint32_t errors         = 0;
+    uint32_t appended       = 0;
+    uint32_t lost           = 0;
+    uint32_t full           = 0;
+    uint32_t sectorsWritten = 0;
+    uint32_t checkpoints    = 0;
+    uint32_t compacted      = 0;
+
+    const uint32_t SectorsBefore = sim.sectorsWritten;
+
+    while (appended < records)
+    {
+        const uint32_t Size = recordSize (log.nextId, maxSize);
+        uint32_t id;
+
+        recordFill (log.nextId, data, Size);
+        r = RECLOG_Append (&log, recordType (log.nextId), data, Size, &id);
+
+        if (r == OS_Result_BufferFull)
+        {
+            ++ full;
+            RECLOG_Compact (&log);
+            continue;
+        }
+        else if (r != OS_Result_OK)
+        {
+            fprintf (stderr, "append failed, result %u\n", r);
+            return EXIT_FAILURE;
+        }
+
+        payload += Size;
+        ++ appended;
+
+        if (id - First >= keep && id - keep > released)
+        {
+            released = id - keep;
+            RECLOG_Release (&log, released);
+        }
+
+        if (appended % flushEvery == 0)
+        {
+            uint64_t busy = sim.busy_us;
+            if ((r = RECLOG_Flush (&log)) == OS_Result_BufferFull)
+            {
+                ++ full;
+                RECLOG_Compact (&log);
+                r = RECLOG_Flush (&log);
+            }
+
+            if (r != OS_Result_OK)
+            {
+                fprintf (stderr, "flush failed, result %u%s\n", r,
+                         (r == OS_Result_BufferFull)?
+                                    ", live records do not fit (-k, -s)" : "");
+                return EXIT_FAILURE;
+            }
+            latencyAdd (&flushes, sim.busy_us - busy);
+
+            busy = sim.busy_us;
+            RECLOG_Compact (&log);
+            latencyAdd (&compacts, sim.busy_us - busy);
+        }
+
+        if (appended % remountEvery == 0 || appended == records)
+        {
+            sectorsWritten  += log.sectorsWritten;
+            checkpoints     += log.checkpointsWritten;
+            compacted       += log.recordsCompacted;
+
+            const uint32_t NextId = log.nextId;
+            const uint64_t Busy = sim.busy_us;
+
+            if ((r = RECLOG_Mount (&log, RECLOGTEST_Driver, 0, sectors))
+                                                            != OS_Result_OK)
+            {
+                fprintf (stderr, "mount failed, result %u\n", r);
+                return EXIT_FAILURE;
+            }
+            latencyAdd (&mounts, sim.busy_us - Busy);
+
+            // Records still queued in RAM are lost, as on a reset.
+            for (uint32_t i = log.nextId; i != NextId; ++ i)
+            {
+                payload -= recordSize (i, maxSize);
+                ++ lost;
+            }
+
+            // Release is not durable until the next checkpoint; mount may
+            // bring back released records, but never lose a live one.
+            errors += verify (&log, First, released, log.nextId, maxSize,
+                              seen);
+        }
+    }
+
+    const uint64_t Media = (uint64_t) (sim.sectorsWritten - SectorsBefore)
+                                                        * STORAGE_SectorSize;
+
+    printf ("%u records, %u bytes max, flush every %u, keep %u, "
+            "%u sectors\n", appended, maxSize, flushEvery, keep, sectors);
+    printf ("  payload %llu bytes, media written %llu bytes, "
+            "write amplification %.2f\n", (unsigned long long) payload,
+            (unsigned long long) Media, payload? (double) Media / payload
+                                                                    : 0.0);
+    printf ("  data sectors %u, checkpoints %u, records compacted %u, "
+            "ring full %u\n", sectorsWritten, checkpoints, compacted, full);
+    printf ("  queued records dropped by remount %u\n", lost);
+    latencyPrint ("flush", &flushes);
+    latencyPrint ("compact", &compacts);
+    latencyPrint ("mount", &mounts);
+    printf ("  verify errors %u, lock violations %u\n", errors,
+            g_Violations);
+
+    STORAGE_SIMFILE_Close (&sim);
+    free (seen);
+
+    return (errors || g_Violations)? EXIT_FAILURE : EXIT_SUCCESS;
+}
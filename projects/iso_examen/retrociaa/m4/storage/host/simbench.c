@@ -0,0 +1,241 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host storage simulator soak and throughput bench.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Drives a STORAGE_SIMFILE through the STORAGE_Device contract with a random
+// mix of reads and writes, checks every successful read against a shadow
+// copy of the image and reports throughput and results. Sectors hit by a
+// failed write are unknown until rewritten, as they would be on a card.
+//
+// Build and run on the host:
+//
+//   gcc -O2 -std=gnu99 -o simbench simbench.c simfile.c
+//   ./simbench [-i image] [-s sectors] [-n ops] [-e errorPpm] [-t timeoutPpm]
+//              [-r read_us] [-w write_us] [-p sector_us] [-m maxSectors]
+//              [-x seed]
+
+#include "simfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define SIMBENCH_ResultCount    (STORAGE_Result_Timeout + 1)
+
+
+static const char *ResultNames[SIMBENCH_ResultCount] =
+{
+    "ok", "read/write error", "write protected", "not ready",
+    "invalid parameter", "timeout"
+};
+
+
+static uint64_t now_us (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+int main (int argc, char *argv[])
+{
+    const char *path    = "simbench.img";
+    uint32_t sectors    = 8192;
+    uint32_t ops        = 10000;
+    uint32_t maxSectors = 64;
+
+    struct STORAGE_SIMFILE_Config config =
+    {
+        .timeout_us = 1000,
+        .eraseBlock = 8,
+        .seed       = 1
+    };
+
+    int opt;
+    while ((opt = getopt (argc, argv, "i:s:n:e:t:r:w:p:m:x:")) != -1)
+    {
+        const uint32_t V = (uint32_t) strtoul (optarg? optarg : "0", NULL, 0);
+        switch (opt)
+        {
+            case 'i': path                      = optarg; break;
+            case 's': sectors                   = V; break;
+            case 'n': ops                       = V; break;
+            case 'e': config.errorPpm           = V; break;
+            case 't': config.timeoutPpm         = V; break;
+            case 'r': config.readLatency_us     = V; break;
+            case 'w': config.writeLatency_us    = V; break;
+            case 'p': config.sectorLatency_us   = V; break;
+            case 'm': maxSectors                = V; break;
+            case 'x': config.seed               = V; break;
+            default:
+                fprintf (stderr, "usage: %s [-i image] [-s sectors] [-n ops] "
+                         "[-e errorPpm] [-t timeoutPpm] [-r read_us] "
+                         "[-w write_us] [-p sector_us] [-m maxSectors] "
+                         "[-x seed]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!sectors || !maxSectors || maxSectors > sectors)
+    {
+        fprintf (stderr, "invalid sizes\n");
+        return EXIT_FAILURE;
+    }
+
+    struct STORAGE_SIMFILE  sim;
+    struct STORAGE_Device   device;
+
+    if (!STORAGE_SIMFILE_Init (&sim, path, sectors, &config, &device))
+    {
+        perror (path);
+        return EXIT_FAILURE;
+    }
+
+    const size_t ImageSize  = (size_t) sectors * STORAGE_SectorSize;
+    const size_t BufSize    = (size_t) maxSectors * STORAGE_SectorSize;
+
+    uint8_t *shadow = malloc (ImageSize);
+    uint8_t *known  = malloc (sectors);
+    uint8_t *buf    = NULL;
+
+    if (posix_memalign ((void **) &buf, STORAGE_BufferAlign, BufSize))
+    {
+        buf = NULL;
+    }
+
+    if (!shadow || !known || !buf)
+    {
+        fprintf (stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Existing image contents are trusted as the starting point.
+    memcpy (shadow, sim.image, ImageSize);
+    memset (known, 1, sectors);
+
+    uint32_t results[2][SIMBENCH_ResultCount] = { { 0 } };
+    uint32_t mismatches = 0;
+    uint64_t bytes      = 0;
+
+    srand (config.seed);
+    const uint64_t Start = now_us ();
+
+    for (uint32_t op = 0; op < ops; ++ op)
+    {
+        const bool Write        = rand () & 1;
+        const uint32_t Count    = 1 + (uint32_t) rand () % maxSectors;
+        const uint32_t Sector   = (uint32_t) rand () % (sectors - Count + 1);
+        const size_t Offset     = (size_t) Sector * STORAGE_SectorSize;
+        const size_t Size       = (size_t) Count * STORAGE_SectorSize;
+        enum STORAGE_Result r;
+
+        if (Write)
+        {
+            for (size_t i = 0; i < Size; ++ i)
+            {
+                buf[i] = (uint8_t) rand ();
+            }
+
+            r = device.write (device.handler, buf, Sector, Count);
+            if (r == STORAGE_Result_Ok)
+            {
+                memcpy (&shadow[Offset], buf, Size);
+                memset (&known[Sector], 1, Count);
+            }
+            else if (r == STORAGE_Result_ReadWriteError)
+            {
+                memset (&known[Sector], 0, Count);
+            }
+        }
+        else
+        {
+            r = device.read (device.handler, buf, Sector, Count);
+            if (r == STORAGE_Result_Ok)
+            {
+                for (uint32_t s = 0; s < Count; ++ s)
+                {
+                    const size_t O = (size_t) s * STORAGE_SectorSize;
+                    if (known[Sector + s] && memcmp (&buf[O],
+                                        &shadow[Offset + O], STORAGE_SectorSize))
+                    {
+                        ++ mismatches;
+                    }
+                }
+            }
+        }
+
+        if (r == STORAGE_Result_Ok)
+        {
+            bytes += Size;
+        }
+
+        ++ results[Write][r < SIMBENCH_ResultCount? r : 0];
+    }
+
+    const uint64_t Elapsed = now_us () - Start;
+
+    if (device.ioctl (device.handler, CTRL_SYNC, NULL) != STORAGE_Result_Ok)
+    {
+        fprintf (stderr, "sync failed\n");
+    }
+
+    printf ("%u ops on %u sectors in %.3f s, %.2f MiB/s, "
+            "simulated busy %.3f s\n", ops, sectors, Elapsed / 1e6,
+            Elapsed? (bytes / (1024.0 * 1024.0)) / (Elapsed / 1e6) : 0.0,
+            sim.busy_us / 1e6);
+
+    for (uint32_t i = 0; i < SIMBENCH_ResultCount; ++ i)
+    {
+        if (results[0][i] || results[1][i])
+        {
+            printf ("  %-18s read %8u  write %8u\n", ResultNames[i],
+                    results[0][i], results[1][i]);
+        }
+    }
+
+    printf ("  sectors read %u, written %u, injected errors %u, "
+            "timeouts %u\n", sim.sectorsRead, sim.sectorsWritten,
+            sim.injectedErrors, sim.injectedTimeouts);
+    printf ("  verify mismatches %u\n", mismatches);
+
+    STORAGE_SIMFILE_Close (&sim);
+    free (buf);
+    free (known);
+    free (shadow);
+
+    return mismatches? EXIT_FAILURE : EXIT_SUCCESS;
+}
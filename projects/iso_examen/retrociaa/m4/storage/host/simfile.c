@@ -0,0 +1,368 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host file-backed storage device simulator.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "simfile.h"
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+// xorshift32; never seeded with zero.
+static uint32_t nextRandom (struct STORAGE_SIMFILE *sim)
+{
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+
+static bool chance (struct STORAGE_SIMFILE *sim, uint32_t ppm)
+{
+    return ppm && (nextRandom (sim) % STORAGE_SIMFILE_RatePpm) < ppm;
+}
+
+
+static void delay (struct STORAGE_SIMFILE *sim, uint32_t us)
+{
+    if (!us)
+    {
+        return;
+    }
+
+    struct timespec ts = { .tv_sec  = us / 1000000,
+                           .tv_nsec = (long) (us % 1000000) * 1000 };
+    while (nanosleep (&ts, &ts) == -1)
+    {
+    }
+
+    sim->busy_us += us;
+}
+
+
+// Common checks and fault injection for a transfer of count sectors.
+static enum STORAGE_Result transferBegin (struct STORAGE_SIMFILE *sim,
+                                          const void *buf, uint32_t sector,
+                                          uint32_t count, uint32_t latency_us)
+{
+    if (!buf || !count)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    if (sim->status & STORAGE_Status_Not_Initialized)
+    {
+        return STORAGE_Result_NotReady;
+    }
+
+    if (sector >= sim->sectors || count > sim->sectors - sector)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    if (chance (sim, sim->config.timeoutPpm))
+    {
+        ++ sim->injectedTimeouts;
+        delay (sim, sim->config.timeout_us);
+        return STORAGE_Result_Timeout;
+    }
+
+    delay (sim, latency_us + count * sim->config.sectorLatency_us);
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result simRead (void *handler, uint8_t *buf,
+                                    uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SIMFILE *sim = (struct STORAGE_SIMFILE *) handler;
+
+    const enum STORAGE_Result Result = transferBegin (sim, buf, sector, count,
+                                                sim->config.readLatency_us);
+    if (Result != STORAGE_Result_Ok)
+    {
+        return Result;
+    }
+
+    ++ sim->reads;
+
+    if (chance (sim, sim->config.errorPpm))
+    {
+        ++ sim->injectedErrors;
+        return STORAGE_Result_ReadWriteError;
+    }
+
+    memcpy (buf, &sim->image[sector * STORAGE_SectorSize],
+            count * STORAGE_SectorSize);
+
+    sim->sectorsRead += count;
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result simWrite (void *handler, const uint8_t *buf,
+                                     uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SIMFILE *sim = (struct STORAGE_SIMFILE *) handler;
+
+    if (sim->status & STORAGE_Status_Write_Protected)
+    {
+        return STORAGE_Result_WriteProtected;
+    }
+
+    const enum STORAGE_Result Result = transferBegin (sim, buf, sector, count,
+                                                sim->config.writeLatency_us);
+    if (Result != STORAGE_Result_Ok)
+    {
+        return Result;
+    }
+
+    ++ sim->writes;
+
+    if (chance (sim, sim->config.errorPpm))
+    {
+        // Torn write: some leading sectors made it to the media.
+        const uint32_t Written = nextRandom (sim) % count;
+        memcpy (&sim->image[sector * STORAGE_SectorSize], buf,
+                Written * STORAGE_SectorSize);
+
+        sim->sectorsWritten += Written;
+        ++ sim->injectedErrors;
+        return STORAGE_Result_ReadWriteError;
+    }
+
+    memcpy (&sim->image[sector * STORAGE_SectorSize], buf,
+            count * STORAGE_SectorSize);
+
+    sim->sectorsWritten += count;
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result simIoCtl (void *handler, uint8_t cmd, void *buf)
+{
+    struct STORAGE_SIMFILE *sim = (struct STORAGE_SIMFILE *) handler;
+
+    if (cmd == CTRL_POWER)
+    {
+        uint8_t *const Sub = (uint8_t *) buf;
+        if (!Sub)
+        {
+            return STORAGE_Result_InvalidParameter;
+        }
+
+        switch (Sub[0])
+        {
+            case CTRL_POWER_OFF:
+                sim->status |= STORAGE_Status_Not_Initialized;
+                return STORAGE_Result_Ok;
+
+            case CTRL_POWER_ON:
+                sim->status &= ~STORAGE_Status_Not_Initialized;
+                return STORAGE_Result_Ok;
+
+            case CTRL_POWER_STATUS:
+                Sub[1] = !(sim->status & STORAGE_Status_Not_Initialized);
+                return STORAGE_Result_Ok;
+
+            default:
+                return STORAGE_Result_InvalidParameter;
+        }
+    }
+
+    if (sim->status & STORAGE_Status_Not_Initialized)
+    {
+        return STORAGE_Result_NotReady;
+    }
+
+    switch (cmd)
+    {
+        case CTRL_SYNC:
+            return msync (sim->image, (size_t) sim->sectors
+                                        * STORAGE_SectorSize, MS_SYNC)
+                        ? STORAGE_Result_ReadWriteError : STORAGE_Result_Ok;
+
+        case GET_SECTOR_COUNT:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint32_t *) buf = sim->sectors;
+            return STORAGE_Result_Ok;
+
+        case GET_SECTOR_SIZE:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint16_t *) buf = STORAGE_SectorSize;
+            return STORAGE_Result_Ok;
+
+        case GET_BLOCK_SIZE:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint32_t *) buf = sim->config.eraseBlock?
+                                                sim->config.eraseBlock : 1;
+            return STORAGE_Result_Ok;
+
+        case CTRL_TRIM:
+        {
+            // buf: first and last sector, inclusive (FatFs convention).
+            const uint32_t *const Range = (const uint32_t *) buf;
+            if (!Range || Range[0] > Range[1] || Range[1] >= sim->sectors)
+            {
+                break;
+            }
+            memset (&sim->image[Range[0] * STORAGE_SectorSize], 0xFF,
+                    (Range[1] - Range[0] + 1) * STORAGE_SectorSize);
+            return STORAGE_Result_Ok;
+        }
+
+        default:
+            break;
+    }
+
+    return STORAGE_Result_InvalidParameter;
+}
+
+
+bool STORAGE_SIMFILE_Init (struct STORAGE_SIMFILE *sim, const char *path,
+                           uint32_t sectors,
+                           const struct STORAGE_SIMFILE_Config *config,
+                           struct STORAGE_Device *device)
+{
+    if (!sim || !path || !device)
+    {
+        return false;
+    }
+
+    memset (sim, 0, sizeof(struct STORAGE_SIMFILE));
+    sim->fd = -1;
+
+    if (config)
+    {
+        sim->config = *config;
+    }
+
+    sim->rng = sim->config.seed? sim->config.seed : 0x2545F491u;
+
+    sim->fd = open (path, O_RDWR | O_CREAT, 0644);
+    if (sim->fd == -1)
+    {
+        return false;
+    }
+
+    if (sectors)
+    {
+        if (ftruncate (sim->fd, (off_t) sectors * STORAGE_SectorSize) == -1)
+        {
+            STORAGE_SIMFILE_Close (sim);
+            return false;
+        }
+    }
+    else
+    {
+        struct stat st;
+        if (fstat (sim->fd, &st) == -1)
+        {
+            STORAGE_SIMFILE_Close (sim);
+            return false;
+        }
+        sectors = (uint32_t) (st.st_size / STORAGE_SectorSize);
+    }
+
+    if (!sectors)
+    {
+        STORAGE_SIMFILE_Close (sim);
+        return false;
+    }
+
+    void *const Image = mmap (NULL, (size_t) sectors * STORAGE_SectorSize,
+                              PROT_READ | PROT_WRITE, MAP_SHARED, sim->fd, 0);
+    if (Image == MAP_FAILED)
+    {
+        STORAGE_SIMFILE_Close (sim);
+        return false;
+    }
+
+    sim->image      = (uint8_t *) Image;
+    sim->sectors    = sectors;
+    sim->status     = sim->config.writeProtected?
+                                        STORAGE_Status_Write_Protected : 0;
+
+    device->handler = sim;
+    device->read    = simRead;
+    device->write   = simWrite;
+    device->ioctl   = simIoCtl;
+
+    return true;
+}
+
+
+void STORAGE_SIMFILE_Close (struct STORAGE_SIMFILE *sim)
+{
+    if (!sim)
+    {
+        return;
+    }
+
+    if (sim->image)
+    {
+        msync   (sim->image, (size_t) sim->sectors * STORAGE_SectorSize,
+                 MS_SYNC);
+        munmap  (sim->image, (size_t) sim->sectors * STORAGE_SectorSize);
+        sim->image = NULL;
+    }
+
+    if (sim->fd != -1)
+    {
+        close (sim->fd);
+        sim->fd = -1;
+    }
+
+    sim->status = STORAGE_Status_Not_Initialized | STORAGE_Status_No_Disk;
+}
+
+
+STORAGE_Status STORAGE_SIMFILE_Status (struct STORAGE_SIMFILE *sim)
+{
+    return sim? sim->status : STORAGE_Status_Not_Initialized;
+}
@@ -0,0 +1,103 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Host file-backed storage device simulator.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "../misc.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+
+// Disk image file mapped to a STORAGE_Device, for running storage code on a
+// development host. Each operation can be delayed and can fail at random
+// with a configurable rate, so fault paths (STORAGE_Result_ReadWriteError,
+// STORAGE_Result_Timeout) and throughput can be exercised without a card.
+//
+// Host only (POSIX mmap); not part of the target build. See simbench.c.
+
+
+// Rates are given in failures per million operations.
+#define STORAGE_SIMFILE_RatePpm     1000000u
+
+
+struct STORAGE_SIMFILE_Config
+{
+    // Fixed cost of every read or write, plus a cost per sector moved.
+    uint32_t        readLatency_us;
+    uint32_t        writeLatency_us;
+    uint32_t        sectorLatency_us;
+    // Failed operations return STORAGE_Result_ReadWriteError. A failed
+    // write stores a random prefix of the request, like a torn write.
+    uint32_t        errorPpm;
+    // Timed out operations wait timeout_us, transfer nothing and return
+    // STORAGE_Result_Timeout.
+    uint32_t        timeoutPpm;
+    uint32_t        timeout_us;
+    // Erase block size reported by GET_BLOCK_SIZE, in sectors.
+    uint32_t        eraseBlock;
+    // Seed for the fault injection generator; same seed, same faults.
+    uint32_t        seed;
+    bool            writeProtected;
+};
+
+
+struct STORAGE_SIMFILE
+{
+    int                             fd;
+    uint8_t                         *image;
+    uint32_t                        sectors;
+    STORAGE_Status                  status;
+    struct STORAGE_SIMFILE_Config   config;
+    uint32_t                        rng;
+    // FYI only
+    uint32_t                        reads;
+    uint32_t                        writes;
+    uint32_t                        sectorsRead;
+    uint32_t                        sectorsWritten;
+    uint32_t                        injectedErrors;
+    uint32_t                        injectedTimeouts;
+    uint64_t                        busy_us;
+};
+
+
+// Maps the image at path. If sectors is not zero the file is created or
+// resized to that many sectors, otherwise its current size is used. config
+// may be NULL for an ideal device (no latency, no faults).
+bool            STORAGE_SIMFILE_Init    (struct STORAGE_SIMFILE *sim,
+                                         const char *path, uint32_t sectors,
+                                         const struct STORAGE_SIMFILE_Config
+                                                                    *config,
+                                         struct STORAGE_Device *device);
+void            STORAGE_SIMFILE_Close   (struct STORAGE_SIMFILE *sim);
+STORAGE_Status  STORAGE_SIMFILE_Status  (struct STORAGE_SIMFILE *sim);
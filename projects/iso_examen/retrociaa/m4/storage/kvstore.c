@@ -0,0 +1,1039 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Internal flash key/value store.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "kvstore.h"
+#include "../base/crc.h"
+#include "chip.h"
+#include <stddef.h>
+#include <string.h>
+
+
+#define KVSTORE_Magic               0x564B5652u     // "RVKV"
+#define KVSTORE_BankA               0x1A000000u
+#define KVSTORE_BankB               0x1B000000u
+#define KVSTORE_SmallSectorSize     0x2000u
+#define KVSTORE_LargeSectorSize     0x10000u
+#define KVSTORE_SmallSectors        8
+#define KVSTORE_Sectors             15
+#define KVSTORE_NoSegment           0xFF
+// Index slot given up by garbage collection; lookups probe past it.
+#define KVSTORE_SlotRemoved         1u
+#define KVSTORE_EntryDeleted        0x01
+#define KVSTORE_Erased              0xFF
+// Segments kept erased for garbage collection to copy into.
+#define KVSTORE_ReserveSegments     1
+
+
+struct SegmentHeader
+{
+    uint32_t    magic;
+    uint32_t    sequence;
+    uint32_t    eraseCount;
+    uint32_t    crc;
+};
+
+
+// Followed by the key (not terminated) and the value, padded to 4 bytes.
+struct Entry
+{
+    // Covers keySize, flags, valueSize, key and value.
+    uint32_t    crc;
+    uint8_t     keySize;
+    uint8_t     flags;
+    uint16_t    valueSize;
+};
+
+
+static OS_Ticks msToTicks (uint32_t ms)
+{
+    const OS_Ticks Ticks = ((OS_Ticks) ms * 1000) / OS_GetTickPeriod_us ();
+    return Ticks? Ticks : 1;
+}
+
+
+// FNV-1a
+static uint32_t keyHash (const char *key, uint32_t keySize)
+{
+    uint32_t hash = 0x811C9DC5u;
+    while (keySize --)
+    {
+        hash = (hash ^ (uint8_t) *key ++) * 0x01000193u;
+    }
+    return hash;
+}
+
+
+static uint32_t entrySpan (uint32_t keySize, uint32_t valueSize)
+{
+    const uint32_t Size = KVSTORE_EntryHeaderSize + keySize + valueSize;
+    return Size + ATTR_RoundTo4 (Size);
+}
+
+
+static const char * entryKey (const struct Entry *e)
+{
+    return (const char *) &e[1];
+}
+
+
+static const uint8_t * entryValue (const struct Entry *e)
+{
+    return (const uint8_t *) &e[1] + e->keySize;
+}
+
+
+static uint32_t entryCrc (const struct Entry *e)
+{
+    return CRC_32 (0, &e->keySize, KVSTORE_EntryHeaderSize
+                                    - offsetof(struct Entry, keySize)
+                                    + e->keySize + e->valueSize);
+}
+
+
+static bool entryIsKey (const struct Entry *e, const char *key,
+                        uint32_t keySize)
+{
+    return e->keySize == keySize && !memcmp (entryKey (e), key, keySize);
+}
+
+
+// Entry at offset in a page; NULL at the end of the entries.
+static const struct Entry * entryAt (const uint8_t *page, uint32_t offset)
+{
+    if (offset + KVSTORE_EntryHeaderSize > KVSTORE_PageSize)
+    {
+        return NULL;
+    }
+
+    const struct Entry *e = (const struct Entry *) &page[offset];
+
+    if (!e->keySize || e->keySize > KVSTORE_MaxKeySize
+            || offset + entrySpan (e->keySize, e->valueSize)
+                                                    > KVSTORE_PageSize)
+    {
+        return NULL;
+    }
+
+    return e;
+}
+
+
+static uint32_t segmentAddr (struct KVSTORE *kv, uint32_t segment)
+{
+    return kv->base + segment * kv->segmentSize;
+}
+
+
+static uint32_t pageAddr (struct KVSTORE *kv, uint32_t segment,
+                          uint32_t page)
+{
+    return segmentAddr (kv, segment) + page * KVSTORE_PageSize;
+}
+
+
+static struct KVSTORE_Segment * segmentOf (struct KVSTORE *kv, uint32_t addr)
+{
+    return &kv->segment[(addr - kv->base) / kv->segmentSize];
+}
+
+
+static bool pageBlank (struct KVSTORE *kv, uint32_t segment, uint32_t page)
+{
+    const uint32_t *p = (const uint32_t *) pageAddr (kv, segment, page);
+
+    for (uint32_t i = 0; i < KVSTORE_PageSize / 4; ++ i)
+    {
+        if (p[i] != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Slot holding key, NULL if none. Lock must be held.
+static struct KVSTORE_IndexSlot * indexFind (struct KVSTORE *kv,
+                                             const char *key,
+                                             uint32_t keySize,
+                                             uint32_t hash)
+{
+    for (uint32_t i = 0; i < KVSTORE_INDEX_SLOTS; ++ i)
+    {
+        struct KVSTORE_IndexSlot *slot =
+                    &kv->index[(hash + i) & (KVSTORE_INDEX_SLOTS - 1)];
+
+        if (!slot->addr)
+        {
+            break;
+        }
+
+        if (slot->addr != KVSTORE_SlotRemoved && slot->hash == hash
+                && entryIsKey ((const struct Entry *) slot->addr, key,
+                               keySize))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+
+// Makes the entry programmed at addr the newest one for its key. Lock must
+// be held.
+static void indexPut (struct KVSTORE *kv, uint32_t addr)
+{
+    const struct Entry *e   = (const struct Entry *) addr;
+    const uint32_t Hash     = keyHash (entryKey (e), e->keySize);
+    const uint32_t Span     = entrySpan (e->keySize, e->valueSize);
+
+    struct KVSTORE_IndexSlot *slot = indexFind (kv, entryKey (e),
+                                                e->keySize, Hash);
+    if (slot)
+    {
+        const struct Entry *old = (const struct Entry *) slot->addr;
+        segmentOf(kv, slot->addr)->liveBytes -= entrySpan (old->keySize,
+                                                           old->valueSize);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < KVSTORE_INDEX_SLOTS; ++ i)
+        {
+            struct KVSTORE_IndexSlot *s =
+                    &kv->index[(Hash + i) & (KVSTORE_INDEX_SLOTS - 1)];
+
+            if (!s->addr || s->addr == KVSTORE_SlotRemoved)
+            {
+                slot = s;
+                break;
+            }
+        }
+
+        if (!slot)
+        {
+            // KVSTORE_Set() keeps the index from filling up; only a store
+            // written with a larger index gets here.
+            ++ kv->entriesCorrupted;
+            return;
+        }
+
+        ++ kv->indexUsed;
+    }
+
+    slot->hash  = Hash;
+    slot->addr  = addr;
+    segmentOf(kv, addr)->liveBytes += Span;
+}
+
+
+static void indexRemove (struct KVSTORE *kv, struct KVSTORE_IndexSlot *slot)
+{
+    const struct Entry *e = (const struct Entry *) slot->addr;
+    segmentOf(kv, slot->addr)->liveBytes -= entrySpan (e->keySize,
+                                                       e->valueSize);
+    slot->addr = KVSTORE_SlotRemoved;
+    -- kv->indexUsed;
+}
+
+
+// Adds the valid entries of a programmed page to the index.
+static void indexPage (struct KVSTORE *kv, uint32_t segment, uint32_t page)
+{
+    const uint8_t *p = (const uint8_t *) pageAddr (kv, segment, page);
+    uint32_t offset = 0;
+    const struct Entry *e;
+
+    while ((e = entryAt (p, offset)))
+    {
+        if (e->crc != entryCrc (e))
+        {
+            // Page programming interrupted by a reset; the rest of the page
+            // cannot be trusted.
+            ++ kv->entriesCorrupted;
+            break;
+        }
+
+        indexPut (kv, (uint32_t) e);
+        offset += entrySpan (e->keySize, e->valueSize);
+    }
+}
+
+
+// Newest entry queued in a RAM page for key.
+static const struct Entry * pageFind (const uint32_t *page, uint32_t used,
+                                      const char *key, uint32_t keySize)
+{
+    const struct Entry *found = NULL;
+    uint32_t offset = 0;
+    const struct Entry *e;
+
+    while (offset < used && (e = entryAt ((const uint8_t *) page, offset)))
+    {
+        if (entryIsKey (e, key, keySize))
+        {
+            found = e;
+        }
+        offset += entrySpan (e->keySize, e->valueSize);
+    }
+
+    return found;
+}
+
+
+// Newest entry for key, queued or programmed. Lock must be held.
+static const struct Entry * find (struct KVSTORE *kv, const char *key,
+                                  uint32_t keySize)
+{
+    const struct Entry *e = pageFind (kv->fill, kv->fillUsed, key, keySize);
+    if (!e)
+    {
+        e = pageFind (kv->program, kv->programUsed, key, keySize);
+    }
+
+    if (!e)
+    {
+        const struct KVSTORE_IndexSlot *slot = indexFind (kv, key, keySize,
+                                                keyHash (key, keySize));
+        if (slot)
+        {
+            e = (const struct Entry *) slot->addr;
+        }
+    }
+
+    return e;
+}
+
+
+// OS_MUTEX_Lock() does not block: it returns OS_Result_Retry while another
+// task holds the lock. The scheduler retries it until it is taken.
+static enum OS_Result lock (struct KVSTORE *kv)
+{
+    return OS_TaskWaitForSignal (OS_TaskSignalType_MutexLock, &kv->lock,
+                                 OS_WaitForever);
+}
+
+
+// The bank cannot be read while IAP programs or erases it, and lookups read
+// entries straight from flash. IAP calls are made holding the lock so
+// KVSTORE_Get() and KVSTORE_Set() wait for them to finish.
+static bool flashProgram (struct KVSTORE *kv, uint32_t segment, uint32_t page,
+                          uint32_t *src)
+{
+    const uint32_t Sector = kv->firstSector + segment;
+
+    if (lock (kv) != OS_Result_OK)
+    {
+        ++ kv->flashErrors;
+        return false;
+    }
+
+    const bool Ok = Chip_IAP_PreSectorForReadWrite (Sector, Sector, kv->bank)
+                                                        == IAP_CMD_SUCCESS
+                    && Chip_IAP_CopyRamToFlash (pageAddr (kv, segment, page),
+                                    src, KVSTORE_PageSize) == IAP_CMD_SUCCESS;
+
+    OS_MUTEX_Unlock (&kv->lock);
+
+    if (!Ok)
+    {
+        ++ kv->flashErrors;
+    }
+
+    return Ok;
+}
+
+
+// Erases a segment and writes its header, making it the newest free one.
+static bool segmentErase (struct KVSTORE *kv, uint32_t segment)
+{
+    struct KVSTORE_Segment *s   = &kv->segment[segment];
+    const uint32_t Sector       = kv->firstSector + segment;
+
+    s->nextPage = 0;
+
+    // See flashProgram().
+    if (lock (kv) != OS_Result_OK)
+    {
+        ++ kv->flashErrors;
+        return false;
+    }
+
+    const bool Ok = Chip_IAP_PreSectorForReadWrite (Sector, Sector, kv->bank)
+                                                        == IAP_CMD_SUCCESS
+                    && Chip_IAP_EraseSector (Sector, Sector, kv->bank)
+                                                        == IAP_CMD_SUCCESS;
+
+    OS_MUTEX_Unlock (&kv->lock);
+
+    if (!Ok)
+    {
+        ++ kv->flashErrors;
+        return false;
+    }
+
+    ++ s->eraseCount;
+    ++ kv->segmentsErased;
+
+    s->sequence     = ++ kv->sequence;
+    s->usedBytes    = 0;
+    s->liveBytes    = 0;
+
+    // collect is free whenever a segment is erased.
+    struct SegmentHeader *h = (struct SegmentHeader *) kv->collect;
+
+    memset (kv->collect, KVSTORE_Erased, sizeof(kv->collect));
+    h->magic        = KVSTORE_Magic;
+    h->sequence     = s->sequence;
+    h->eraseCount   = s->eraseCount;
+    h->crc          = CRC_32 (0, h, offsetof(struct SegmentHeader, crc));
+
+    if (!flashProgram (kv, segment, 0, kv->collect))
+    {
+        return false;
+    }
+
+    s->nextPage = 1;
+    return true;
+}
+
+
+static bool segmentFree (struct KVSTORE *kv, uint32_t segment)
+{
+    return segment != kv->active && kv->segment[segment].nextPage == 1;
+}
+
+
+static uint32_t freeSegments (struct KVSTORE *kv)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < kv->segments; ++ i)
+    {
+        count += segmentFree (kv, i)? 1 : 0;
+    }
+    return count;
+}
+
+
+// Programs a page at the end of the active segment, taking the oldest free
+// segment when it is full. reserve: free segments that must be left.
+static enum OS_Result pageProgram (struct KVSTORE *kv, uint32_t *page,
+                                   uint32_t reserve)
+{
+    if (kv->active == KVSTORE_NoSegment
+            || kv->segment[kv->active].nextPage >= kv->pagesPerSegment)
+    {
+        if (freeSegments (kv) <= reserve)
+        {
+            return OS_Result_BufferFull;
+        }
+
+        uint32_t next = KVSTORE_NoSegment;
+        for (uint32_t i = 0; i < kv->segments; ++ i)
+        {
+            if (segmentFree (kv, i) && (next == KVSTORE_NoSegment
+                    || kv->segment[i].sequence < kv->segment[next].sequence))
+            {
+                next = i;
+            }
+        }
+
+        kv->active = next;
+    }
+
+    struct KVSTORE_Segment *s = &kv->segment[kv->active];
+    const uint32_t Page = s->nextPage ++;
+
+    // A failed page is skipped; it may be partially programmed.
+    if (!flashProgram (kv, kv->active, Page, page))
+    {
+        return OS_Result_Error;
+    }
+
+    s->usedBytes += KVSTORE_PageSize;
+    ++ kv->pagesProgrammed;
+
+    if (lock (kv) != OS_Result_OK)
+    {
+        return OS_Result_Error;
+    }
+
+    indexPage       (kv, kv->active, Page);
+    OS_MUTEX_Unlock (&kv->lock);
+
+    return OS_Result_OK;
+}
+
+
+// Copies the live entries of one segment to the active one and erases it.
+// Returns OS_Result_Empty if no segment is worth collecting.
+static enum OS_Result collect (struct KVSTORE *kv)
+{
+    uint32_t victim     = KVSTORE_NoSegment;
+    uint32_t coldest    = KVSTORE_NoSegment;
+    uint32_t oldest     = KVSTORE_NoSegment;
+    uint32_t maxErase   = 0;
+
+    for (uint32_t i = 0; i < kv->segments; ++ i)
+    {
+        const struct KVSTORE_Segment *s = &kv->segment[i];
+
+        if (s->eraseCount > maxErase)
+        {
+            maxErase = s->eraseCount;
+        }
+
+        if (i == kv->active || s->nextPage <= 1)
+        {
+            continue;
+        }
+
+        if (oldest == KVSTORE_NoSegment
+                || s->sequence < kv->segment[oldest].sequence)
+        {
+            oldest = i;
+        }
+
+        if (coldest == KVSTORE_NoSegment
+                || s->eraseCount < kv->segment[coldest].eraseCount)
+        {
+            coldest = i;
+        }
+
+        const uint32_t Dead = s->usedBytes - s->liveBytes;
+        if (Dead && (victim == KVSTORE_NoSegment
+                || Dead > kv->segment[victim].usedBytes
+                                        - kv->segment[victim].liveBytes
+                || (Dead == kv->segment[victim].usedBytes
+                                        - kv->segment[victim].liveBytes
+                    && s->eraseCount < kv->segment[victim].eraseCount)))
+        {
+            victim = i;
+        }
+    }
+
+    if (coldest != KVSTORE_NoSegment
+            && maxErase - kv->segment[coldest].eraseCount > KVSTORE_WEAR_DELTA)
+    {
+        victim = coldest;
+    }
+
+    if (victim == KVSTORE_NoSegment)
+    {
+        return OS_Result_Empty;
+    }
+
+    const struct KVSTORE_Segment *v = &kv->segment[victim];
+    uint32_t used = 0;
+    enum OS_Result r;
+
+    memset (kv->collect, KVSTORE_Erased, sizeof(kv->collect));
+
+    for (uint32_t page = 1; page < v->nextPage; ++ page)
+    {
+        const uint8_t *p = (const uint8_t *) pageAddr (kv, victim, page);
+        uint32_t offset = 0;
+        const struct Entry *e;
+
+        while ((e = entryAt (p, offset)))
+        {
+            if (e->crc != entryCrc (e))
+            {
+                break;
+            }
+
+            const uint32_t Span = entrySpan (e->keySize, e->valueSize);
+            offset += Span;
+
+            if ((r = lock (kv)) != OS_Result_OK)
+            {
+                return r;
+            }
+
+            struct KVSTORE_IndexSlot *slot = indexFind (kv, entryKey (e),
+                                    e->keySize,
+                                    keyHash (entryKey (e), e->keySize));
+
+            bool live = (slot && slot->addr == (uint32_t) e);
+
+            // Nothing older is left for a delete to hide.
+            if (live && victim == oldest && (e->flags & KVSTORE_EntryDeleted))
+            {
+                indexRemove (kv, slot);
+                live = false;
+            }
+
+            OS_MUTEX_Unlock (&kv->lock);
+
+            if (!live)
+            {
+                continue;
+            }
+
+            if (used + Span > KVSTORE_PageSize)
+            {
+                if ((r = pageProgram (kv, kv->collect, 0)) != OS_Result_OK)
+                {
+                    return r;
+                }
+
+                memset (kv->collect, KVSTORE_Erased, sizeof(kv->collect));
+                used = 0;
+            }
+
+            memcpy ((uint8_t *) kv->collect + used, e, Span);
+            used += Span;
+            ++ kv->entriesCollected;
+        }
+    }
+
+    if (used && (r = pageProgram (kv, kv->collect, 0)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    return segmentErase (kv, victim)? OS_Result_OK : OS_Result_Error;
+}
+
+
+// Erases segments left without a valid header (never used, or an erase
+// interrupted by a reset).
+static void eraseInvalid (struct KVSTORE *kv)
+{
+    for (uint32_t i = 0; i < kv->segments; ++ i)
+    {
+        if (!kv->segment[i].nextPage)
+        {
+            segmentErase (kv, i);
+        }
+    }
+}
+
+
+// Queued entries move from fill to program, where the task programs them.
+// Lock must be held.
+static void fillSwap (struct KVSTORE *kv)
+{
+    memcpy (kv->program, kv->fill, sizeof(kv->program));
+    kv->programUsed     = kv->fillUsed;
+    kv->programNewKeys  = kv->fillNewKeys;
+
+    memset (kv->fill, KVSTORE_Erased, sizeof(kv->fill));
+    kv->fillUsed        = 0;
+    kv->fillNewKeys     = 0;
+}
+
+
+static enum OS_Result queue (struct KVSTORE *kv, const char *key,
+                             const void *value, uint32_t size, uint8_t flags)
+{
+    const uint32_t KeySize = key? strlen (key) : 0;
+
+    if (!kv || !KeySize || KeySize > KVSTORE_MaxKeySize
+            || size > KVSTORE_MaxValueSize || (size && !value))
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    const uint32_t Span = entrySpan (KeySize, size);
+    enum OS_Result r;
+
+    if ((r = lock (kv)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    const bool NewKey = !find (kv, key, KeySize);
+
+    // Keeps the index at most 3/4 full so probes stay short.
+    if (NewKey && kv->indexUsed + kv->fillNewKeys + kv->programNewKeys
+                                        >= KVSTORE_INDEX_SLOTS * 3 / 4)
+    {
+        r = OS_Result_BufferFull;
+    }
+    else if (kv->fillUsed + Span > KVSTORE_PageSize)
+    {
+        if (kv->programUsed)
+        {
+            // Both pages waiting for the task.
+            r = OS_Result_Retry;
+        }
+        else
+        {
+            fillSwap (kv);
+            SEMAPHORE_Release (&kv->work);
+        }
+    }
+
+    if (r == OS_Result_OK)
+    {
+        struct Entry *e = (struct Entry *) ((uint8_t *) kv->fill
+                                                        + kv->fillUsed);
+        e->keySize      = KeySize;
+        e->flags        = flags;
+        e->valueSize    = size;
+        memcpy ((char *) entryKey (e), key, KeySize);
+        memcpy ((uint8_t *) entryValue (e), value, size);
+        e->crc          = entryCrc (e);
+
+        kv->fillUsed    += Span;
+        kv->fillNewKeys += NewKey? 1 : 0;
+    }
+
+    OS_MUTEX_Unlock (&kv->lock);
+    return r;
+}
+
+
+// Rebuilds the RAM state from flash. Segments that need an erase are left
+// to the task.
+enum OS_Result KVSTORE_Init (struct KVSTORE *kv,
+                             const struct KVSTORE_InitParams *params)
+{
+    if (!kv || !params || params->bank > 1 || !params->segments
+            || params->segments > KVSTORE_MAX_SEGMENTS
+            || params->firstSector + params->segments > KVSTORE_Sectors
+            || (params->firstSector < KVSTORE_SmallSectors
+                && params->firstSector + params->segments
+                                                > KVSTORE_SmallSectors))
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    memset (kv, 0, sizeof(struct KVSTORE));
+
+    OS_MUTEX_Init   (&kv->lock);
+    SEMAPHORE_Init  (&kv->work, 1, 0);
+
+    kv->bank        = params->bank;
+    kv->firstSector = params->firstSector;
+    kv->segments    = params->segments;
+    kv->active      = KVSTORE_NoSegment;
+    kv->lastResult  = OS_Result_OK;
+
+    const uint32_t Bank = params->bank? KVSTORE_BankB : KVSTORE_BankA;
+
+    if (params->firstSector < KVSTORE_SmallSectors)
+    {
+        kv->base        = Bank + params->firstSector
+                                            * KVSTORE_SmallSectorSize;
+        kv->segmentSize = KVSTORE_SmallSectorSize;
+    }
+    else
+    {
+        kv->base        = Bank + KVSTORE_SmallSectors
+                                            * KVSTORE_SmallSectorSize
+                            + (params->firstSector - KVSTORE_SmallSectors)
+                                            * KVSTORE_LargeSectorSize;
+        kv->segmentSize = KVSTORE_LargeSectorSize;
+    }
+
+    kv->pagesPerSegment = kv->segmentSize / KVSTORE_PageSize;
+
+    memset (kv->fill,       KVSTORE_Erased, sizeof(kv->fill));
+    memset (kv->program,    KVSTORE_Erased, sizeof(kv->program));
+    memset (kv->collect,    KVSTORE_Erased, sizeof(kv->collect));
+
+    if (Chip_IAP_Init () != IAP_CMD_SUCCESS)
+    {
+        return OS_Result_Error;
+    }
+
+    uint8_t order[KVSTORE_MAX_SEGMENTS];
+    uint32_t valid      = 0;
+    uint32_t maxErase   = 0;
+
+    for (uint32_t i = 0; i < kv->segments; ++ i)
+    {
+        const struct SegmentHeader *h = (const struct SegmentHeader *)
+                                                    segmentAddr (kv, i);
+
+        if (h->magic != KVSTORE_Magic || h->crc != CRC_32 (0, h,
+                                    offsetof(struct SegmentHeader, crc)))
+        {
+            continue;
+        }
+
+        kv->segment[i].sequence     = h->sequence;
+        kv->segment[i].eraseCount   = h->eraseCount;
+
+        if (h->sequence > kv->sequence)
+        {
+            kv->sequence = h->sequence;
+        }
+
+        if (h->eraseCount > maxErase)
+        {
+            maxErase = h->eraseCount;
+        }
+
+        // Sorted by sequence: newer entries override older ones.
+        uint32_t at = valid ++;
+        while (at && kv->segment[order[at - 1]].sequence > h->sequence)
+        {
+            order[at] = order[at - 1];
+            -- at;
+        }
+        order[at] = i;
+    }
+
+    for (uint32_t i = 0; i < valid; ++ i)
+    {
+        const uint32_t Segment = order[i];
+        struct KVSTORE_Segment *s = &kv->segment[Segment];
+
+        s->nextPage = 1;
+
+        for (uint32_t page = 1; page < kv->pagesPerSegment; ++ page)
+        {
+            if (!pageBlank (kv, Segment, page))
+            {
+                indexPage (kv, Segment, page);
+                s->nextPage = page + 1;
+            }
+        }
+
+        s->usedBytes = (s->nextPage - 1) * KVSTORE_PageSize;
+
+        if (s->nextPage > 1)
+        {
+            kv->active = Segment;
+        }
+    }
+
+    // Wear of unreadable segments is unknown; assume the worst seen.
+    for (uint32_t i = 0; i < kv->segments; ++ i)
+    {
+        if (!kv->segment[i].nextPage)
+        {
+            kv->segment[i].eraseCount = maxErase;
+        }
+    }
+
+    return OS_Result_OK;
+}
+
+
+// Copies the value of key into buf. Returns OS_Result_Empty if the key is
+// not set or OS_Result_InvalidBufferSize if buf is too small; *size is the
+// value size in both the success and the buffer size error cases.
+enum OS_Result KVSTORE_Get (struct KVSTORE *kv, const char *key, void *buf,
+                            uint32_t bufSize, uint32_t *size)
+{
+    const uint32_t KeySize = key? strlen (key) : 0;
+
+    if (!kv || !KeySize || KeySize > KVSTORE_MaxKeySize || (bufSize && !buf))
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (kv)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    r = OS_Result_Empty;
+
+    const struct Entry *e = find (kv, key, KeySize);
+
+    if (e && !(e->flags & KVSTORE_EntryDeleted))
+    {
+        if (size)
+        {
+            *size = e->valueSize;
+        }
+
+        if (e->valueSize > bufSize)
+        {
+            r = OS_Result_InvalidBufferSize;
+        }
+        else
+        {
+            memcpy (buf, entryValue (e), e->valueSize);
+            r = OS_Result_OK;
+        }
+    }
+
+    OS_MUTEX_Unlock (&kv->lock);
+    return r;
+}
+
+
+// Queues a new value for key. Returns OS_Result_Retry while the task is
+// busy with two pages of queued entries, OS_Result_BufferFull if there is
+// no room for another key.
+enum OS_Result KVSTORE_Set (struct KVSTORE *kv, const char *key,
+                            const void *value, uint32_t size)
+{
+    return queue (kv, key, value, size, 0);
+}
+
+
+enum OS_Result KVSTORE_Delete (struct KVSTORE *kv, const char *key)
+{
+    return queue (kv, key, NULL, 0, KVSTORE_EntryDeleted);
+}
+
+
+// Waits until every queued entry is programmed.
+enum OS_Result KVSTORE_Sync (struct KVSTORE *kv)
+{
+    if (!kv)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (kv)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    kv->syncRequest = true;
+    kv->lastResult  = OS_Result_OK;
+    OS_MUTEX_Unlock (&kv->lock);
+
+    SEMAPHORE_Release (&kv->work);
+
+    while (1)
+    {
+        if ((r = lock (kv)) != OS_Result_OK)
+        {
+            return r;
+        }
+
+        const bool Done             = !kv->fillUsed && !kv->programUsed;
+        const enum OS_Result Result = kv->lastResult;
+        OS_MUTEX_Unlock (&kv->lock);
+
+        if (Done)
+        {
+            return OS_Result_OK;
+        }
+
+        if (Result != OS_Result_OK)
+        {
+            return Result;
+        }
+
+        OS_TaskDelay (1);
+    }
+}
+
+
+uint32_t KVSTORE_EraseCount (struct KVSTORE *kv, uint32_t segment)
+{
+    return (kv && segment < kv->segments)? kv->segment[segment].eraseCount
+                                         : 0;
+}
+
+
+// One pass of the flash writer task: erase, collect and program the queued
+// page if any.
+static void taskWork (struct KVSTORE *kv)
+{
+    eraseInvalid (kv);
+
+    while (freeSegments (kv) <= KVSTORE_ReserveSegments
+                && (kv->active == KVSTORE_NoSegment
+                    || kv->segment[kv->active].nextPage
+                                            >= kv->pagesPerSegment)
+                && collect (kv) == OS_Result_OK)
+    {
+    }
+
+    if (lock (kv) != OS_Result_OK)
+    {
+        return;
+    }
+
+    if (!kv->programUsed && kv->fillUsed)
+    {
+        fillSwap (kv);
+    }
+    if (!kv->programUsed)
+    {
+        kv->syncRequest = false;
+    }
+    OS_MUTEX_Unlock (&kv->lock);
+
+    if (!kv->programUsed)
+    {
+        return;
+    }
+
+    const enum OS_Result Result = pageProgram (kv, kv->program,
+                                               KVSTORE_ReserveSegments);
+
+    if (lock (kv) != OS_Result_OK)
+    {
+        return;
+    }
+
+    if (Result == OS_Result_OK)
+    {
+        memset (kv->program, KVSTORE_Erased, sizeof(kv->program));
+        kv->programUsed     = 0;
+        kv->programNewKeys  = 0;
+    }
+    else
+    {
+        // Retried after KVSTORE_FLUSH_MS, not in a loop.
+        kv->syncRequest = false;
+    }
+    kv->lastResult = Result;
+    OS_MUTEX_Unlock (&kv->lock);
+}
+
+
+OS_TaskRetVal KVSTORE_Task (OS_TaskParam arg)
+{
+    struct KVSTORE *kv = (struct KVSTORE *) arg;
+
+    while (1)
+    {
+        if (!kv->syncRequest)
+        {
+            OS_TaskWaitForSignal (OS_TaskSignalType_SemaphoreAcquire,
+                                  &kv->work, msToTicks (KVSTORE_FLUSH_MS));
+        }
+
+        taskWork (kv);
+    }
+
+    return 0;
+}
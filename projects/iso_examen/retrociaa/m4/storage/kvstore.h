@@ -0,0 +1,171 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Internal flash key/value store.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "../os/mutex.h"
+#include "../base/semaphore.h"
+#include <stdbool.h>
+
+
+// Key/value store for configuration and calibration data on internal flash
+// sectors, programmed through IAP.
+//
+// Each flash sector used is a segment. Page 0 of a segment holds its header
+// (erase count and sequence), written right after the erase; the other
+// pages are programmed once, in order, with packed entries. A new value or a
+// delete appends an entry and never rewrites the old one. Lookups go through
+// a RAM hash index of the newest entry for each key, rebuilt at boot by
+// scanning the segments in sequence order.
+//
+// KVSTORE_Set() and KVSTORE_Delete() only queue the entry in RAM; flash
+// erase and program run in KVSTORE_Task(), which must be started at a
+// priority below real-time tasks. Garbage collection copies the live entries
+// of the segment with the most dead data (or, to level wear, the least
+// erased one) to the current segment and erases it. Lookups wait while a
+// page is programmed or a segment erased, since the bank cannot be read
+// during IAP operations.
+//
+// Segments must not share a flash bank with the running code: bank A holds
+// the M4 image, bank B the M0 one if any.
+
+
+#ifndef KVSTORE_INDEX_SLOTS
+    #define KVSTORE_INDEX_SLOTS         128     // Power of two
+#endif
+
+#ifndef KVSTORE_MAX_SEGMENTS
+    #define KVSTORE_MAX_SEGMENTS        8
+#endif
+
+// Queued entries are programmed after this time even if the page is not
+// full.
+#ifndef KVSTORE_FLUSH_MS
+    #define KVSTORE_FLUSH_MS            500
+#endif
+
+// Erase count difference that makes garbage collection move the data of the
+// least erased segment (static wear leveling).
+#ifndef KVSTORE_WEAR_DELTA
+    #define KVSTORE_WEAR_DELTA          64
+#endif
+
+#define KVSTORE_PageSize                512
+#define KVSTORE_EntryHeaderSize         8
+#define KVSTORE_MaxKeySize              32
+#define KVSTORE_MaxValueSize            (KVSTORE_PageSize \
+                                            - KVSTORE_EntryHeaderSize \
+                                            - KVSTORE_MaxKeySize)
+
+
+struct KVSTORE_InitParams
+{
+    // Flash bank (0: A, 1: B) and sectors used. Sectors must be the same
+    // size: all in 0-7 (8 KiB) or all in 8-14 (64 KiB).
+    uint8_t             bank;
+    uint8_t             firstSector;
+    uint8_t             segments;
+};
+
+
+struct KVSTORE_IndexSlot
+{
+    uint32_t            hash;
+    // Flash address of the newest entry for the key (a tombstone if the key
+    // was deleted), 0 if the slot is empty.
+    uint32_t            addr;
+};
+
+
+struct KVSTORE_Segment
+{
+    uint32_t            sequence;
+    uint32_t            eraseCount;
+    // Next page to program; 0 if the segment needs an erase.
+    uint32_t            nextPage;
+    uint32_t            usedBytes;
+    uint32_t            liveBytes;
+};
+
+
+struct KVSTORE
+{
+    struct OS_MUTEX             lock;
+    struct SEMAPHORE            work;
+    uint32_t                    base;
+    uint32_t                    segmentSize;
+    uint32_t                    pagesPerSegment;
+    uint32_t                    sequence;
+    uint8_t                     bank;
+    uint8_t                     firstSector;
+    uint8_t                     segments;
+    uint8_t                     active;
+    struct KVSTORE_Segment      segment[KVSTORE_MAX_SEGMENTS];
+    struct KVSTORE_IndexSlot    index[KVSTORE_INDEX_SLOTS];
+    uint32_t                    indexUsed;
+    // Entries queued by Set/Delete (fill) and the page being programmed by
+    // the task (program). Both are searched by lookups.
+    uint32_t                    fill[KVSTORE_PageSize / 4];
+    uint32_t                    program[KVSTORE_PageSize / 4];
+    uint32_t                    collect[KVSTORE_PageSize / 4];
+    uint32_t                    fillUsed;
+    // Keys not in the index yet, counted against KVSTORE_INDEX_SLOTS.
+    uint32_t                    fillNewKeys;
+    uint32_t                    programUsed;
+    uint32_t                    programNewKeys;
+    // Set by KVSTORE_Sync(); the task programs queued entries without
+    // waiting for KVSTORE_FLUSH_MS and reports the outcome in lastResult.
+    bool                        syncRequest;
+    enum OS_Result              lastResult;
+    // FYI only
+    uint32_t                    pagesProgrammed;
+    uint32_t                    segmentsErased;
+    uint32_t                    entriesCollected;
+    uint32_t                    entriesCorrupted;
+    uint32_t                    flashErrors;
+};
+
+
+enum OS_Result  KVSTORE_Init        (struct KVSTORE *kv,
+                                     const struct KVSTORE_InitParams *params);
+enum OS_Result  KVSTORE_Get         (struct KVSTORE *kv, const char *key,
+                                     void *buf, uint32_t bufSize,
+                                     uint32_t *size);
+enum OS_Result  KVSTORE_Set         (struct KVSTORE *kv, const char *key,
+                                     const void *value, uint32_t size);
+enum OS_Result  KVSTORE_Delete      (struct KVSTORE *kv, const char *key);
+enum OS_Result  KVSTORE_Sync        (struct KVSTORE *kv);
+uint32_t        KVSTORE_EraseCount  (struct KVSTORE *kv, uint32_t segment);
+// Flash writer task function. arg: struct KVSTORE.
+OS_TaskRetVal   KVSTORE_Task        (OS_TaskParam arg);
@@ -76,3 +76,34 @@ enum STORAGE_Result
 #define CTRL_POWER_OFF      0
 #define CTRL_POWER_ON       1
 #define CTRL_POWER_STATUS   2
+
+
+#define STORAGE_SectorSize      512
+
+// Alignment for buffers given to the storage driver (see
+// MEMPOOL_BlockAligned). Sector multiple requests on aligned buffers go
+// straight to the device DMA without intermediate copies. LPC43xx DMA only
+// needs word alignment; 32 also matches a cache line on cores that have one.
+#define STORAGE_BufferAlign     32
+
+
+// Low level device access used by the RETRO-CIAA storage driver. Functions
+// follow disk_read(), disk_write() and disk_ioctl() FatFs semantics.
+typedef enum STORAGE_Result (*STORAGE_ReadFunc) (void *handler, uint8_t *buf,
+                                                 uint32_t sector,
+                                                 uint32_t count);
+typedef enum STORAGE_Result (*STORAGE_WriteFunc) (void *handler,
+                                                  const uint8_t *buf,
+                                                  uint32_t sector,
+                                                  uint32_t count);
+typedef enum STORAGE_Result (*STORAGE_IoCtlFunc) (void *handler, uint8_t cmd,
+                                                  void *buf);
+
+
+struct STORAGE_Device
+{
+    void                *handler;
+    STORAGE_ReadFunc    read;
+    STORAGE_WriteFunc   write;
+    STORAGE_IoCtlFunc   ioctl;
+};
@@ -0,0 +1,856 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Log-structured record store on raw storage sectors.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "reclog.h"
+#include "../base/crc.h"
+#include <stddef.h>
+#include <string.h>
+
+
+#define RECLOG_Magic                0x474F4C52u     // "RLOG"
+#define RECLOG_KindData             1
+#define RECLOG_KindCheckpoint       2
+#define RECLOG_CheckpointSectors    2
+#define RECLOG_PageCapacity         (STORAGE_SectorSize \
+                                        - RECLOG_SectorHeaderSize)
+// Free data sectors only RECLOG_Compact() may use, so repacking live
+// records never finds the ring full.
+#define RECLOG_CompactReserve       2
+
+
+struct SectorHeader
+{
+    uint32_t    magic;
+    uint32_t    sequence;
+    uint16_t    kind;
+    // Bytes following the header.
+    uint16_t    used;
+    // Data sectors: header only, records have their own. Checkpoints:
+    // header and payload.
+    uint32_t    crc;
+};
+
+
+struct RecordHeader
+{
+    uint32_t    id;
+    uint16_t    size;
+    uint16_t    type;
+    // Covers id, size, type and data.
+    uint32_t    crc;
+};
+
+
+struct Checkpoint
+{
+    struct SectorHeader header;
+    uint32_t            tail;
+    uint32_t            head;
+    uint32_t            nextId;
+    uint32_t            releasedId;
+};
+
+
+#define RECLOG_CheckpointPayload    (sizeof(struct Checkpoint) \
+                                        - sizeof(struct SectorHeader))
+
+
+// Sequence numbers and ids wrap around.
+static bool before (uint32_t a, uint32_t b)
+{
+    return (int32_t) (a - b) < 0;
+}
+
+
+static uint32_t sectorCrc (const uint32_t *page)
+{
+    const struct SectorHeader *h = (const struct SectorHeader *) page;
+
+    const uint32_t Crc = CRC_32 (0, h, offsetof(struct SectorHeader, crc));
+    return (h->kind == RECLOG_KindCheckpoint)
+                ? CRC_32 (Crc, &h[1], h->used) : Crc;
+}
+
+
+static uint32_t recordCrc (const struct RecordHeader *r)
+{
+    const uint32_t Crc = CRC_32 (0, r, offsetof(struct RecordHeader, crc));
+    return CRC_32 (Crc, &r[1], r->size);
+}
+
+
+static uint32_t recordSpan (uint32_t size)
+{
+    const uint32_t Size = RECLOG_RecordHeaderSize + size;
+    return Size + ATTR_RoundTo4 (Size);
+}
+
+
+static OS_Ticks msToTicks (uint32_t ms)
+{
+    const OS_Ticks Ticks = ((OS_Ticks) ms * 1000) / OS_GetTickPeriod_us ();
+    return Ticks? Ticks : 1;
+}
+
+
+// OS_MUTEX_Lock() does not block: it returns OS_Result_Retry while another
+// task holds the lock. The scheduler retries it until it is taken.
+static enum OS_Result lock (struct RECLOG *log)
+{
+    return OS_TaskWaitForSignal (OS_TaskSignalType_MutexLock, &log->lock,
+                                 OS_WaitForever);
+}
+
+
+static uint32_t dataIndex (struct RECLOG *log, uint32_t sequence)
+{
+    return RECLOG_CheckpointSectors + sequence % log->dataSectors;
+}
+
+
+// Free data sectors, counting the ones waiting for a checkpoint as used.
+static uint32_t freeSectors (struct RECLOG *log)
+{
+    return log->dataSectors - (log->head - log->durableTail);
+}
+
+
+static enum OS_Result sectorRead (struct RECLOG *log, uint32_t *page,
+                                  uint32_t index)
+{
+    return OS_TaskDriverStorage (log->driver, OS_TaskDriverOp_Read,
+                                 (uint8_t *) page, log->firstSector + index, 1);
+}
+
+
+// Writes and syncs so the sector is on the media, not in the driver cache,
+// when this returns.
+static enum OS_Result sectorWrite (struct RECLOG *log, uint32_t *page,
+                                   uint32_t index)
+{
+    const enum OS_Result Result = OS_TaskDriverStorage (log->driver,
+                                        OS_TaskDriverOp_Write,
+                                        (uint8_t *) page,
+                                        log->firstSector + index, 1);
+    if (Result != OS_Result_OK)
+    {
+        return Result;
+    }
+
+    return OS_TaskDriverStorage (log->driver, OS_TaskDriverOp_Sync, NULL,
+                                 0, 0);
+}
+
+
+static bool dataValid (const uint32_t *page, uint32_t sequence)
+{
+    const struct SectorHeader *h = (const struct SectorHeader *) page;
+
+    return h->magic == RECLOG_Magic && h->kind == RECLOG_KindData
+            && h->sequence == sequence && h->used <= RECLOG_PageCapacity
+            && h->crc == sectorCrc (page);
+}
+
+
+static bool checkpointValid (const uint32_t *page)
+{
+    const struct SectorHeader *h = (const struct SectorHeader *) page;
+
+    return h->magic == RECLOG_Magic && h->kind == RECLOG_KindCheckpoint
+            && h->used == RECLOG_CheckpointPayload
+            && h->crc == sectorCrc (page);
+}
+
+
+// Record at offset in a data sector; NULL past the last one or if damaged.
+static const struct RecordHeader * recordAt (const uint32_t *page,
+                                             uint32_t offset)
+{
+    const struct SectorHeader *h = (const struct SectorHeader *) page;
+    const uint32_t End = RECLOG_SectorHeaderSize + h->used;
+
+    if (offset + RECLOG_RecordHeaderSize > End)
+    {
+        return NULL;
+    }
+
+    const struct RecordHeader *r = (const struct RecordHeader *)
+                                        ((const uint8_t *) page + offset);
+
+    if (offset + RECLOG_RecordHeaderSize + r->size > End
+            || r->crc != recordCrc (r))
+    {
+        return NULL;
+    }
+
+    return r;
+}
+
+
+static enum OS_Result checkpointWrite (struct RECLOG *log)
+{
+    struct Checkpoint *cp = (struct Checkpoint *) log->scan;
+
+    memset (log->scan, 0, sizeof(log->scan));
+
+    cp->header.magic    = RECLOG_Magic;
+    cp->header.sequence = log->checkpointSequence + 1;
+    cp->header.kind     = RECLOG_KindCheckpoint;
+    cp->header.used     = RECLOG_CheckpointPayload;
+    cp->tail            = log->tail;
+    cp->head            = log->head;
+    cp->nextId          = log->nextId;
+    cp->releasedId      = log->releasedId;
+    cp->header.crc      = sectorCrc (log->scan);
+
+    // Alternates between both checkpoint sectors; a torn write leaves the
+    // previous checkpoint intact.
+    const enum OS_Result Result = sectorWrite (log, log->scan,
+                                               cp->header.sequence & 1);
+    if (Result != OS_Result_OK)
+    {
+        return Result;
+    }
+
+    log->checkpointSequence = cp->header.sequence;
+    log->durableTail        = cp->tail;
+    log->sinceCheckpoint    = 0;
+    ++ log->checkpointsWritten;
+    return OS_Result_OK;
+}
+
+
+// Appends the records in page as a new data sector, leaving at least
+// reserve data sectors free.
+static enum OS_Result pageWrite (struct RECLOG *log, uint32_t reserve)
+{
+    if (!log->pageUsed)
+    {
+        return OS_Result_OK;
+    }
+
+    enum OS_Result r;
+
+    if (freeSectors (log) <= reserve && log->tail != log->durableTail)
+    {
+        // Sectors reclaimed since the last checkpoint become reusable.
+        if ((r = checkpointWrite (log)) != OS_Result_OK)
+        {
+            return r;
+        }
+    }
+
+    if (freeSectors (log) <= reserve)
+    {
+        return OS_Result_BufferFull;
+    }
+
+    struct SectorHeader *h = (struct SectorHeader *) log->page;
+
+    h->magic    = RECLOG_Magic;
+    h->sequence = log->head;
+    h->kind     = RECLOG_KindData;
+    h->used     = log->pageUsed;
+    h->crc      = sectorCrc (log->page);
+
+    memset ((uint8_t *) log->page + RECLOG_SectorHeaderSize + log->pageUsed,
+            0, RECLOG_PageCapacity - log->pageUsed);
+
+    // On failure the records stay in page and the same sequence is written
+    // again by the next attempt.
+    if ((r = sectorWrite (log, log->page, dataIndex (log, log->head)))
+                                                            != OS_Result_OK)
+    {
+        return r;
+    }
+
+    ++ log->head;
+    ++ log->sectorsWritten;
+    log->pageUsed = 0;
+
+    if (++ log->sinceCheckpoint >= RECLOG_CHECKPOINT_INTERVAL)
+    {
+        return checkpointWrite (log);
+    }
+
+    return OS_Result_OK;
+}
+
+
+static void pagePut (struct RECLOG *log, uint32_t id, uint16_t type,
+                     const void *data, uint32_t size)
+{
+    uint8_t *const Dst = (uint8_t *) log->page + RECLOG_SectorHeaderSize
+                                                        + log->pageUsed;
+    struct RecordHeader *r  = (struct RecordHeader *) Dst;
+    const uint32_t Span     = recordSpan (size);
+
+    r->id   = id;
+    r->size = size;
+    r->type = type;
+    memcpy (&r[1], data, size);
+    memset (Dst + RECLOG_RecordHeaderSize + size, 0,
+            Span - RECLOG_RecordHeaderSize - size);
+    r->crc  = recordCrc (r);
+
+    log->pageUsed += Span;
+}
+
+
+// Bytes of live (not released, undamaged) records in a data sector.
+static uint32_t liveBytes (struct RECLOG *log, const uint32_t *page)
+{
+    uint32_t live = 0;
+    uint32_t offset = RECLOG_SectorHeaderSize;
+    const struct RecordHeader *r;
+
+    while ((r = recordAt (page, offset)))
+    {
+        if (!before (r->id, log->releasedId))
+        {
+            live += recordSpan (r->size);
+        }
+        offset += recordSpan (r->size);
+    }
+
+    return live;
+}
+
+
+static void init (struct RECLOG *log, const char *driver,
+                  uint32_t firstSector, uint32_t sectors)
+{
+    memset (log, 0, sizeof(struct RECLOG));
+    OS_MUTEX_Init (&log->lock);
+
+    log->driver         = driver;
+    log->firstSector    = firstSector;
+    log->dataSectors    = sectors - RECLOG_CheckpointSectors;
+}
+
+
+// Loads the newest checkpoint and scans the data sectors appended after it.
+static enum OS_Result mount (struct RECLOG *log)
+{
+    const struct Checkpoint *cp = (const struct Checkpoint *) log->scan;
+    bool found = false;
+    enum OS_Result r;
+
+    for (uint32_t i = 0; i < RECLOG_CheckpointSectors; ++ i)
+    {
+        if ((r = sectorRead (log, log->scan, i)) != OS_Result_OK)
+        {
+            return r;
+        }
+
+        if (!checkpointValid (log->scan) || (found
+                && before (cp->header.sequence, log->checkpointSequence)))
+        {
+            continue;
+        }
+
+        if (cp->head - cp->tail > log->dataSectors)
+        {
+            continue;
+        }
+
+        found                   = true;
+        log->checkpointSequence = cp->header.sequence;
+        log->tail               = cp->tail;
+        log->head               = cp->head;
+        log->nextId             = cp->nextId;
+        log->releasedId         = cp->releasedId;
+    }
+
+    if (!found)
+    {
+        return OS_Result_NotInitialized;
+    }
+
+    log->durableTail = log->tail;
+
+    while (log->head - log->tail < log->dataSectors)
+    {
+        if ((r = sectorRead (log, log->scan, dataIndex (log, log->head)))
+                                                            != OS_Result_OK)
+        {
+            return r;
+        }
+
+        if (!dataValid (log->scan, log->head))
+        {
+            break;
+        }
+
+        uint32_t offset = RECLOG_SectorHeaderSize;
+        const struct RecordHeader *rec;
+
+        while ((rec = recordAt (log->scan, offset)))
+        {
+            if (!before (rec->id, log->nextId))
+            {
+                log->nextId = rec->id + 1;
+            }
+            offset += recordSpan (rec->size);
+        }
+
+        const uint32_t End = RECLOG_SectorHeaderSize
+                        + ((const struct SectorHeader *) log->scan)->used;
+        if (offset < End)
+        {
+            ++ log->recordsCorrupted;
+        }
+
+        ++ log->head;
+        ++ log->mountScanned;
+    }
+
+    log->sinceCheckpoint = log->mountScanned;
+    return OS_Result_OK;
+}
+
+
+// Erases the log. Sequence numbers continue past any log found in the same
+// sectors so none of its data sectors can be mistaken for new ones.
+enum OS_Result RECLOG_Format (struct RECLOG *log, const char *driver,
+                              uint32_t firstSector, uint32_t sectors)
+{
+    if (!log || !driver || sectors < RECLOG_MinSectors)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    init (log, driver, firstSector, sectors);
+
+    enum OS_Result r = mount (log);
+    if (r == OS_Result_OK)
+    {
+        log->head += log->dataSectors;
+    }
+    else if (r != OS_Result_NotInitialized)
+    {
+        return r;
+    }
+
+    const uint32_t CheckpointSequence = log->checkpointSequence;
+    const uint32_t Head = log->head;
+    const uint32_t NextId = log->nextId? log->nextId : 1;
+
+    init (log, driver, firstSector, sectors);
+
+    log->checkpointSequence = CheckpointSequence;
+    log->tail               = Head;
+    log->durableTail        = Head;
+    log->head               = Head;
+    log->nextId             = NextId;
+    log->releasedId         = NextId;
+
+    // Both, so a stale checkpoint cannot win the next mount.
+    for (uint32_t i = 0; i < RECLOG_CheckpointSectors; ++ i)
+    {
+        if ((r = checkpointWrite (log)) != OS_Result_OK)
+        {
+            return r;
+        }
+    }
+
+    return OS_Result_OK;
+}
+
+
+// Returns OS_Result_NotInitialized if the sectors hold no log.
+enum OS_Result RECLOG_Mount (struct RECLOG *log, const char *driver,
+                             uint32_t firstSector, uint32_t sectors)
+{
+    if (!log || !driver || sectors < RECLOG_MinSectors)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    init (log, driver, firstSector, sectors);
+    return mount (log);
+}
+
+
+// Queues a record for the next data sector, appending the current one first
+// if the record does not fit. Call RECLOG_Flush() to make it durable.
+enum OS_Result RECLOG_Append (struct RECLOG *log, uint16_t type,
+                              const void *data, uint32_t size, uint32_t *id)
+{
+    if (!log || (!data && size) || size > RECLOG_MaxRecordSize)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (log)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    if (log->pageUsed + recordSpan (size) > RECLOG_PageCapacity)
+    {
+        r = pageWrite (log, RECLOG_CompactReserve);
+    }
+
+    if (r == OS_Result_OK)
+    {
+        if (id)
+        {
+            *id = log->nextId;
+        }
+
+        pagePut (log, log->nextId ++, type, data, size);
+        ++ log->recordsAppended;
+    }
+
+    OS_MUTEX_Unlock (&log->lock);
+    return r;
+}
+
+
+enum OS_Result RECLOG_Flush (struct RECLOG *log)
+{
+    if (!log)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (log)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    r = pageWrite (log, RECLOG_CompactReserve);
+    OS_MUTEX_Unlock (&log->lock);
+
+    return r;
+}
+
+
+// Records with an id below the given one are no longer needed and can be
+// reclaimed by RECLOG_Compact().
+enum OS_Result RECLOG_Release (struct RECLOG *log, uint32_t id)
+{
+    if (!log)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (log)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    if (before (log->nextId, id))
+    {
+        r = OS_Result_InvalidParams;
+    }
+    else if (before (log->releasedId, id))
+    {
+        log->releasedId = id;
+    }
+    OS_MUTEX_Unlock (&log->lock);
+
+    return r;
+}
+
+
+// Reclaims oldest data sectors with no live records. While free sectors are
+// below RECLOG_COMPACT_LOW_WATER, live records from the oldest sectors are
+// packed together at the head so the space they leave can be reclaimed too.
+enum OS_Result RECLOG_Compact (struct RECLOG *log)
+{
+    if (!log)
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (log)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    // Oldest sectors whose live records are only in page yet; the tail
+    // moves past them once page is appended.
+    uint32_t repacked = 0;
+    uint32_t pageMark = log->pageUsed;
+    // Every sector in the ring is visited at most once; a ring full of live
+    // records would otherwise be rewritten forever.
+    uint32_t visits = log->head - log->tail;
+
+    while (visits -- && log->tail + repacked != log->head)
+    {
+        const uint32_t Sequence = log->tail + repacked;
+
+        if ((r = sectorRead (log, log->scan, dataIndex (log, Sequence)))
+                                                            != OS_Result_OK)
+        {
+            break;
+        }
+
+        const uint32_t Live = dataValid (log->scan, Sequence)?
+                                        liveBytes (log, log->scan) : 0;
+
+        if (Live && log->dataSectors - (log->head - Sequence)
+                                                >= RECLOG_COMPACT_LOW_WATER)
+        {
+            break;
+        }
+
+        if (Live && log->pageUsed + Live > RECLOG_PageCapacity)
+        {
+            if ((r = pageWrite (log, 0)) != OS_Result_OK)
+            {
+                break;
+            }
+
+            log->tail               += repacked;
+            log->sectorsReclaimed   += repacked;
+            repacked                = 0;
+            pageMark                = 0;
+
+            // Appending may also have written a checkpoint through scan.
+            if ((r = sectorRead (log, log->scan, dataIndex (log, Sequence)))
+                                                            != OS_Result_OK)
+            {
+                break;
+            }
+        }
+
+        uint32_t offset = RECLOG_SectorHeaderSize;
+        const struct RecordHeader *rec;
+
+        while (Live && (rec = recordAt (log->scan, offset)))
+        {
+            if (!before (rec->id, log->releasedId))
+            {
+                pagePut (log, rec->id, rec->type, &rec[1], rec->size);
+                ++ log->recordsCompacted;
+            }
+            offset += recordSpan (rec->size);
+        }
+
+        if (!Live && !repacked)
+        {
+            ++ log->tail;
+            ++ log->sectorsReclaimed;
+        }
+        else
+        {
+            ++ repacked;
+        }
+    }
+
+    if (repacked)
+    {
+        // Repacked records must be on the media before their old sectors
+        // are given up. If they cannot be, they are dropped from page.
+        const enum OS_Result Result = pageWrite (log, 0);
+        if (Result == OS_Result_OK)
+        {
+            log->tail               += repacked;
+            log->sectorsReclaimed   += repacked;
+        }
+        else
+        {
+            log->pageUsed = pageMark;
+            if (r == OS_Result_OK)
+            {
+                r = Result;
+            }
+        }
+    }
+
+    // Reclaimed sectors only need a checkpoint once free space runs low;
+    // until then the periodic one in pageWrite() covers them, instead of
+    // one extra sector write per compaction.
+    if (r == OS_Result_OK && log->tail != log->durableTail
+            && freeSectors (log) < RECLOG_COMPACT_LOW_WATER)
+    {
+        r = checkpointWrite (log);
+    }
+
+    OS_MUTEX_Unlock (&log->lock);
+    return r;
+}
+
+
+uint32_t RECLOG_FreeSectors (struct RECLOG *log)
+{
+    return log? freeSectors (log) : 0;
+}
+
+
+void RECLOG_CursorInit (struct RECLOG *log, struct RECLOG_Cursor *cursor)
+{
+    if (!log || !cursor)
+    {
+        return;
+    }
+
+    if (lock (log) != OS_Result_OK)
+    {
+        return;
+    }
+
+    cursor->sequence    = log->tail;
+    cursor->offset      = RECLOG_SectorHeaderSize;
+    cursor->loaded      = false;
+    OS_MUTEX_Unlock (&log->lock);
+}
+
+
+// Reads the next live record, oldest first. Only appended (not queued)
+// records are seen. Returns OS_Result_Empty past the last one.
+enum OS_Result RECLOG_ReadNext (struct RECLOG *log,
+                                struct RECLOG_Cursor *cursor,
+                                uint16_t *type, uint32_t *id, void *buf,
+                                uint32_t bufSize, uint32_t *size)
+{
+    if (!log || !cursor || (!buf && bufSize))
+    {
+        return OS_Result_InvalidParams;
+    }
+
+    enum OS_Result r;
+
+    if ((r = lock (log)) != OS_Result_OK)
+    {
+        return r;
+    }
+
+    r = OS_Result_Empty;
+
+    // Sectors reclaimed under the cursor are skipped.
+    if (before (cursor->sequence, log->tail))
+    {
+        cursor->sequence    = log->tail;
+        cursor->offset      = RECLOG_SectorHeaderSize;
+        cursor->loaded      = false;
+    }
+
+    while (cursor->sequence != log->head)
+    {
+        if (!cursor->loaded)
+        {
+            if ((r = sectorRead (log, cursor->page,
+                                 dataIndex (log, cursor->sequence)))
+                                                            != OS_Result_OK)
+            {
+                break;
+            }
+
+            r = OS_Result_Empty;
+
+            if (!dataValid (cursor->page, cursor->sequence))
+            {
+                ++ cursor->sequence;
+                continue;
+            }
+
+            cursor->loaded = true;
+            cursor->offset = RECLOG_SectorHeaderSize;
+        }
+
+        const struct RecordHeader *rec = recordAt (cursor->page,
+                                                   cursor->offset);
+        if (!rec)
+        {
+            ++ cursor->sequence;
+            cursor->loaded = false;
+            continue;
+        }
+
+        if (before (rec->id, log->releasedId))
+        {
+            cursor->offset += recordSpan (rec->size);
+            continue;
+        }
+
+        if (rec->size > bufSize)
+        {
+            r = OS_Result_InvalidBufferSize;
+            break;
+        }
+
+        memcpy (buf, &rec[1], rec->size);
+
+        if (type)
+        {
+            *type = rec->type;
+        }
+
+        if (id)
+        {
+            *id = rec->id;
+        }
+
+        if (size)
+        {
+            *size = rec->size;
+        }
+
+        cursor->offset += recordSpan (rec->size);
+        r = OS_Result_OK;
+        break;
+    }
+
+    OS_MUTEX_Unlock (&log->lock);
+    return r;
+}
+
+
+// Also appends queued records every period, bounding what a power loss can
+// take.
+OS_TaskRetVal RECLOG_CompactTask (OS_TaskParam arg)
+{
+    struct RECLOG *log = (struct RECLOG *) arg;
+
+    while (1)
+    {
+        OS_TaskDelay    (msToTicks (RECLOG_COMPACT_PERIOD_MS));
+        RECLOG_Flush    (log);
+        RECLOG_Compact  (log);
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - Log-structured record store on raw storage sectors.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "misc.h"
+#include "../os/mutex.h"
+#include <stdbool.h>
+
+
+// Append-only record log on a range of raw sectors, written through the
+// storage driver instead of a file system. Records are packed in RAM and
+// appended one whole sector at a time, so a record costs no FAT or
+// directory update and a power loss can only lose the sector being written.
+//
+// Layout: two checkpoint sectors (written alternately, the newest valid one
+// wins) followed by a ring of data sectors. Every data sector carries a
+// sequence number and every record a CRC. Mount starts at the last
+// checkpoint and scans forward only over the sectors appended after it.
+//
+// Records are identified by a growing id. Records released with
+// RECLOG_Release() are reclaimed by RECLOG_Compact(), which also repacks
+// live records from the oldest sectors when free space runs low. A record
+// repacked right before a power loss may be read twice after mount.
+
+
+// Data sectors appended between checkpoints; bounds the mount scan.
+#ifndef RECLOG_CHECKPOINT_INTERVAL
+    #define RECLOG_CHECKPOINT_INTERVAL      32
+#endif
+
+// RECLOG_Compact() repacks live records when free data sectors fall below
+// this value.
+#ifndef RECLOG_COMPACT_LOW_WATER
+    #define RECLOG_COMPACT_LOW_WATER        8
+#endif
+
+// RECLOG_CompactTask() period.
+#ifndef RECLOG_COMPACT_PERIOD_MS
+    #define RECLOG_COMPACT_PERIOD_MS        1000
+#endif
+
+#define RECLOG_SectorHeaderSize     16
+#define RECLOG_RecordHeaderSize     12
+#define RECLOG_MaxRecordSize        (STORAGE_SectorSize \
+                                        - RECLOG_SectorHeaderSize \
+                                        - RECLOG_RecordHeaderSize)
+// Checkpoint sectors plus the minimum ring.
+#define RECLOG_MinSectors           (2 + 4)
+
+
+struct RECLOG
+{
+    struct OS_MUTEX     lock;
+    // Storage driver task description, the same pointer it was started with.
+    const char          *driver;
+    uint32_t            firstSector;
+    uint32_t            dataSectors;
+    // Sequence numbers of the oldest data sector kept and of the next one to
+    // be appended. Data sector sequence n is stored at ring index
+    // n % dataSectors.
+    uint32_t            tail;
+    uint32_t            head;
+    // Tail as stored by the last checkpoint. Sectors between it and tail are
+    // not reused until a checkpoint makes the new tail durable.
+    uint32_t            durableTail;
+    uint32_t            nextId;
+    uint32_t            releasedId;
+    uint32_t            checkpointSequence;
+    uint32_t            sinceCheckpoint;
+    // Bytes of records waiting in page for the next append.
+    uint32_t            pageUsed;
+    uint32_t            page[STORAGE_SectorSize / 4]    ATTR_DataAlign32;
+    uint32_t            scan[STORAGE_SectorSize / 4]    ATTR_DataAlign32;
+    // FYI only
+    uint32_t            recordsAppended;
+    uint32_t            recordsCompacted;
+    uint32_t            recordsCorrupted;
+    uint32_t            sectorsWritten;
+    uint32_t            sectorsReclaimed;
+    uint32_t            checkpointsWritten;
+    uint32_t            mountScanned;
+};
+
+
+struct RECLOG_Cursor
+{
+    uint32_t            sequence;
+    uint32_t            offset;
+    bool                loaded;
+    uint32_t            page[STORAGE_SectorSize / 4]    ATTR_DataAlign32;
+};
+
+
+enum OS_Result  RECLOG_Format       (struct RECLOG *log, const char *driver,
+                                     uint32_t firstSector, uint32_t sectors);
+enum OS_Result  RECLOG_Mount        (struct RECLOG *log, const char *driver,
+                                     uint32_t firstSector, uint32_t sectors);
+enum OS_Result  RECLOG_Append       (struct RECLOG *log, uint16_t type,
+                                     const void *data, uint32_t size,
+                                     uint32_t *id);
+enum OS_Result  RECLOG_Flush        (struct RECLOG *log);
+enum OS_Result  RECLOG_Release      (struct RECLOG *log, uint32_t id);
+enum OS_Result  RECLOG_Compact      (struct RECLOG *log);
+uint32_t        RECLOG_FreeSectors  (struct RECLOG *log);
+void            RECLOG_CursorInit   (struct RECLOG *log,
+                                     struct RECLOG_Cursor *cursor);
+enum OS_Result  RECLOG_ReadNext     (struct RECLOG *log,
+                                     struct RECLOG_Cursor *cursor,
+                                     uint16_t *type, uint32_t *id, void *buf,
+                                     uint32_t bufSize, uint32_t *size);
+// Task function that runs RECLOG_Compact() periodically. arg: struct RECLOG.
+OS_TaskRetVal   RECLOG_CompactTask  (OS_TaskParam arg);
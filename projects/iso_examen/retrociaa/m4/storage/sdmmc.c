@@ -0,0 +1,450 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - SD/MMC card storage device (SDIF).
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "sdmmc.h"
+#include "../os/api.h"
+#include "../os/scheduler.h"
+#include <string.h>
+
+
+// SD_SWITCH_FUNC (CMD6) argument: switch function group 1 to high speed.
+#define SD_SWITCH_FUNC                  6
+#define SD_SwitchHighSpeedArg           0x80FFFFF1u
+#define SD_SwitchStatusSize             64
+
+// Same error set the LPCOpen SDMMC driver checks on every command.
+#define SDMMC_IntErrors     (MCI_INT_RESP_ERR | MCI_INT_RCRC | MCI_INT_DCRC \
+                             | MCI_INT_RTO | MCI_INT_DTO | MCI_INT_HTO \
+                             | MCI_INT_FRUN | MCI_INT_HLE | MCI_INT_SBE \
+                             | MCI_INT_EBE)
+
+
+// LPCOpen SDMMC driver and the SDIF interrupt work on a single card.
+static struct STORAGE_SDMMC *g_sdmmc;
+
+
+static OS_Ticks msToTicks (uint32_t ms)
+{
+    const OS_Ticks Ticks = ((OS_Ticks) ms * 1000) / OS_GetTickPeriod_us ();
+    return Ticks? Ticks : 1;
+}
+
+
+// LPCOpen SDMMC callback: arm the interrupt for the given status bits.
+static void eventSetup (void *bits)
+{
+    // Discards a completion left by a previous timed out wait.
+    SEMAPHORE_Acquire (&g_sdmmc->event);
+
+    NVIC_ClearPendingIRQ (SDIO_IRQn);
+    Chip_SDIF_SetIntMask (LPC_SDMMC, *(uint32_t *) bits);
+    NVIC_EnableIRQ (SDIO_IRQn);
+}
+
+
+// LPCOpen SDMMC callback: blocks the calling task until the interrupt armed
+// by eventSetup() fires. Returns the raw interrupt status.
+static uint32_t eventWait (void)
+{
+    uint32_t status = 0;
+
+    if (OS_TaskWaitForSignal (OS_TaskSignalType_SemaphoreAcquire,
+                              &g_sdmmc->event,
+                              msToTicks (STORAGE_SDMMC_TIMEOUT_MS))
+                                                            != OS_Result_OK)
+    {
+        NVIC_DisableIRQ (SDIO_IRQn);
+        status = MCI_INT_DTO;
+    }
+
+    status |= Chip_SDIF_GetIntStatus (LPC_SDMMC);
+    Chip_SDIF_ClrIntStatus (LPC_SDMMC, status);
+    Chip_SDIF_SetIntMask (LPC_SDMMC, 0);
+    return status;
+}
+
+
+// LPCOpen SDMMC callback.
+static void msDelay (uint32_t ms)
+{
+    OS_TaskDelay (msToTicks (ms));
+}
+
+
+// Bit field of a 128 bit card register stored the LPCOpen way (word 0 holds
+// bits 0 to 31).
+static uint32_t registerBits (const uint32_t *reg, uint32_t start,
+                              uint32_t end)
+{
+    uint32_t v = 0;
+    for (uint32_t bit = end + 1; bit-- > start; )
+    {
+        v = (v << 1) | ((reg[bit >> 5] >> (bit & 31)) & 1);
+    }
+    return v;
+}
+
+
+// Erase block size in sectors, from the CSD.
+static uint32_t eraseBlockSize (struct STORAGE_SDMMC *sd)
+{
+    const uint32_t *Csd = sd->card.card_info.csd;
+
+    if (sd->card.card_info.card_type & CARD_TYPE_SD)
+    {
+        // SECTOR_SIZE, in write blocks of 2^WRITE_BL_LEN bytes.
+        return (registerBits (Csd, 39, 45) + 1)
+                                    << (registerBits (Csd, 22, 25) - 9);
+    }
+
+    // ERASE_GRP_SIZE * ERASE_GRP_MULT
+    return (registerBits (Csd, 42, 46) + 1) * (registerBits (Csd, 37, 41) + 1);
+}
+
+
+// Switches an SD card to high speed mode (CMD6). Cards older than SD 1.10 do
+// not answer and keep running at default speed.
+static void switchHighSpeed (struct STORAGE_SDMMC *sd)
+{
+    if (!(sd->card.card_info.card_type & CARD_TYPE_SD))
+    {
+        return;
+    }
+
+    const uint8_t *SwitchStatus = (const uint8_t *) sd->bounce;
+    uint32_t waitBits           = MCI_INT_DATA_OVER | SDMMC_IntErrors;
+    uint32_t status             = MCI_INT_RTO;
+
+    Chip_SDIF_SetBlkSizeByteCnt (LPC_SDMMC, SD_SwitchStatusSize);
+    Chip_SDIF_DmaSetup (LPC_SDMMC, &sd->card.sdif_dev, (uint32_t) sd->bounce,
+                        SD_SwitchStatusSize);
+    Chip_SDIF_ClrIntStatus (LPC_SDMMC, 0xFFFFFFFF);
+    eventSetup (&waitBits);
+
+    if (!Chip_SDIF_SendCmd (LPC_SDMMC, SD_SWITCH_FUNC | MCI_CMD_DAT_EXP
+                                        | MCI_CMD_PRV_DAT_WAIT
+                                        | MCI_CMD_RESP_EXP | MCI_CMD_START,
+                            SD_SwitchHighSpeedArg))
+    {
+        status = eventWait ();
+    }
+    else
+    {
+        NVIC_DisableIRQ (SDIO_IRQn);
+    }
+
+    Chip_SDIF_SetBlkSize (LPC_SDMMC, STORAGE_SectorSize);
+
+    // Status is big endian; bits 379:376 (byte 16) hold the function
+    // selected in group 1.
+    if (!(status & SDMMC_IntErrors) && (SwitchStatus[16] & 0x0F) == 1)
+    {
+        sd->card.card_info.speed = STORAGE_SDMMC_HighSpeedClock;
+    }
+}
+
+
+// Acquires the card on first use or after a power cycle or card change.
+static enum STORAGE_Result cardReady (struct STORAGE_SDMMC *sd)
+{
+#if STORAGE_SDMMC_CARD_DETECT
+    if (Chip_SDIF_CardNDetect (LPC_SDMMC))
+    {
+        sd->status |= STORAGE_Status_No_Disk
+                        | STORAGE_Status_Not_Initialized;
+        return STORAGE_Result_NotReady;
+    }
+
+    sd->status &= ~STORAGE_Status_No_Disk;
+#endif
+
+    if (!(sd->status & STORAGE_Status_Not_Initialized))
+    {
+        return STORAGE_Result_Ok;
+    }
+
+    memset (&sd->card.card_info, 0, sizeof(sd->card.card_info));
+    sd->card.card_info.evsetup_cb   = eventSetup;
+    sd->card.card_info.waitfunc_cb  = eventWait;
+    sd->card.card_info.msdelay_func = msDelay;
+
+    // Also selects the 4 bit bus (SDIO_BUS_WIDTH) and 512 byte blocks.
+    if (!Chip_SDMMC_Acquire (LPC_SDMMC, &sd->card))
+    {
+        ++ sd->errors;
+        return STORAGE_Result_NotReady;
+    }
+
+    switchHighSpeed (sd);
+
+    sd->status &= ~STORAGE_Status_Not_Initialized;
+
+#if STORAGE_SDMMC_CARD_DETECT
+    if (Chip_SDIF_CardWpOn (LPC_SDMMC))
+    {
+        sd->status |= STORAGE_Status_Write_Protected;
+    }
+    else
+    {
+        sd->status &= ~STORAGE_Status_Write_Protected;
+    }
+#endif
+
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result sdmmcRead (void *handler, uint8_t *buf,
+                                      uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SDMMC *sd = (struct STORAGE_SDMMC *) handler;
+
+    if (!buf || !count)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    const enum STORAGE_Result Result = cardReady (sd);
+    if (Result != STORAGE_Result_Ok)
+    {
+        return Result;
+    }
+
+    while (count)
+    {
+        const bool Bounce = ((uint32_t) buf & 0b11);
+        const uint32_t Sectors = Bounce? 1
+                                : (count < STORAGE_SDMMC_MaxSectors)
+                                    ? count : STORAGE_SDMMC_MaxSectors;
+        const int32_t Size = Sectors * STORAGE_SectorSize;
+
+        if (Chip_SDMMC_ReadBlocks (LPC_SDMMC, Bounce? sd->bounce : (void *) buf,
+                                   sector, Sectors) != Size)
+        {
+            ++ sd->errors;
+            return STORAGE_Result_ReadWriteError;
+        }
+
+        if (Bounce)
+        {
+            memcpy (buf, sd->bounce, STORAGE_SectorSize);
+            ++ sd->sectorsBounced;
+        }
+
+        sd->sectorsRead += Sectors;
+        buf     += Size;
+        sector  += Sectors;
+        count   -= Sectors;
+    }
+
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result sdmmcWrite (void *handler, const uint8_t *buf,
+                                       uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SDMMC *sd = (struct STORAGE_SDMMC *) handler;
+
+    if (!buf || !count)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    const enum STORAGE_Result Result = cardReady (sd);
+    if (Result != STORAGE_Result_Ok)
+    {
+        return Result;
+    }
+
+    if (sd->status & STORAGE_Status_Write_Protected)
+    {
+        return STORAGE_Result_WriteProtected;
+    }
+
+    while (count)
+    {
+        const bool Bounce = ((uint32_t) buf & 0b11);
+        const uint32_t Sectors = Bounce? 1
+                                : (count < STORAGE_SDMMC_MaxSectors)
+                                    ? count : STORAGE_SDMMC_MaxSectors;
+        const int32_t Size = Sectors * STORAGE_SectorSize;
+
+        if (Bounce)
+        {
+            memcpy (sd->bounce, buf, STORAGE_SectorSize);
+            ++ sd->sectorsBounced;
+        }
+
+        if (Chip_SDMMC_WriteBlocks (LPC_SDMMC,
+                                    Bounce? sd->bounce : (void *) buf,
+                                    sector, Sectors) != Size)
+        {
+            ++ sd->errors;
+            return STORAGE_Result_ReadWriteError;
+        }
+
+        sd->sectorsWritten += Sectors;
+        buf     += Size;
+        sector  += Sectors;
+        count   -= Sectors;
+    }
+
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result sdmmcIoCtl (void *handler, uint8_t cmd, void *buf)
+{
+    struct STORAGE_SDMMC *sd = (struct STORAGE_SDMMC *) handler;
+
+    if (cmd == CTRL_POWER)
+    {
+        uint8_t *const Sub = (uint8_t *) buf;
+        if (!Sub)
+        {
+            return STORAGE_Result_InvalidParameter;
+        }
+
+        switch (Sub[0])
+        {
+            case CTRL_POWER_OFF:
+                Chip_SDIF_PowerOff (LPC_SDMMC);
+                sd->status |= STORAGE_Status_Not_Initialized;
+                return STORAGE_Result_Ok;
+
+            case CTRL_POWER_ON:
+                Chip_SDIF_PowerOn (LPC_SDMMC);
+                return STORAGE_Result_Ok;
+
+            case CTRL_POWER_STATUS:
+                Sub[1] = LPC_SDMMC->PWREN & 1;
+                return STORAGE_Result_Ok;
+
+            default:
+                return STORAGE_Result_InvalidParameter;
+        }
+    }
+
+    const enum STORAGE_Result Result = cardReady (sd);
+    if (Result != STORAGE_Result_Ok)
+    {
+        return Result;
+    }
+
+    switch (cmd)
+    {
+        case CTRL_SYNC:
+            // Writes return with the card back in transfer state; nothing is
+            // left pending on the host side.
+            return (Chip_SDMMC_GetState (LPC_SDMMC) == SDMMC_TRAN_ST)
+                        ? STORAGE_Result_Ok : STORAGE_Result_ReadWriteError;
+
+        case GET_SECTOR_COUNT:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint32_t *) buf = Chip_SDMMC_GetDeviceBlocks (LPC_SDMMC);
+            return STORAGE_Result_Ok;
+
+        case GET_SECTOR_SIZE:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint16_t *) buf = STORAGE_SectorSize;
+            return STORAGE_Result_Ok;
+
+        case GET_BLOCK_SIZE:
+            if (!buf)
+            {
+                break;
+            }
+            *(uint32_t *) buf = eraseBlockSize (sd);
+            return STORAGE_Result_Ok;
+
+        default:
+            break;
+    }
+
+    return STORAGE_Result_InvalidParameter;
+}
+
+
+// Pins must be configured beforehand (ie. Board_SDMMC_Init()). The card is
+// acquired on first access, from the storage driver task.
+bool STORAGE_SDMMC_Init (struct STORAGE_SDMMC *sd,
+                         struct STORAGE_Device *device)
+{
+    if (!sd || !device)
+    {
+        return false;
+    }
+
+    memset (sd, 0, sizeof(struct STORAGE_SDMMC));
+
+    SEMAPHORE_Init (&sd->event, 1, 0);
+    sd->status = STORAGE_Status_Not_Initialized;
+
+    g_sdmmc = sd;
+
+    NVIC_DisableIRQ     (SDIO_IRQn);
+    NVIC_SetPriority    (SDIO_IRQn, STORAGE_SDMMC_IRQ_PRIORITY);
+
+    Chip_SDIF_Init      (LPC_SDMMC);
+    Chip_SDIF_PowerOn   (LPC_SDMMC);
+
+    device->handler = sd;
+    device->read    = sdmmcRead;
+    device->write   = sdmmcWrite;
+    device->ioctl   = sdmmcIoCtl;
+
+    return true;
+}
+
+
+STORAGE_Status STORAGE_SDMMC_Status (struct STORAGE_SDMMC *sd)
+{
+    return sd? sd->status : STORAGE_Status_Not_Initialized;
+}
+
+
+void SDIO_IRQHandler (void)
+{
+    // Status is read and cleared by eventWait() on the task side.
+    NVIC_DisableIRQ (SDIO_IRQn);
+    SEMAPHORE_Release (&g_sdmmc->event);
+    OS_SchedulerCallPending ();
+}
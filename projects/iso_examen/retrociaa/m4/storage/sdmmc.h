@@ -0,0 +1,91 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - SD/MMC card storage device (SDIF).
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "misc.h"
+#include "../base/semaphore.h"
+#include "chip.h"
+#include <stdbool.h>
+
+
+// SD/MMC card on the SDIF host controller: 4 bit bus, SD high speed mode
+// when the card supports it and data moved by the SDIF internal DMA
+// (IDMAC) descriptor chain. Functions block the calling task, not the CPU,
+// while waiting for the controller; they are meant to be called from the
+// storage driver task through a STORAGE_Device.
+
+
+// Card detect pin (SD_CD) is not routed on every board.
+#ifndef STORAGE_SDMMC_CARD_DETECT
+    #define STORAGE_SDMMC_CARD_DETECT       0
+#endif
+
+// Below OS ticks and syscalls, above the scheduler.
+#ifndef STORAGE_SDMMC_IRQ_PRIORITY
+    #define STORAGE_SDMMC_IRQ_PRIORITY      2
+#endif
+
+// Time to wait for a single command or data transfer to complete.
+#ifndef STORAGE_SDMMC_TIMEOUT_MS
+    #define STORAGE_SDMMC_TIMEOUT_MS        1000
+#endif
+
+// SD high speed mode (CMD6 switch). Actual SDIO clock is the base clock
+// divided down to the nearest rate below this value.
+#define STORAGE_SDMMC_HighSpeedClock        50000000
+
+// Sectors per command, limited by the sdif_device descriptor chain.
+#define STORAGE_SDMMC_MaxSectors            (0x10000 / STORAGE_SectorSize)
+
+
+struct STORAGE_SDMMC
+{
+    mci_card_struct     card;
+    struct SEMAPHORE    event;
+    STORAGE_Status      status;
+    // Buffers passed to the IDMAC must be word aligned; unaligned requests
+    // are transferred one sector at a time through this buffer.
+    uint32_t            bounce[STORAGE_SectorSize / 4];
+    // FYI only
+    uint32_t            sectorsRead;
+    uint32_t            sectorsWritten;
+    uint32_t            sectorsBounced;
+    uint32_t            errors;
+};
+
+
+bool            STORAGE_SDMMC_Init      (struct STORAGE_SDMMC *sd,
+                                         struct STORAGE_Device *device);
+STORAGE_Status  STORAGE_SDMMC_Status    (struct STORAGE_SDMMC *sd);
@@ -0,0 +1,269 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - SD/MMC card storage device (SPI mode, SSP1).
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "sdspi.h"
+#include "../os/api.h"
+#include "../os/scheduler.h"
+#include "../base/systick.h"
+#include "diskio.h"
+#include <string.h>
+
+
+// FatFs MMC driver physical drive; it supports a single one.
+#define SDSPI_Drive         0
+
+
+// The FatFs MMC driver and the DMA interrupt work on a single card.
+static struct STORAGE_SDSPI *g_sdspi;
+
+#ifndef RETROS_CUSTOM_SYSTICK
+static SYSTICK_HookFunc     g_tickHookNext;
+static SYSTICK_Ticks        g_timerElapsed_us;
+#endif
+
+
+static OS_Ticks msToTicks (uint32_t ms)
+{
+    const OS_Ticks Ticks = ((OS_Ticks) ms * 1000) / OS_GetTickPeriod_us ();
+    return Ticks? Ticks : 1;
+}
+
+
+#ifndef RETROS_CUSTOM_SYSTICK
+// Chained to the OS tick hook: disk_timerproc() runs the FatFs MMC driver
+// timeouts and samples the card detect switch.
+static void tickHook (SYSTICK_Ticks ticks)
+{
+    g_timerElapsed_us += SYSTICK_GetPeriod_us ();
+    if (g_timerElapsed_us >= STORAGE_SDSPI_TimerPeriod_us)
+    {
+        g_timerElapsed_us -= STORAGE_SDSPI_TimerPeriod_us;
+        disk_timerproc ();
+    }
+
+    if (g_tickHookNext)
+    {
+        g_tickHookNext (ticks);
+    }
+}
+#endif
+
+
+// Called from the storage driver task, after the OS installed its own tick
+// hook.
+static void tickHookInstall (struct STORAGE_SDSPI *sd)
+{
+#ifndef RETROS_CUSTOM_SYSTICK
+    if (sd->tickHooked)
+    {
+        return;
+    }
+
+    const uint32_t Primask = __get_PRIMASK ();
+    __disable_irq ();
+    g_tickHookNext = SYSTICK_SetHook (tickHook);
+    __set_PRIMASK (Primask);
+#endif
+
+    sd->tickHooked = true;
+}
+
+
+// FatFs MMC driver hook: sleeps the calling task while a data block is
+// moved by the GPDMA. The driver checks the transfer state and its own
+// timeout after each call, so waking up early is harmless.
+void disk_sleep (void)
+{
+    OS_TaskWaitForSignal (OS_TaskSignalType_SemaphoreAcquire,
+                          &g_sdspi->event,
+                          msToTicks (STORAGE_SDSPI_TimerPeriod_us / 1000));
+}
+
+
+// FatFs MMC driver hook, called by disk_dmaproc() from the DMA interrupt.
+void disk_wakeup (void)
+{
+    SEMAPHORE_Release (&g_sdspi->event);
+    OS_SchedulerCallPending ();
+}
+
+
+// FatFs MMC driver hook: called while polling a busy card.
+void disk_yield (void)
+{
+    OS_TaskYield ();
+}
+
+
+static enum STORAGE_Result cardReady (struct STORAGE_SDSPI *sd)
+{
+    tickHookInstall (sd);
+
+    const DSTATUS Status = disk_status (SDSPI_Drive);
+
+    if (!(Status & STA_NOINIT))
+    {
+        return STORAGE_Result_Ok;
+    }
+
+    if ((Status & STA_NODISK)
+            || (disk_initialize (SDSPI_Drive) & STA_NOINIT))
+    {
+        ++ sd->errors;
+        return STORAGE_Result_NotReady;
+    }
+
+    return STORAGE_Result_Ok;
+}
+
+
+// DRESULT values match enum STORAGE_Result.
+static enum STORAGE_Result sdspiRead (void *handler, uint8_t *buf,
+                                      uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SDSPI *sd = (struct STORAGE_SDSPI *) handler;
+
+    if (!buf || !count)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    enum STORAGE_Result result = cardReady (sd);
+    if (result != STORAGE_Result_Ok)
+    {
+        return result;
+    }
+
+    result = (enum STORAGE_Result) disk_read (SDSPI_Drive, buf, sector,
+                                              count);
+    if (result != STORAGE_Result_Ok)
+    {
+        ++ sd->errors;
+        return result;
+    }
+
+    sd->sectorsRead += count;
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result sdspiWrite (void *handler, const uint8_t *buf,
+                                       uint32_t sector, uint32_t count)
+{
+    struct STORAGE_SDSPI *sd = (struct STORAGE_SDSPI *) handler;
+
+    if (!buf || !count)
+    {
+        return STORAGE_Result_InvalidParameter;
+    }
+
+    enum STORAGE_Result result = cardReady (sd);
+    if (result != STORAGE_Result_Ok)
+    {
+        return result;
+    }
+
+    result = (enum STORAGE_Result) disk_write (SDSPI_Drive, buf, sector,
+                                               count);
+    if (result != STORAGE_Result_Ok)
+    {
+        ++ sd->errors;
+        return result;
+    }
+
+    sd->sectorsWritten += count;
+    return STORAGE_Result_Ok;
+}
+
+
+static enum STORAGE_Result sdspiIoCtl (void *handler, uint8_t cmd, void *buf)
+{
+    struct STORAGE_SDSPI *sd = (struct STORAGE_SDSPI *) handler;
+
+    // Socket power control works on an uninitialized card.
+    if (cmd != CTRL_POWER)
+    {
+        const enum STORAGE_Result Result = cardReady (sd);
+        if (Result != STORAGE_Result_Ok)
+        {
+            return Result;
+        }
+    }
+
+    return (enum STORAGE_Result) disk_ioctl (SDSPI_Drive, cmd, buf);
+}
+
+
+// SSP1 pins must be configured beforehand (ie. Board_SSP_Init()). The card
+// is initialized on first access, from the storage driver task.
+bool STORAGE_SDSPI_Init (struct STORAGE_SDSPI *sd,
+                         struct STORAGE_Device *device)
+{
+    if (!sd || !device)
+    {
+        return false;
+    }
+
+    memset (sd, 0, sizeof(struct STORAGE_SDSPI));
+
+    SEMAPHORE_Init (&sd->event, 1, 0);
+
+    g_sdspi = sd;
+
+    // mmc.c enables the interrupt once it gets its GPDMA channels.
+    NVIC_SetPriority    (DMA_IRQn, STORAGE_SDSPI_IRQ_PRIORITY);
+
+    Chip_SSP_Init       (LPC_SSP1);
+    Chip_SSP_Enable     (LPC_SSP1);
+
+    device->handler = sd;
+    device->read    = sdspiRead;
+    device->write   = sdspiWrite;
+    device->ioctl   = sdspiIoCtl;
+
+    return true;
+}
+
+
+STORAGE_Status STORAGE_SDSPI_Status (struct STORAGE_SDSPI *sd)
+{
+    return sd? disk_status (SDSPI_Drive) : STORAGE_Status_Not_Initialized;
+}
+
+
+void DMA_IRQHandler (void)
+{
+    // Only acts on the SSP1 channels, see disk_dmaproc().
+    disk_dmaproc ();
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright 2019 Santiago Germino (royconejo@gmail.com)
+
+    Contibutors:
+        {name/email}, {feature/bugfix}.
+
+    RETRO-CIAA™ Library - SD/MMC card storage device (SPI mode, SSP1).
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+
+    1.  Redistributions of source code must retain the above copyright notice,
+        this list of conditions and the following disclaimer.
+
+    2.  Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+
+    3.  Neither the name of the copyright holder nor the names of its
+        contributors may be used to endorse or promote products derived from
+        this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+    AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+    IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+    ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+    LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+    CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+    SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+    CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+    ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+    POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "misc.h"
+#include "../base/semaphore.h"
+#include <stdbool.h>
+
+
+// SD/MMC card in SPI mode on SSP1, driven by the FatFs MMC driver of the
+// modules/lpc4337_m4/fatfs_ssp module, which the project must list. Data
+// blocks are moved by GPDMA; the calling task sleeps on a semaphore released
+// from the DMA interrupt meanwhile and yields while the card is busy. Meant
+// to be called from the storage driver task through a STORAGE_Device, like
+// STORAGE_SDMMC.
+//
+// This file defines DMA_IRQHandler. The disk_timerproc() 10 ms tick is
+// chained to the OS tick hook on first access; builds with
+// RETROS_CUSTOM_SYSTICK call disk_timerproc() themselves. The GPDMA must be
+// initialized beforehand (Chip_GPDMA_Init()), see dma_init() in mmc.c.
+
+
+// Below OS ticks and syscalls, above the scheduler.
+#ifndef STORAGE_SDSPI_IRQ_PRIORITY
+    #define STORAGE_SDSPI_IRQ_PRIORITY      2
+#endif
+
+// disk_timerproc() period required by the FatFs MMC driver.
+#define STORAGE_SDSPI_TimerPeriod_us        10000
+
+
+struct STORAGE_SDSPI
+{
+    struct SEMAPHORE    event;
+    bool                tickHooked;
+    // FYI only
+    uint32_t            sectorsRead;
+    uint32_t            sectorsWritten;
+    uint32_t            errors;
+};
+
+
+bool            STORAGE_SDSPI_Init      (struct STORAGE_SDSPI *sd,
+                                         struct STORAGE_Device *device);
+STORAGE_Status  STORAGE_SDSPI_Status    (struct STORAGE_SDSPI *sd);
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+
+# Copyright 2019 Santiago Germino (royconejo@gmail.com)
+#
+# Contibutors:
+#     {name/email}, {feature/bugfix}.
+#
+# RETRO-CIAA™ Library - Binary log decoder (host side).
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1.  Redistributions of source code must retain the above copyright notice,
+#     this list of conditions and the following disclaimer.
+#
+# 2.  Redistributions in binary form must reproduce the above copyright
+#     notice, this list of conditions and the following disclaimer in the
+#     documentation and/or other materials provided with the distribution.
+#
+# 3.  Neither the name of the copyright holder nor the names of its
+#     contributors may be used to endorse or promote products derived from
+#     this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+# Decodes BINLOG_Put() records (see m4/base/binlog.c) read from a serial port
+# or a capture file, using the message texts stored in the firmware ELF file.
+#
+#   binlog_decode.py firmware.elf /dev/ttyUSB1
+#   binlog_decode.py firmware.elf capture.bin
+#   cat /dev/ttyUSB1 | binlog_decode.py firmware.elf -
+#
+# The serial port must be configured beforehand (ie stty -F /dev/ttyUSB1 9600
+# raw).
+
+import re
+import struct
+import sys
+
+
+SECTION_NAME    = b'.binlog'
+
+TYPE_UINT32     = 0
+TYPE_INT32      = 1
+TYPE_FLOAT      = 2
+TYPE_POINTER    = 3
+TYPE_STRING     = 4
+
+DEFAULT_CONV    = { TYPE_UINT32: 'u', TYPE_INT32: 'd', TYPE_FLOAT: 'f',
+                    TYPE_POINTER: 'p', TYPE_STRING: 's' }
+
+PLACEHOLDER     = re.compile(r'%(?:([1-9])|\{([1-9])(?::([0-]*)(\d*)'
+                             r'(?:\.(\d+))?(?:([udxXpfs])|q(\d*))?)?\}|(%))')
+
+
+def readSection (elfPath, name):
+    with open(elfPath, 'rb') as f:
+        elf = f.read()
+
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        raise ValueError('not an ELF32 file')
+
+    endian = '<' if elf[5] == 1 else '>'
+    shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+
+    def header (i):
+        return struct.unpack_from(endian + 'IIIIIIIIII', elf,
+                                  shoff + i * shentsize)
+
+    strtab = header(shstrndx)
+    for i in range(shnum):
+        sh = header(i)
+        nameOff = strtab[4] + sh[0]
+        secName = elf[nameOff:elf.index(b'\0', nameOff)]
+        if secName == name:
+            # sh_addr, contents
+            return sh[3], elf[sh[4]:sh[4] + sh[5]]
+
+    raise ValueError('section {} not found'.format(name.decode()))
+
+
+def cobsDecode (frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if not code or i + code > len(frame) + 1:
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def getVarint (data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def parseRecord (data):
+    msgId, pos = getVarint(data, 0)
+    count = data[pos]
+    pos += 1
+    types = []
+    for i in range(count):
+        types.append((data[pos + (i >> 1)] >> ((i & 1) * 4)) & 0x0F)
+    pos += (count + 1) >> 1
+
+    args = []
+    for t in types:
+        if t == TYPE_UINT32:
+            v, pos = getVarint(data, pos)
+        elif t == TYPE_INT32:
+            z, pos = getVarint(data, pos)
+            v = (z >> 1) ^ -(z & 1)
+        elif t == TYPE_FLOAT:
+            v, = struct.unpack_from('<f', data, pos)
+            pos += 4
+        elif t == TYPE_POINTER:
+            v, = struct.unpack_from('<I', data, pos)
+            pos += 4
+        elif t == TYPE_STRING:
+            n, pos = getVarint(data, pos)
+            v = data[pos:pos + n].decode('utf-8', 'replace')
+            pos += n
+        else:
+            raise ValueError('unknown argument type {}'.format(t))
+        args.append((t, v))
+
+    return msgId, args
+
+
+# Same placeholder syntax as UART_PutMessageArgs() (see m4/base/uart_util.c).
+def formatArg (t, v, flags, width, precision, conv, fracBits):
+    if not conv or (conv == 's' and t != TYPE_STRING):
+        conv = DEFAULT_CONV[t]
+
+    if conv == 's':
+        text = v if precision is None else v[:precision]
+    elif t == TYPE_STRING:
+        text = v
+    elif conv == 'p':
+        text = '0x{:08x}'.format(int(v) & 0xFFFFFFFF)
+    elif conv == 'f':
+        text = '{:.{}f}'.format(float(v), 6 if precision is None
+                                             else min(precision, 7))
+    elif conv == 'q':
+        raw = int(v) - (1 << 32) if int(v) >= (1 << 31) else int(v)
+        text = '{:.{}f}'.format(raw / float(1 << (fracBits or 16)),
+                                3 if precision is None else min(precision, 9))
+    else:
+        n = int(v)
+        if conv == 'd':
+            n = n - (1 << 32) if n >= (1 << 31) else n
+        else:
+            n &= 0xFFFFFFFF
+        digits = {'x': '{:x}', 'X': '{:X}'}.get(conv, '{:d}').format(abs(n))
+        digits = digits.zfill(precision or 1)
+        text = ('-' if n < 0 else '') + digits
+
+    if len(text) >= width:
+        return text
+    if '-' in flags:
+        return text.ljust(width)
+    if '0' in flags and conv != 's':
+        sign = text[0] if text[0] == '-' else ''
+        return sign + text[len(sign):].rjust(width - len(sign), '0')
+    return text.rjust(width)
+
+
+def formatMessage (text, args):
+    def replace (m):
+        if m.group(8):
+            return '%'
+        index = int(m.group(1) or m.group(2)) - 1
+        if index >= len(args):
+            return ''
+        t, v = args[index]
+        return formatArg(t, v, m.group(3) or '', int(m.group(4) or 0),
+                         int(m.group(5)) if m.group(5) else None,
+                         m.group(6) or ('q' if m.group(7) is not None
+                                        else None),
+                         int(m.group(7) or 0))
+    return PLACEHOLDER.sub(replace, text)
+
+
+def decodeStream (stream, base, texts, out):
+    frame = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        if chunk[0]:
+            frame += chunk
+            continue
+
+        record = cobsDecode(bytes(frame))
+        frame = bytearray()
+        if not record:
+            continue
+
+        try:
+            msgId, args = parseRecord(record)
+            offset = msgId - base
+            if offset < 0 or offset >= len(texts):
+                raise ValueError('unknown message id {}'.format(msgId))
+            text = texts[offset:texts.index(b'\0', offset)].decode('utf-8')
+            out.write(formatMessage(text, args))
+        except (ValueError, IndexError, struct.error) as e:
+            out.write('[binlog: invalid record ({})]\n'.format(e))
+        out.flush()
+
+
+def main ():
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: {} firmware.elf <port|file|->\n'
+                         .format(sys.argv[0]))
+        return 1
+
+    base, texts = readSection(sys.argv[1], SECTION_NAME)
+
+    if sys.argv[2] == '-':
+        decodeStream(sys.stdin.buffer, base, texts, sys.stdout)
+    else:
+        with open(sys.argv[2], 'rb', buffering=0) as stream:
+            decodeStream(stream, base, texts, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())